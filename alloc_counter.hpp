@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// ------------------ Allocation Counter ------------------
+// Replaces the global operator new/delete to count heap allocations, so a
+// frame that allocates in the steady state shows up in the profiler.
+// Replacement allocation functions may only be defined once per program:
+// include this header from exactly one translation unit (the one with main).
+
+namespace alloc_counter {
+    inline std::atomic<unsigned long long>& counter() {
+        static std::atomic<unsigned long long> allocations{0};
+        return allocations;
+    }
+
+    inline unsigned long long allocations() {
+        return counter().load(std::memory_order_relaxed);
+    }
+}
+
+void* operator new(std::size_t size) {
+    alloc_counter::counter().fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    alloc_counter::counter().fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return ::operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
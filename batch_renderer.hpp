@@ -0,0 +1,202 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+// ------------------ Glyph Runs ------------------
+// A string laid out once into textured quads, exactly the way sf::Text lays
+// it out, in coordinates relative to the text's position. Cached runs are
+// copied into the batch each frame instead of drawing an sf::Text.
+struct GlyphRun {
+    std::vector<sf::Vertex> vertices;
+    unsigned int characterSize = 0;
+    sf::FloatRect bounds;
+};
+
+// Decodes the UTF-8 sequence starting at text[i] and advances i past it;
+// malformed bytes come out as '?'
+inline sf::Uint32 nextCodepoint(const std::string& text, size_t& i) {
+    unsigned char lead = text[i++];
+    if (lead < 0x80) return lead;
+    int extra = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : -1;
+    if (extra < 0) return U'?';
+    sf::Uint32 codepoint = lead & (0x3F >> extra);
+    for (int k = 0; k < extra; k++) {
+        if (i >= text.size() || (text[i] & 0xC0) != 0x80) return U'?';
+        codepoint = (codepoint << 6) | (text[i++] & 0x3F);
+    }
+    return codepoint;
+}
+
+// Reuses run.vertices' capacity, so re-laying out a run no longer than before does not allocate
+inline void layoutGlyphRun(GlyphRun& run, const sf::Font& font, const std::string& utf8,
+                           unsigned int characterSize, const sf::Color& color) {
+    run.vertices.clear();
+    run.characterSize = characterSize;
+
+    float whitespaceWidth = font.getGlyph(U' ', characterSize, false).advance;
+    float lineSpacing = font.getLineSpacing(characterSize);
+    float x = 0;
+    float y = float(characterSize);     // sf::Text puts the first baseline one character size down
+    float minX = float(characterSize), minY = float(characterSize), maxX = 0, maxY = 0;
+    sf::Uint32 previous = 0;
+
+    for (size_t i = 0; i < utf8.size();) {
+        sf::Uint32 current = nextCodepoint(utf8, i);
+        if (current == U'\r') continue;
+
+        x += font.getKerning(previous, current, characterSize);
+        previous = current;
+
+        if (current == U' ' || current == U'\t' || current == U'\n') {
+            minX = std::min(minX, x);
+            minY = std::min(minY, y);
+            if (current == U' ') x += whitespaceWidth;
+            else if (current == U'\t') x += whitespaceWidth * 4;
+            else {
+                y += lineSpacing;
+                x = 0;
+            }
+            maxX = std::max(maxX, x);
+            maxY = std::max(maxY, y);
+            continue;
+        }
+
+        const sf::Glyph& glyph = font.getGlyph(current, characterSize, false);
+        float padding = 1;
+        float left = glyph.bounds.left - padding;
+        float top = glyph.bounds.top - padding;
+        float right = glyph.bounds.left + glyph.bounds.width + padding;
+        float bottom = glyph.bounds.top + glyph.bounds.height + padding;
+        float u1 = glyph.textureRect.left - padding;
+        float v1 = glyph.textureRect.top - padding;
+        float u2 = glyph.textureRect.left + glyph.textureRect.width + padding;
+        float v2 = glyph.textureRect.top + glyph.textureRect.height + padding;
+
+        run.vertices.push_back(sf::Vertex(sf::Vector2f(x + left, y + top), color, sf::Vector2f(u1, v1)));
+        run.vertices.push_back(sf::Vertex(sf::Vector2f(x + right, y + top), color, sf::Vector2f(u2, v1)));
+        run.vertices.push_back(sf::Vertex(sf::Vector2f(x + left, y + bottom), color, sf::Vector2f(u1, v2)));
+        run.vertices.push_back(sf::Vertex(sf::Vector2f(x + left, y + bottom), color, sf::Vector2f(u1, v2)));
+        run.vertices.push_back(sf::Vertex(sf::Vector2f(x + right, y + top), color, sf::Vector2f(u2, v1)));
+        run.vertices.push_back(sf::Vertex(sf::Vector2f(x + right, y + bottom), color, sf::Vector2f(u2, v2)));
+
+        minX = std::min(minX, x + glyph.bounds.left);
+        maxX = std::max(maxX, x + glyph.bounds.left + glyph.bounds.width);
+        minY = std::min(minY, y + glyph.bounds.top);
+        maxY = std::max(maxY, y + glyph.bounds.top + glyph.bounds.height);
+        x += glyph.advance;
+    }
+
+    if (maxX < minX) run.bounds = sf::FloatRect();
+    else run.bounds = sf::FloatRect(minX, minY, maxX - minX, maxY - minY);
+}
+
+// ------------------ BatchRenderer ------------------
+// Collects untextured geometry (rectangles, outlines, circles) into one vertex
+// array and glyph quads into one vertex array per character size, since the
+// font keeps a separate atlas texture per size. flush() issues one draw for
+// the shapes plus one per character size in use, so a full screen of task
+// cards costs a handful of draw calls. Painter's order holds within each
+// layer; text always lands on top of the shapes of the same flush, so
+// anything that must cover text (popups, overlays) goes in a later flush.
+class BatchRenderer {
+private:
+    static const int CIRCLE_POINTS = 30;        // same as sf::CircleShape's default
+
+    const sf::Font* font = nullptr;
+    sf::VertexArray shapes;
+    std::map<unsigned int, sf::VertexArray> text;
+    sf::Vector2f circlePoints[CIRCLE_POINTS];   // unit circle, first point at the top like sf::CircleShape
+    unsigned int drawCalls = 0;
+
+    void quad(float left, float top, float right, float bottom, const sf::Color& color) {
+        shapes.append(sf::Vertex(sf::Vector2f(left, top), color));
+        shapes.append(sf::Vertex(sf::Vector2f(right, top), color));
+        shapes.append(sf::Vertex(sf::Vector2f(left, bottom), color));
+        shapes.append(sf::Vertex(sf::Vector2f(left, bottom), color));
+        shapes.append(sf::Vertex(sf::Vector2f(right, top), color));
+        shapes.append(sf::Vertex(sf::Vector2f(right, bottom), color));
+    }
+
+public:
+    BatchRenderer() : shapes(sf::Triangles) {
+        const float pi = 3.141592654f;
+        for (int i = 0; i < CIRCLE_POINTS; i++) {
+            float angle = i * 2 * pi / CIRCLE_POINTS - pi / 2;
+            circlePoints[i] = sf::Vector2f(std::cos(angle), std::sin(angle));
+        }
+    }
+
+    void setFont(const sf::Font& _font) { font = &_font; }
+
+    void rect(float x, float y, float width, float height, const sf::Color& fill) {
+        quad(x, y, x + width, y + height, fill);
+    }
+
+    // Outline grows outwards like sf::Shape's positive outline thickness
+    void outlinedRect(float x, float y, float width, float height, const sf::Color& fill,
+                      const sf::Color& outline, float thickness) {
+        quad(x, y, x + width, y + height, fill);
+        float t = thickness;
+        quad(x - t, y - t, x + width + t, y, outline);
+        quad(x - t, y + height, x + width + t, y + height + t, outline);
+        quad(x - t, y, x, y + height, outline);
+        quad(x + width, y, x + width + t, y + height, outline);
+    }
+
+    // (x, y) is the top-left of the bounding box, as with sf::CircleShape::setPosition
+    void circle(float x, float y, float radius, const sf::Color& color) {
+        sf::Vector2f center(x + radius, y + radius);
+        for (int i = 0; i < CIRCLE_POINTS; i++) {
+            const sf::Vector2f& a = circlePoints[i];
+            const sf::Vector2f& b = circlePoints[(i + 1) % CIRCLE_POINTS];
+            shapes.append(sf::Vertex(center, color));
+            shapes.append(sf::Vertex(sf::Vector2f(center.x + a.x * radius, center.y + a.y * radius), color));
+            shapes.append(sf::Vertex(sf::Vector2f(center.x + b.x * radius, center.y + b.y * radius), color));
+        }
+    }
+
+    void glyphs(const GlyphRun& run, float x, float y) {
+        if (run.vertices.empty()) return;
+        sf::VertexArray& layer = text[run.characterSize];
+        layer.setPrimitiveType(sf::Triangles);
+        for (const sf::Vertex& vertex : run.vertices) {
+            layer.append(sf::Vertex(sf::Vector2f(vertex.position.x + x, vertex.position.y + y),
+                                    vertex.color, vertex.texCoords));
+        }
+    }
+
+    // Draws and empties the batch. The vertex arrays keep their capacity, so a
+    // frame no larger than the last one does not allocate.
+    void flush(sf::RenderTarget& target) {
+        if (shapes.getVertexCount() > 0) {
+            target.draw(shapes, sf::RenderStates::Default);
+            drawCalls++;
+            shapes.clear();
+        }
+        for (auto& [characterSize, layer] : text) {
+            if (layer.getVertexCount() == 0) continue;
+            target.draw(layer, sf::RenderStates(&font->getTexture(characterSize)));
+            drawCalls++;
+            layer.clear();
+        }
+    }
+
+    // Draws something outside the batch right away (a cached layer sprite, say),
+    // counting the call. Whatever is batched is not flushed first, so call this
+    // between flushes to keep painter's order.
+    void drawNow(sf::RenderTarget& target, const sf::Drawable& drawable) {
+        target.draw(drawable);
+        drawCalls++;
+    }
+
+    // Draw calls issued since the last call
+    unsigned int takeDrawCalls() {
+        unsigned int calls = drawCalls;
+        drawCalls = 0;
+        return calls;
+    }
+};
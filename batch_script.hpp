@@ -0,0 +1,482 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "task_manager.hpp"
+
+// ------------------ Batch Scripts ------------------
+// Line-oriented commands for driving a TaskManager without prompts, one per
+// line; blank lines and lines starting with '#' are skipped:
+//
+//   add <priority> <deadline> <title>[ | <description>]
+//   complete <id>            delete <id>            tomorrow <id>
+//   edit <id> <deadline> <title>                    prio <id> <priority>
+//   update <id> <priority> <deadline> <title>[ | <description>]
+//   undo    redo    sort
+//   get <id>    find <title>    search <text>    due <date>
+//   list [all|pending|completed]    top <n>    count    export    info
+//
+// Every command answers with one line: "ok" ("ok <id>" for add), or
+// "error <line> <message>". Queries answer "ok <n>" followed by n rows of
+// tab-separated id, priority, deadline, completed (0/1) and title; get and
+// export add the description as a sixth field. find matches the whole title
+// exactly, through the engine's title index; search matches substrings by
+// scanning. count answers "ok <total> <pending> <completed>", info
+// "ok <next id> <generation>". Deadlines must be whole YYYY-MM-DD dates;
+// add, edit and update fail on anything else.
+
+// The values double as op codes in the daemon protocol (task_protocol.hpp)
+enum class BatchOp {
+    ADD, COMPLETE, DELETE, EDIT, UPDATE, PRIO, TOMORROW, UNDO, REDO, SORT,
+    GET, FIND, SEARCH, DUE, LIST, TOP, COUNT, EXPORT, INFO
+};
+
+struct BatchCommand {
+    BatchOp op = BatchOp::COUNT;
+    size_t line = 0;
+    int id = 0;
+    int number = 0;                 // priority, or the n of top
+    std::string deadline;
+    std::string text;               // title, search text or list filter
+    std::string description;
+};
+
+inline bool isMutation(BatchOp op) {
+    return op <= BatchOp::SORT;
+}
+
+namespace batch_detail {
+
+inline std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+    return s;
+}
+
+// Splits off the first space-separated word of `rest`
+inline std::string_view nextWord(std::string_view& rest) {
+    rest = trim(rest);
+    size_t end = rest.find_first_of(" \t");
+    std::string_view word = rest.substr(0, end);
+    rest = end == std::string_view::npos ? std::string_view() : rest.substr(end);
+    return word;
+}
+
+inline bool parseInt(std::string_view word, int& value) {
+    auto result = std::from_chars(word.data(), word.data() + word.size(), value);
+    return result.ec == std::errc() && result.ptr == word.data() + word.size();
+}
+
+struct OpName {
+    const char* name;
+    BatchOp op;
+};
+
+const OpName OP_NAMES[] = {
+    {"add", BatchOp::ADD}, {"complete", BatchOp::COMPLETE}, {"delete", BatchOp::DELETE},
+    {"edit", BatchOp::EDIT}, {"update", BatchOp::UPDATE}, {"prio", BatchOp::PRIO}, {"tomorrow", BatchOp::TOMORROW},
+    {"undo", BatchOp::UNDO}, {"redo", BatchOp::REDO}, {"sort", BatchOp::SORT},
+    {"get", BatchOp::GET}, {"find", BatchOp::FIND}, {"search", BatchOp::SEARCH}, {"due", BatchOp::DUE},
+    {"list", BatchOp::LIST}, {"top", BatchOp::TOP}, {"count", BatchOp::COUNT},
+    {"export", BatchOp::EXPORT}, {"info", BatchOp::INFO},
+};
+
+// "<title>[ | <description>]"
+inline void parseTitleAndDescription(std::string_view rest, BatchCommand& command) {
+    rest = trim(rest);
+    size_t bar = rest.find('|');
+    command.text = std::string(trim(rest.substr(0, bar)));
+    command.description = bar == std::string_view::npos ? std::string() : std::string(trim(rest.substr(bar + 1)));
+}
+
+} // namespace batch_detail
+
+// Parses one non-blank, non-comment line. Returns false with `error` set if
+// the line is malformed.
+inline bool parseBatchLine(std::string_view line, BatchCommand& command, std::string& error) {
+    using namespace batch_detail;
+    std::string_view rest = line;
+    std::string_view word = nextWord(rest);
+
+    bool known = false;
+    for (const OpName& entry : OP_NAMES) {
+        if (word == entry.name) {
+            command.op = entry.op;
+            known = true;
+            break;
+        }
+    }
+    if (!known) {
+        error = "unknown command";
+        return false;
+    }
+
+    switch (command.op) {
+        case BatchOp::ADD: {
+            if (!parseInt(nextWord(rest), command.number)) {
+                error = "expected: add <priority> <deadline> <title>";
+                return false;
+            }
+            command.deadline = std::string(nextWord(rest));
+            parseTitleAndDescription(rest, command);
+            return true;
+        }
+        case BatchOp::UPDATE: {
+            if (!parseInt(nextWord(rest), command.id) || !parseInt(nextWord(rest), command.number)) {
+                error = "expected: update <id> <priority> <deadline> <title>";
+                return false;
+            }
+            command.deadline = std::string(nextWord(rest));
+            parseTitleAndDescription(rest, command);
+            return true;
+        }
+        case BatchOp::COMPLETE:
+        case BatchOp::DELETE:
+        case BatchOp::TOMORROW:
+        case BatchOp::GET:
+            if (!parseInt(nextWord(rest), command.id) || !trim(rest).empty()) {
+                error = "expected a task id";
+                return false;
+            }
+            return true;
+        case BatchOp::EDIT:
+            if (!parseInt(nextWord(rest), command.id)) {
+                error = "expected: edit <id> <deadline> <title>";
+                return false;
+            }
+            command.deadline = std::string(nextWord(rest));
+            command.text = std::string(trim(rest));
+            return true;
+        case BatchOp::PRIO:
+            if (!parseInt(nextWord(rest), command.id) || !parseInt(nextWord(rest), command.number)) {
+                error = "expected: prio <id> <priority>";
+                return false;
+            }
+            return true;
+        case BatchOp::TOP:
+            if (!parseInt(nextWord(rest), command.number) || command.number < 0) {
+                error = "expected: top <n>";
+                return false;
+            }
+            return true;
+        case BatchOp::FIND:
+        case BatchOp::SEARCH:
+        case BatchOp::DUE:
+            command.text = std::string(trim(rest));
+            if (command.text.empty()) {
+                error = "expected text to look for";
+                return false;
+            }
+            return true;
+        case BatchOp::LIST:
+            command.text = std::string(nextWord(rest));
+            if (command.text.empty()) command.text = "all";
+            if (command.text != "all" && command.text != "pending" && command.text != "completed") {
+                error = "expected: list [all|pending|completed]";
+                return false;
+            }
+            return true;
+        default:
+            if (!trim(rest).empty()) {
+                error = "unexpected arguments";
+                return false;
+            }
+            return true;
+    }
+}
+
+
+// ------------------ CommandRunner ------------------
+// Executes parsed commands back-to-back against a TaskManager and reports
+// each outcome to a Sink, in command order. Consecutive mutations are held
+// until the next query (or finish(), or MAX_BATCH of them) and then applied
+// as one engine batch, so the run publishes a single generation; queries
+// always see every mutation before them.
+//
+// A Sink takes exactly one of these per command:
+//   values(v, n)                 "ok" plus n numbers: none, an id, counts
+//   rows(n, withDescriptions)    followed by n row(task, description) calls;
+//                                description is null unless withDescriptions
+//   fail(line, message)
+// TextSink below writes the script format; the daemon writes its wire format.
+struct BatchStats {
+    size_t commands = 0;
+    size_t errors = 0;
+};
+
+template <class Sink>
+class CommandRunner {
+public:
+    static const size_t MAX_BATCH = 4096;
+
+    // Sees each batch of mutations once it has been applied, failed ones
+    // included; the daemon logs them for its followers (task_replication.hpp)
+    typedef std::function<void(const std::vector<BatchCommand>&)> Observer;
+
+private:
+    TaskManager& manager;
+    Sink& sink;
+    Observer observer;
+    std::vector<BatchCommand> mutations;
+    std::vector<int> ids;           // scratch for query results
+    std::string description;        // scratch for get and export
+    BatchStats stats;
+
+    void fail(size_t line, const char* message) {
+        sink.fail(line, message);
+        stats.errors++;
+    }
+
+    void ok() {
+        sink.values(nullptr, 0);
+    }
+
+    void writeRows(const std::vector<int>& rows) {
+        sink.rows(rows.size(), false);
+        for (int id : rows) sink.row(*manager.getRecord(id), nullptr);
+    }
+
+    void applyMutation(const BatchCommand& command) {
+        const TaskRecord* task = nullptr;
+        switch (command.op) {
+            case BatchOp::ADD:
+                if (!Date::isValid(command.deadline)) return fail(command.line, "deadline must be YYYY-MM-DD");
+                try {
+                    uint64_t id = manager.addTask(command.text, command.description, command.deadline, command.number);
+                    sink.values(&id, 1);
+                }
+                catch (const std::invalid_argument& e) {
+                    fail(command.line, e.what());
+                }
+                return;
+            case BatchOp::UNDO:
+                if (!manager.canUndo()) return fail(command.line, "nothing to undo");
+                manager.undo();
+                break;
+            case BatchOp::REDO:
+                if (!manager.canRedo()) return fail(command.line, "nothing to redo");
+                manager.redo();
+                break;
+            case BatchOp::SORT:
+                manager.sortByDeadline();
+                break;
+            default:
+                task = manager.getRecord(command.id);
+                if (task == nullptr) return fail(command.line, "no such task");
+                if (command.op == BatchOp::COMPLETE) {
+                    manager.markTaskCompleted(command.id);
+                }
+                else if (command.op == BatchOp::DELETE) {
+                    manager.deleteTask(command.id);
+                }
+                else if (command.op == BatchOp::EDIT) {
+                    if (command.text.empty()) return fail(command.line, "title cannot be empty");
+                    if (!Date::isValid(command.deadline)) return fail(command.line, "deadline must be YYYY-MM-DD");
+                    manager.editTask(command.id, command.text, command.deadline);
+                }
+                else if (command.op == BatchOp::UPDATE) {
+                    if (command.text.empty()) return fail(command.line, "title cannot be empty");
+                    if (command.number < 1 || command.number > 10) return fail(command.line, "priority must be between 1 and 10");
+                    if (!Date::isValid(command.deadline)) return fail(command.line, "deadline must be YYYY-MM-DD");
+                    manager.updateTask(command.id, command.text, command.description, command.deadline, command.number);
+                }
+                else if (command.op == BatchOp::PRIO) {
+                    if (command.number < 1 || command.number > 10) return fail(command.line, "priority must be between 1 and 10");
+                    manager.updatePriority(command.id, command.number);
+                }
+                else {
+                    std::string deadline = task->deadline();
+                    if (!Date::isValid(deadline)) return fail(command.line, "task has no valid deadline");
+                    Date date(deadline);
+                    date.addDays(1);
+                    if (!Date::isValid(date.toString())) return fail(command.line, "deadline out of range");
+                    manager.editTask(command.id, task->title, date.toString());
+                }
+                break;
+        }
+        ok();
+    }
+
+    void runQuery(const BatchCommand& command) {
+        switch (command.op) {
+            case BatchOp::GET: {
+                const TaskRecord* task = manager.getRecord(command.id);
+                if (task == nullptr) return fail(command.line, "no such task");
+                description = manager.getDescription(*task);
+                sink.rows(1, true);
+                sink.row(*task, &description);
+                return;
+            }
+            case BatchOp::FIND:
+                writeRows(manager.findByTitle(command.text));
+                return;
+            case BatchOp::SEARCH:
+                writeRows(manager.selectIds([&](const TaskRecord& task) { return manager.taskMatches(task, command.text); }, false));
+                return;
+            case BatchOp::DUE:
+                // Deadlines are stored as day numbers, so the index answers exactly
+                ids.clear();
+                if (Date::isValid(command.text)) ids = manager.tasksDueOn(deadlineDayNumber(command.text));
+                writeRows(ids);
+                return;
+            case BatchOp::LIST: {
+                bool all = command.text == "all", completed = command.text == "completed";
+                size_t count = all ? manager.getTaskCount() : completed ? manager.getCompletedCount() : manager.getPendingCount();
+                sink.rows(count, false);
+                for (const TaskRecord& task : manager) {
+                    if (all || task.completed == completed) sink.row(task, nullptr);
+                }
+                return;
+            }
+            case BatchOp::TOP:
+                ids = manager.selectIds([](const TaskRecord& task) { return !task.completed; }, true);
+                if (ids.size() > size_t(command.number)) ids.resize(command.number);
+                writeRows(ids);
+                return;
+            case BatchOp::EXPORT:
+                sink.rows(manager.getTaskCount(), true);
+                for (const TaskRecord& task : manager) {
+                    description = manager.getDescription(task);
+                    sink.row(task, &description);
+                }
+                return;
+            case BatchOp::INFO: {
+                uint64_t values[] = {uint64_t(manager.getNextId()), manager.getGeneration()};
+                sink.values(values, 2);
+                return;
+            }
+            default: {
+                uint64_t values[] = {manager.getTaskCount(), manager.getPendingCount(), manager.getCompletedCount()};
+                sink.values(values, 3);
+                return;
+            }
+        }
+    }
+
+public:
+    CommandRunner(TaskManager& _manager, Sink& _sink, Observer _observer = Observer())
+        : manager(_manager), sink(_sink), observer(std::move(_observer)) {}
+
+    void submit(BatchCommand command) {
+        stats.commands++;
+        if (isMutation(command.op)) {
+            mutations.push_back(std::move(command));
+            if (mutations.size() >= MAX_BATCH) flushMutations();
+        }
+        else {
+            flushMutations();
+            runQuery(command);
+        }
+    }
+
+    // A command that could not be parsed still answers in order
+    void reject(size_t line, const char* message) {
+        stats.commands++;
+        flushMutations();
+        fail(line, message);
+    }
+
+    void flushMutations() {
+        if (mutations.empty()) return;
+        manager.beginBatch();
+        for (const BatchCommand& command : mutations) applyMutation(command);
+        manager.endBatch();
+        if (observer) observer(mutations);
+        mutations.clear();
+    }
+
+    // Applies what is still held; call at the end of the input
+    void finish() {
+        flushMutations();
+    }
+
+    const BatchStats& getStats() const {
+        return stats;
+    }
+};
+
+// ------------------ TextSink ------------------
+// The script format: one line per command, rows tab-separated
+class TextSink {
+private:
+    std::ostream& out;
+
+public:
+    explicit TextSink(std::ostream& _out) : out(_out) {}
+
+    void values(const uint64_t* values, size_t count) {
+        out << "ok";
+        for (size_t i = 0; i < count; i++) out << ' ' << values[i];
+        out << '\n';
+    }
+
+    void rows(size_t count, bool) {
+        out << "ok " << count << '\n';
+    }
+
+    void row(const TaskRecord& task, const std::string* description) {
+        out << task.id << '\t' << task.priority << '\t' << task.deadline() << '\t'
+            << (task.completed ? '1' : '0') << '\t' << task.title;
+        if (description != nullptr) out << '\t' << *description;
+        out << '\n';
+    }
+
+    void fail(size_t line, const char* message) {
+        out << "error " << line << ' ' << message << '\n';
+    }
+};
+
+// ------------------ BatchRunner ------------------
+// Runs script text against a local TaskManager, answering on `out`
+class BatchRunner {
+public:
+    static const size_t MAX_BATCH = CommandRunner<TextSink>::MAX_BATCH;
+
+private:
+    TextSink sink;
+    CommandRunner<TextSink> runner;
+
+public:
+    BatchRunner(TaskManager& manager, std::ostream& out) : sink(out), runner(manager, sink) {}
+
+    // Runs one script line, numbered `lineNumber` in error messages
+    void feed(std::string_view line, size_t lineNumber) {
+        std::string_view body = batch_detail::trim(line);
+        if (body.empty() || body.front() == '#') return;
+
+        BatchCommand command;
+        std::string error;
+        if (!parseBatchLine(body, command, error)) {
+            runner.reject(lineNumber, error.c_str());
+            return;
+        }
+        command.line = lineNumber;
+        runner.submit(std::move(command));
+    }
+
+    void flushMutations() {
+        runner.flushMutations();
+    }
+
+    void finish() {
+        runner.finish();
+    }
+
+    // The whole of `in`, line by line
+    void run(std::istream& in) {
+        std::string line;
+        size_t lineNumber = 0;
+        while (std::getline(in, line)) feed(line, ++lineNumber);
+        finish();
+    }
+
+    const BatchStats& getStats() const {
+        return runner.getStats();
+    }
+};
@@ -0,0 +1,20 @@
+# Writes INPUT as a C++ byte array named SYMBOL into OUTPUT.
+# Usage: cmake -DINPUT=... -DOUTPUT=... -DSYMBOL=... -P EmbedFile.cmake
+file(READ "${INPUT}" bytes HEX)
+string(LENGTH "${bytes}" hexLength)
+math(EXPR size "${hexLength} / 2")
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${bytes}")
+# 16 bytes per line (CMake regexes have no {n} repeat)
+string(REPEAT "0x[0-9a-f][0-9a-f]," 16 line)
+string(REGEX REPLACE "(${line})" "\\1\n    " bytes "${bytes}")
+get_filename_component(name "${INPUT}" NAME)
+file(WRITE "${OUTPUT}"
+"// Generated from ${name} by cmake/EmbedFile.cmake; do not edit
+#pragma once
+#include <cstddef>
+
+alignas(8) static const unsigned char ${SYMBOL}[] = {
+    ${bytes}
+};
+static const size_t ${SYMBOL}_SIZE = ${size};
+")
@@ -0,0 +1,218 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "memory_stats.hpp"
+
+// ------------------ ColdStore ------------------
+// Holds rarely-read task fields (descriptions today; notes and attachment
+// metadata later) out of the hot task records. Values are addressed by a
+// 32-bit ColdRef. In memory mode each value is a string slot. In file mode
+// values are appended to a spill file, only (offset, length) stays in RAM,
+// and reads page in lazily through a small LRU page cache.
+
+typedef uint32_t ColdRef;
+const ColdRef NO_COLD_REF = 0xFFFFFFFFu;
+
+class ColdStore {
+private:
+    static const size_t PAGE_SIZE = 4096;
+    static const size_t DEFAULT_CACHE_PAGES = 256;      // 1 MB of cached file pages
+
+    struct Extent {
+        uint64_t offset;
+        uint32_t length;
+    };
+
+    struct Page {
+        uint64_t number;
+        std::vector<char> bytes;
+    };
+
+    // Memory mode
+    std::vector<std::string> values;
+    // File mode
+    std::vector<Extent> extents;
+    bool fileBacked = false;
+    std::string filePath;
+    mutable std::fstream file;
+    uint64_t fileSize = 0;
+    mutable std::list<Page> lru;                        // most recently used at the front
+    mutable std::unordered_map<uint64_t, std::list<Page>::iterator> pages;
+    size_t cachePages = DEFAULT_CACHE_PAGES;
+    mutable std::mutex fileMutex;                       // guards file, lru and pages
+
+    std::vector<ColdRef> freeRefs;
+    size_t liveCount = 0;
+
+    const Page& loadPage(uint64_t number) const {
+        auto found = pages.find(number);
+        if (found != pages.end()) {
+            lru.splice(lru.begin(), lru, found->second);
+            return *found->second;
+        }
+
+        if (lru.size() >= cachePages) {
+            pages.erase(lru.back().number);
+            lru.pop_back();
+        }
+        lru.push_front(Page{number, std::vector<char>(PAGE_SIZE)});
+        Page& page = lru.front();
+        file.clear();
+        file.seekg(std::streamoff(number * PAGE_SIZE));
+        file.read(page.bytes.data(), PAGE_SIZE);
+        pages[number] = lru.begin();
+        return page;
+    }
+
+    std::string readExtent(const Extent& extent) const {
+        std::string out;
+        out.reserve(extent.length);
+        uint64_t position = extent.offset;
+        uint64_t end = extent.offset + extent.length;
+        while (position < end) {
+            const Page& page = loadPage(position / PAGE_SIZE);
+            size_t from = size_t(position % PAGE_SIZE);
+            size_t count = size_t(std::min<uint64_t>(PAGE_SIZE - from, end - position));
+            out.append(page.bytes.data() + from, count);
+            position += count;
+        }
+        return out;
+    }
+
+    Extent appendToFile(const std::string& value) {
+        Extent extent{fileSize, uint32_t(value.size())};
+        file.clear();
+        file.seekp(std::streamoff(fileSize));
+        file.write(value.data(), std::streamsize(value.size()));
+        fileSize += value.size();
+
+        // Cached copies of the pages we just wrote to are stale now
+        for (uint64_t number = extent.offset / PAGE_SIZE;
+             number * PAGE_SIZE < fileSize && value.size() > 0; number++) {
+            auto found = pages.find(number);
+            if (found != pages.end()) {
+                lru.erase(found->second);
+                pages.erase(found);
+            }
+        }
+        return extent;
+    }
+
+    ColdRef allocateRef() {
+        liveCount++;
+        if (!freeRefs.empty()) {
+            ColdRef ref = freeRefs.back();
+            freeRefs.pop_back();
+            return ref;
+        }
+        if (fileBacked) {
+            extents.push_back(Extent{0, 0});
+            return ColdRef(extents.size() - 1);
+        }
+        values.emplace_back();
+        return ColdRef(values.size() - 1);
+    }
+
+public:
+    ColdStore() {}
+    ~ColdStore() {
+        if (file.is_open()) file.close();
+    }
+
+    ColdStore(const ColdStore&) = delete;
+    ColdStore& operator=(const ColdStore&) = delete;
+
+    bool isFileBacked() const { return fileBacked; }
+    size_t size() const { return liveCount; }
+
+    // Switches to file mode, moving every value already held in memory to the file.
+    // Returns false (and stays in memory mode) if the file cannot be created.
+    bool openFile(const std::string& path, size_t cacheBytes = DEFAULT_CACHE_PAGES * PAGE_SIZE) {
+        std::lock_guard<std::mutex> lock(fileMutex);
+        if (fileBacked) return path == filePath;
+
+        file.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+
+        filePath = path;
+        fileBacked = true;
+        cachePages = std::max<size_t>(1, cacheBytes / PAGE_SIZE);
+        extents.resize(values.size(), Extent{0, 0});
+        for (size_t ref = 0; ref < values.size(); ref++) {
+            extents[ref] = appendToFile(values[ref]);
+        }
+        file.flush();
+        std::vector<std::string>().swap(values);
+        return true;
+    }
+
+    ColdRef put(const std::string& value) {
+        ColdRef ref = allocateRef();
+        set(ref, value);
+        return ref;
+    }
+
+    // In file mode the old bytes are left behind; the file is append-only
+    void set(ColdRef ref, const std::string& value) {
+        if (fileBacked) {
+            std::lock_guard<std::mutex> lock(fileMutex);
+            extents[ref] = appendToFile(value);
+        }
+        else {
+            values[ref] = value;
+        }
+    }
+
+    std::string get(ColdRef ref) const {
+        if (ref == NO_COLD_REF) return std::string();
+        if (!fileBacked) return values[ref];
+
+        std::lock_guard<std::mutex> lock(fileMutex);
+        file.flush();
+        return readExtent(extents[ref]);
+    }
+
+    bool contains(ColdRef ref, const std::string& needle) const {
+        if (ref == NO_COLD_REF) return needle.empty();
+        if (!fileBacked) return values[ref].find(needle) != std::string::npos;
+        return get(ref).find(needle) != std::string::npos;
+    }
+
+    void erase(ColdRef ref) {
+        if (ref == NO_COLD_REF) return;
+        if (fileBacked) {
+            extents[ref] = Extent{0, 0};
+        }
+        else {
+            std::string().swap(values[ref]);
+        }
+        freeRefs.push_back(ref);
+        liveCount--;
+    }
+
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        usage.structBytes = sizeof(*this)
+            + values.capacity() * sizeof(std::string)
+            + extents.capacity() * sizeof(Extent)
+            + freeRefs.capacity() * sizeof(ColdRef);
+        if (values.capacity()) usage.addAllocation(values.capacity() * sizeof(std::string));
+        if (extents.capacity()) usage.addAllocation(extents.capacity() * sizeof(Extent));
+        if (freeRefs.capacity()) usage.addAllocation(freeRefs.capacity() * sizeof(ColdRef));
+        for (const auto& value : values) {
+            usage.addString(value);
+        }
+
+        std::lock_guard<std::mutex> lock(fileMutex);
+        for (const auto& page : lru) {
+            usage.structBytes += sizeof(page) + page.bytes.capacity();
+            usage.addAllocation(page.bytes.capacity());
+        }
+        return usage;
+    }
+};
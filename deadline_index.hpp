@@ -0,0 +1,108 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "memory_stats.hpp"
+#include "task_record.hpp"
+#include "task_sort.hpp"
+
+// ------------------ DeadlineIndex ------------------
+// Task ids bucketed by deadline day number, buckets ordered by day, each with
+// a running count of its pending tasks. The TaskManager keeps it current on
+// every change, so the counts for a range of days cost one walk over those
+// days' buckets however many tasks there are. Days with no tasks have no
+// bucket; unparsable deadlines share the NO_DEADLINE_KEY bucket.
+class DeadlineIndex {
+private:
+    struct Day {
+        std::vector<int> ids;           // unordered
+        uint32_t pending = 0;
+    };
+
+    std::map<uint32_t, Day> days;
+
+public:
+    void add(int id, uint32_t day, bool completed) {
+        Day& bucket = days[day];
+        bucket.ids.push_back(id);
+        if (!completed) bucket.pending++;
+    }
+
+    void remove(int id, uint32_t day, bool completed) {
+        auto it = days.find(day);
+        if (it == days.end()) return;
+        std::vector<int>& ids = it->second.ids;
+        auto slot = std::find(ids.begin(), ids.end(), id);
+        if (slot == ids.end()) return;
+        *slot = ids.back();
+        ids.pop_back();
+        if (!completed) it->second.pending--;
+        if (ids.empty()) days.erase(it);
+    }
+
+    // Same task, same day: only the pending count moves
+    void setCompleted(uint32_t day, bool wasCompleted, bool completed) {
+        if (wasCompleted == completed) return;
+        auto it = days.find(day);
+        if (it == days.end()) return;
+        if (completed) it->second.pending--;
+        else it->second.pending++;
+    }
+
+    // Bulk add of records[from..]: sorted by day first, so each day's bucket
+    // is looked up once rather than once per task. The handle packs the id
+    // with the completed bit, so the sorted pass never goes back to records.
+    void addRange(const std::vector<TaskRecord>& records, size_t from) {
+        std::vector<SortEntry<uint32_t>> entries;
+        entries.reserve(records.size() - from);
+        for (size_t i = from; i < records.size(); i++) {
+            const TaskRecord& record = records[i];
+            entries.push_back({record.deadlineDay, uint32_t(record.id) << 1 | uint32_t(record.completed)});
+        }
+        radixSortByKey(entries);
+        for (size_t i = 0; i < entries.size();) {
+            uint32_t day = entries[i].key;
+            Day& bucket = days[day];
+            for (; i < entries.size() && entries[i].key == day; i++) {
+                bucket.ids.push_back(int(entries[i].handle >> 1));
+                if (!(entries[i].handle & 1)) bucket.pending++;
+            }
+        }
+    }
+
+    void clear() {
+        days.clear();
+    }
+
+    // counts[d - first] = pending tasks due on day number d, for d in [first, last]
+    void pendingCounts(uint32_t first, uint32_t last, std::vector<uint32_t>& counts) const {
+        counts.assign(last - first + 1, 0);
+        for (auto it = days.lower_bound(first); it != days.end() && it->first <= last; ++it) {
+            counts[it->first - first] = it->second.pending;
+        }
+    }
+
+    // Ids due on `day` in no particular order; null if there are none
+    const std::vector<int>* idsOn(uint32_t day) const {
+        auto it = days.find(day);
+        return it == days.end() ? nullptr : &it->second.ids;
+    }
+
+    size_t dayCount() const {
+        return days.size();
+    }
+
+    // Map nodes (key, bucket, node header of roughly four pointers) plus the id arrays
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        const size_t nodeBytes = sizeof(std::pair<const uint32_t, Day>) + 4 * sizeof(void*);
+        usage.structBytes = sizeof(days);
+        for (const auto& day : days) {
+            usage.structBytes += nodeBytes + day.second.ids.capacity() * sizeof(int);
+            usage.addAllocation(nodeBytes);
+            if (day.second.ids.capacity() > 0) usage.addAllocation(day.second.ids.capacity() * sizeof(int));
+        }
+        return usage;
+    }
+};
@@ -0,0 +1,120 @@
+#pragma once
+#include "task_manager.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// ------------------ DisplayFilter ------------------
+// Which tasks a list screen shows and in what order. The same predicate
+// drives the full load and the incremental updates, so the two always agree.
+struct DisplayFilter {
+    std::function<bool(const TaskRecord&)> accepts;     // null = every task
+    bool byPriority = false;                            // otherwise record order
+    size_t limit = SIZE_MAX;                            // top-N views keep only the first `limit`
+    bool withArchive = false;                           // archived tasks follow the engine's rows
+    std::function<bool(const ArchivedTask&)> acceptsArchived;   // null = every archived task
+
+    bool admits(const TaskRecord& task) const {
+        return !accepts || accepts(task);
+    }
+};
+
+// ------------------ ArchiveRows ------------------
+// The archived part of a list screen, shown after the DisplayList's rows:
+// every row of the TaskArchive, or the rows a scan of it matched. Rows are
+// read from the archive's page cache only when drawn.
+struct ArchiveRows {
+    bool all = false;
+    std::vector<uint32_t> rows;         // ascending, unless all
+
+    size_t size(const TaskArchive& archive) const { return all ? archive.size() : rows.size(); }
+    size_t rowAt(size_t i) const { return all ? i : rows[i]; }
+};
+
+// ------------------ DisplayList ------------------
+// The rows of a list screen as task ids, tagged with the engine generation
+// they reflect. Rows are resolved against the TaskManager only when drawn.
+// After a mutation update() replays the engine's change journal and touches
+// only the changed ids: a binary search to find each one, and an insert or
+// erase where membership changed. Completing one task in a 1M-row list costs
+// microseconds instead of a full reload; only rows of deleted tasks and rows
+// in priority order are looked up by a scan of the ids.
+class DisplayList {
+private:
+    std::vector<int> ids;
+    DisplayFilter filter;
+    uint64_t generation = 0;
+    std::vector<int> changed;       // scratch for changesSince()
+
+    // Sort key of a task that exists in the engine
+    std::pair<int, size_t> keyOf(const TaskManager& manager, int id) const {
+        size_t position = manager.positionOf(id);
+        int priority = filter.byPriority ? manager.getRecord(id)->priority : 0;
+        return {priority, position};
+    }
+
+    // Where `id` belongs, assuming every row already in the list still exists
+    std::vector<int>::iterator slotFor(const TaskManager& manager, int id) {
+        auto key = keyOf(manager, id);
+        return std::lower_bound(ids.begin(), ids.end(), key,
+            [&](int row, const std::pair<int, size_t>& k) { return keyOf(manager, row) < k; });
+    }
+
+public:
+    void assign(std::vector<int> newIds, uint64_t newGeneration, DisplayFilter newFilter) {
+        ids.swap(newIds);
+        generation = newGeneration;
+        filter = std::move(newFilter);
+    }
+
+    void clear() {
+        ids.clear();
+        filter = DisplayFilter();
+    }
+
+    // Brings the list up to date with the engine. Returns false when that takes
+    // a full reload: the journal does not reach back far enough, the tasks were
+    // reordered, or the list is a truncated top-N view.
+    bool update(const TaskManager& manager) {
+        if (generation == manager.getGeneration()) return true;
+        if (filter.limit != SIZE_MAX || !manager.changesSince(generation, changed)) return false;
+
+        std::sort(changed.begin(), changed.end());
+        changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+        // Rows of removed tasks, and in priority order of every changed task,
+        // come out first by scanning: their old sort keys are unknown. What is
+        // left is sorted by current keys, so the rest is binary search.
+        std::vector<int> existing;
+        for (int id : changed) {
+            bool exists = manager.getRecord(id) != nullptr;
+            if (!exists || filter.byPriority) {
+                auto it = std::find(ids.begin(), ids.end(), id);
+                if (it != ids.end()) ids.erase(it);
+            }
+            if (exists) existing.push_back(id);
+        }
+        for (int id : existing) {
+            bool belongs = filter.admits(*manager.getRecord(id));
+            auto it = slotFor(manager, id);
+            bool present = it != ids.end() && *it == id;
+            if (present && !belongs) ids.erase(it);
+            else if (!present && belongs) ids.insert(it, id);
+        }
+
+        generation = manager.getGeneration();
+        return true;
+    }
+
+    size_t size() const { return ids.size(); }
+    bool empty() const { return ids.empty(); }
+    int idAt(size_t row) const { return ids[row]; }
+    uint64_t getGeneration() const { return generation; }
+
+    // Null if the row's task is gone (the list is behind the engine)
+    const TaskRecord* at(const TaskManager& manager, size_t row) const {
+        return manager.getRecord(ids[row]);
+    }
+};
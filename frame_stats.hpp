@@ -0,0 +1,66 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// ------------------ Frame Stats ------------------
+// Per-frame timings and counters, kept in a fixed ring so recording a frame
+// never allocates. The profiler overlay graphs them.
+
+struct FrameSample {
+    double updateMs = 0;        // events, timers and query results
+    double drawMs = 0;          // building and submitting the frame
+    double displayMs = 0;       // window.display(), i.e. waiting on the driver
+    double overlayMs = 0;       // the profiler overlay itself, part of drawMs
+    unsigned int drawCalls = 0;
+    unsigned long long allocations = 0;
+    size_t visibleRows = 0;
+
+    double totalMs() const { return updateMs + drawMs + displayMs; }
+};
+
+class FrameHistory {
+private:
+    std::vector<FrameSample> samples;
+    size_t next = 0;
+    size_t count = 0;
+
+public:
+    explicit FrameHistory(size_t capacity) : samples(capacity) {}
+
+    void push(const FrameSample& sample) {
+        samples[next] = sample;
+        next = (next + 1) % samples.size();
+        count = std::min(count + 1, samples.size());
+    }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return samples.size(); }
+
+    // 0 is the oldest frame still kept
+    const FrameSample& at(size_t i) const {
+        return samples[(next + samples.size() - count + i) % samples.size()];
+    }
+
+    const FrameSample& latest() const { return at(count - 1); }
+
+    double averageMs() const {
+        double sum = 0;
+        for (size_t i = 0; i < count; i++) sum += at(i).totalMs();
+        return count ? sum / count : 0;
+    }
+
+    double maxMs() const {
+        double worst = 0;
+        for (size_t i = 0; i < count; i++) worst = std::max(worst, at(i).totalMs());
+        return worst;
+    }
+};
+
+// Nearest-rank percentile (p in 0..100) of `values`, which it reorders
+inline double percentile(std::vector<double>& values, double p) {
+    if (values.empty()) return 0;
+    size_t rank = size_t(p / 100 * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
@@ -1,26 +1,85 @@
 #include "task_manager.hpp"
+#include "alloc_counter.hpp"
+#include "batch_renderer.hpp"
+#include "query_worker.hpp"
+#include "display_list.hpp"
+#include "frame_stats.hpp"
+#include "widget_tree.hpp"
+#include "task_client.hpp"
+#ifdef TODO_EMBEDDED_FONT
+#include "embedded_font.hpp"        // generated by CMake from assets/fonts
+#endif
 #include <SFML/Graphics.hpp>
 #include <iostream>
 #include <sstream>
 #include <iomanip>
 #include <functional>
 #include <map>
+#include <array>
+#include <unordered_map>
+#include <deque>
 #include <stdexcept>
+#include <thread>
+#include <future>
+#include <shared_mutex>
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
 
 using namespace sf;
 using namespace std;
 
+// The bundled font; CMake points this at assets/ in the source tree
+#ifndef TODO_FONT_FILE
+#define TODO_FONT_FILE "assets/fonts/DejaVuSans.ttf"
+#endif
+
 class TaskManagerGUI {
 private:
+    chrono::steady_clock::time_point createdAt = chrono::steady_clock::now();      // first, so startup timing covers everything below
     RenderWindow window;
+    RenderTexture canvas;       // stands in for the window in headless (benchmark) mode
+    bool headless = false;
     TaskManager taskManager;
     Font font;
     
+    // Queries run on the worker under a shared lock. Past startup the UI thread
+    // is the only writer: it cancels the running query and takes the lock
+    // exclusively for each mutation, and reads the engine without locking in between.
+    shared_mutex engineMutex;
+    QueryWorker queries;        // declared after the engine, so it is stopped before the engine goes away
+    bool drawnBusy = false;     // whether the last frame showed the searching indicator
+    
+    // A store being loaded on startup. The loader holds the engine lock
+    // exclusively for the whole import, and until it is done the UI does not
+    // touch the engine: it draws chrome and a placeholder and ignores input.
+    future<void> storeLoad;     // after the engine, so its destructor waits for the loader first
+    bool storeLoading = false;
+#ifdef TODO_DAEMON_CLIENT
+    TaskClient daemon;          // connected in client mode (--connect)
+    uint64_t daemonGeneration = 0;      // the daemon's generation our copy of its tasks matches
+    chrono::steady_clock::time_point daemonPollAt;
+#endif
+    double firstFrameMs = -1;   // startup to the first frame on screen
+    double storeReadyMs = -1;   // startup to the store being loaded
+    
     // Constants
     const unsigned int WINDOW_WIDTH = 1400;         //unsigned is integer that can only be zero or positive
     const unsigned int WINDOW_HEIGHT = 900;
     const float SIDEBAR_WIDTH = 280;
     const float HEADER_HEIGHT = 60;
+    const float TASK_CARD_HEIGHT = 80;
+    const float TASK_ROW_HEIGHT = 90;       // card plus gap
+    const float CARD_WIDTH = WINDOW_WIDTH - SIDEBAR_WIDTH - 40;
+    const size_t CARD_CACHE_LIMIT = 256;    // retained cards kept before off-screen ones are dropped
+    const chrono::milliseconds STATUS_MESSAGE_DURATION{3000};
+    const chrono::milliseconds TIMER_POLL_INTERVAL{16};     // event latency while a timer is pending
+    const chrono::milliseconds SEARCH_DEBOUNCE{40};         // pause in typing before the live search runs
+    const size_t SEARCH_CACHE_SIZE = 8;     // recent live search results kept for refining and backspace
+    const chrono::milliseconds DAEMON_POLL_INTERVAL{500};   // how soon other clients' changes show up
+    const string TRACE_FILE = "todo_trace.json";
     
     // Colors
     const Color BG_COLOR = Color(245, 246, 250);
@@ -47,6 +106,7 @@ private:
         PENDING_TASKS,
         PRIORITY_QUEUE,
         UPDATE_PRIORITY,
+        CALENDAR,
         SETTINGS
     };
     
@@ -56,8 +116,10 @@ private:
         bool isTyping = false;
         int selectedTaskId = -1;
         string searchQuery;
-        vector<Task> displayTasks;
-        float scrollOffset = 0;
+        DisplayList displayList;                // task ids; rows are resolved against the engine when drawn
+        ArchiveRows archiveRows;                // archived rows listed after them
+        Screen displayScreen = Screen::DASHBOARD;   // the screen displayList was loaded for
+        double scrollOffset = 0;        // double: a 50M-row list is 4.5e9 px tall, past float's whole pixels
         string statusMessage;
         bool showStatusMessage = false;
         
@@ -106,53 +168,139 @@ private:
             int taskId = -1;
             bool isUpdating = false;
         } priorityUpdate;
+        
+        // Calendar: the year shown and the day whose tasks are listed
+        struct {
+            int year = 0;               // 0 until first opened, then the current year
+            int selectedYear = 0;
+            int selectedMonth = 0;
+            int selectedDay = 0;        // 0 = no day selected
+            string selectedDate;
+        } calendar;
     } state;
 
-    struct Button {
-        RectangleShape shape;
-        Text text;
-        function<void()> onClick;
-        bool isEnabled = true;
-        Color originalColor;
-        
-        Button(const string& label, const Vector2f& size, const Vector2f& position,
-               const Font& font, const Color& color) {
-            shape.setSize(size);
-            shape.setPosition(position);
-            shape.setFillColor(color);
-            originalColor = color;
-            
-            text.setFont(font);
-            text.setString(label);
-            text.setCharacterSize(14);
-            text.setFillColor(Color::White);
-            
-            // Center text
-            FloatRect textBounds = text.getLocalBounds();   //center the text inside another shape... like a button
-            text.setPosition(
-                position.x + (size.x - textBounds.width) / 2,
-                position.y + (size.y - textBounds.height) / 2
-            );
-        }
-        
-        bool contains(Vector2i point) const {           //2D vector with integers
-            return shape.getGlobalBounds().contains(point.x, point.y);
-        }       //checks if a point (like a mouse click) is inside a shape (like a button)
-        
-        void draw(RenderWindow& window) const {
-            window.draw(shape);
-            window.draw(text);
-        }
-        
-        void setEnabled(bool enabled) {
-            isEnabled = enabled;
-            shape.setFillColor(enabled ? originalColor : Color(150, 150, 150));
-        }
+    WidgetTree widgets{WINDOW_WIDTH, WINDOW_HEIGHT};
+    size_t undoWidget = 0, redoWidget = 0;
+    map<string, function<void()>> actions;
+    
+    // ------------------ Retained Drawables ------------------
+    // Text is laid out once into glyph quads and kept here; it is only laid out
+    // again when the string it shows changes, which leaves a steady frame with
+    // no heap allocations at all. Everything is drawn through one BatchRenderer,
+    // so a full screen costs a handful of draw calls instead of several per card.
+    struct CachedText {
+        GlyphRun run;
+        string value;
+        unsigned int size = 0;
+        Color color;
     };
     
-    vector<Button> buttons;
-    map<string, function<void()>> actions;
-
+    // less<> lets lookups take a const char* without building a string
+    typedef map<string, CachedText, less<>> TextCache;
+    
+    // One task card's text, laid out relative to the card's top-left corner so
+    // scrolling never touches it. Rebuilt only when the record's version stamp changes.
+    struct CardCache {
+        uint32_t version = 0;
+        unsigned long long lastFrame = 0;
+        GlyphRun title;
+        GlyphRun description;
+        GlyphRun deadline;
+        GlyphRun priority;
+        Color indicatorColor;
+    };
+    
+    BatchRenderer batch;
+    TextCache labels;           // keyed by slot name
+    TextCache values;           // value text of each stat card and input field, keyed by its label
+    unordered_map<int, CardCache> cardCache;
+    GlyphRun checkmarkRun;
+    string scratch;             // reused for composed strings so it keeps its capacity
+    unsigned long long frameNumber = 0;
+    
+    // ------------------ Invalidation ------------------
+    // Nothing is drawn unless something marked the window dirty; otherwise the
+    // loop sleeps in waitEvent. Content is the screen body (rows, forms, search
+    // results), chrome is the sidebar, header, buttons and status box.
+    enum DirtyFlags : unsigned int {
+        DIRTY_CONTENT = 1,
+        DIRTY_CHROME = 2,
+        DIRTY_ALL = DIRTY_CONTENT | DIRTY_CHROME
+    };
+    unsigned int dirty = DIRTY_ALL;
+    chrono::steady_clock::time_point statusHideAt;
+    
+    void invalidate(unsigned int regions) {
+        dirty |= regions;
+    }
+    
+    // ------------------ Cached Layers ------------------
+    // Chrome that looks the same on nearly every frame is rendered once into
+    // an offscreen texture and composited as a single sprite. key holds every
+    // input the layer shows; the texture is only redrawn when the key changes
+    // or the window is resized.
+    typedef array<size_t, 3> LayerKey;
+    
+    struct CachedLayer {
+        RenderTexture texture;
+        Sprite sprite;
+        LayerKey key{};
+        bool valid = false;
+        bool created = false;           // the texture is made the first time the layer is drawn
+        unsigned int width = 0, height = 0;
+        Vector2f position;
+    };
+    
+    CachedLayer sidebarLayer;
+    CachedLayer headerLayer;
+    CachedLayer statsLayer;     // the three dashboard stat cards
+    
+    // Only records the geometry; the texture waits for the screen that shows it
+    void defineLayer(CachedLayer& layer, unsigned int width, unsigned int height, float x, float y) {
+        layer.width = width;
+        layer.height = height;
+        layer.position = Vector2f(x, y);
+        layer.valid = false;
+    }
+    
+    void createLayer(CachedLayer& layer) {
+        if (!layer.texture.create(layer.width, layer.height)) {
+            throw runtime_error("Failed to create render texture");
+        }
+        layer.sprite.setTexture(layer.texture.getTexture(), true);
+        layer.sprite.setPosition(layer.position);
+        layer.created = true;
+    }
+    
+    // True when the layer must be redrawn for these inputs. The batch has to be
+    // empty at that point, since the caller flushes it into the layer's texture.
+    bool layerStale(CachedLayer& layer, const LayerKey& key) {
+        if (layer.valid && layer.key == key) return false;
+        if (!layer.created) createLayer(layer);
+        layer.key = key;
+        layer.valid = true;
+        return true;
+    }
+    
+    void invalidateLayers() {
+        sidebarLayer.valid = false;
+        headerLayer.valid = false;
+        statsLayer.valid = false;
+    }
+    
+    void finishLayer(CachedLayer& layer) {
+        batch.flush(layer.texture);
+        layer.texture.display();
+    }
+    
+    // Profiler overlay (F3): the last PROFILER_FRAMES frames plus live engine stats
+    static const size_t PROFILER_FRAMES = 120;
+    bool showProfiler = false;
+    FrameHistory frameHistory{PROFILER_FRAMES};
+    FrameSample frame;                  // the frame being built
+    double lastSearchLatencyMs = 0;     // keystroke to results on screen, debounce included
+    double lastQueryMs = 0;             // worker time of the last background query that finished
+    
     void initWindow() {
         VideoMode desktop = VideoMode::getDesktopMode();
         window.create(VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), 
@@ -166,12 +314,107 @@ private:
         
         window.setFramerateLimit(60);       //limit the number of frames per second (FPS) to 60
         
-        if (!font.loadFromFile("C:\\Windows\\Fonts\\segoeui.ttf")) {
+        initResources();
+    }
+    
+    // Everything the draw code needs besides the window
+    void initResources() {
+        // The bundled font first, so every machine (and the render benchmark) draws
+        // the same glyphs. When it is compiled in, startup opens no font file. The
+        // atlas fills in as glyphs are first drawn, so before the first frame only
+        // the glyphs that frame shows are rasterized.
+#ifdef TODO_EMBEDDED_FONT
+        bool loaded = font.loadFromMemory(EMBEDDED_FONT, EMBEDDED_FONT_SIZE);
+#else
+        bool loaded = font.loadFromFile(TODO_FONT_FILE);
+#endif
+        if (!loaded && !font.loadFromFile("C:\\Windows\\Fonts\\segoeui.ttf")) {
             throw runtime_error("Failed to load font");
         }
         
+        initDrawables();
         initActions();
-        createButtons();
+        createSidebarWidgets();
+    }
+    
+    // Where frames go: the window, or the offscreen canvas when headless
+    RenderTarget& surface() {
+        if (headless) return canvas;
+        return window;
+    }
+    
+    void initDrawables() {
+        batch.setFont(font);
+        layoutGlyphRun(checkmarkRun, font, "✓", 14, Color::White);
+        
+        defineLayer(sidebarLayer, (unsigned int)SIDEBAR_WIDTH, WINDOW_HEIGHT, 0, 0);
+        defineLayer(headerLayer, WINDOW_WIDTH - (unsigned int)SIDEBAR_WIDTH, (unsigned int)HEADER_HEIGHT, SIDEBAR_WIDTH, 0);
+        // One pixel of margin for the card outlines
+        defineLayer(statsLayer, 642, 102, SIDEBAR_WIDTH + 19, HEADER_HEIGHT + 19);
+    }
+    
+    CachedText& cachedText(TextCache& cache, const char* slot, unsigned int size, const Color& color) {
+        auto found = cache.find(slot);
+        if (found == cache.end()) {
+            found = cache.emplace(slot, CachedText()).first;
+            found->second.size = size;
+            found->second.color = color;
+        }
+        return found->second;
+    }
+    
+    template <class S>
+    void drawText(TextCache& cache, const char* slot, const S& value,
+                  unsigned int size, const Color& color, float x, float y) {
+        CachedText& cached = cachedText(cache, slot, size, color);
+        if (cached.value != value) {
+            cached.value = value;
+            layoutGlyphRun(cached.run, font, cached.value, cached.size, cached.color);
+        }
+        batch.glyphs(cached.run, x, y);
+    }
+    
+    // Fixed text is its own slot name
+    void drawLabel(const char* text, unsigned int size, const Color& color, float x, float y) {
+        drawText(labels, text, text, size, color, x, y);
+    }
+    
+    // Archived tasks pass their description; the engine's come from its cold store
+    CardCache& cachedCard(const TaskRecord& task, const string* description = nullptr) {
+        CardCache& card = cardCache[task.id];
+        if (card.version != task.version) {
+            buildCard(card, task, description);
+        }
+        card.lastFrame = frameNumber;
+        return card;
+    }
+    
+    void buildCard(CardCache& card, const TaskRecord& task, const string* description) {
+        layoutGlyphRun(card.title, font, task.title, 16, TEXT_COLOR);
+        
+        string desc = description ? *description : taskManager.getDescription(task);
+        if (desc.length() > 50) {
+            desc = desc.substr(0, 47) + "...";
+        }
+        layoutGlyphRun(card.description, font, desc, 14, LIGHT_TEXT);
+        
+        layoutGlyphRun(card.deadline, font, "Due: " + task.deadline(), 14, LIGHT_TEXT);
+        
+        if (task.priority <= 3) card.indicatorColor = DANGER_COLOR;
+        else if (task.priority <= 7) card.indicatorColor = WARNING_COLOR;
+        else card.indicatorColor = SUCCESS_COLOR;
+        layoutGlyphRun(card.priority, font, "P" + to_string(task.priority), 14, LIGHT_TEXT);
+        
+        card.version = task.version;
+    }
+    
+    // Drop cards that were not drawn this frame once the cache outgrows its limit
+    void trimCardCache() {
+        if (cardCache.size() <= CARD_CACHE_LIMIT) return;
+        for (auto it = cardCache.begin(); it != cardCache.end();) {
+            if (it->second.lastFrame != frameNumber) it = cardCache.erase(it);
+            else ++it;
+        }
     }
     
     void initActions() {
@@ -182,7 +425,7 @@ private:
         
         actions["view_tasks"] = [this]() {
             state.currentScreen = Screen::VIEW_TASKS;
-            state.displayTasks = taskManager.getAllTasks();
+            loadCurrentView();
         };
         
         actions["search_title"] = [this]() {
@@ -199,6 +442,17 @@ private:
             state.inputBuffer.clear();
         };
         
+        actions["calendar"] = [this]() {
+            state.currentScreen = Screen::CALENDAR;
+            if (state.calendar.year == 0) {
+                time_t now = time(nullptr);
+                tm today = *localtime(&now);
+                state.calendar.year = today.tm_year + 1900;
+                selectCalendarDay(state.calendar.year, today.tm_mon + 1, today.tm_mday);
+            }
+            loadCurrentView();
+        };
+        
         actions["dashboard"] = [this]() {
             state.currentScreen = Screen::DASHBOARD;
             updateDashboard();
@@ -206,25 +460,22 @@ private:
         
         actions["completed_tasks"] = [this]() {
             state.currentScreen = Screen::COMPLETED_TASKS;
-            state.displayTasks = taskManager.getCompletedTasks();
+            loadCurrentView();
         };
         
         actions["pending_tasks"] = [this]() {
             state.currentScreen = Screen::PENDING_TASKS;
-            state.displayTasks = taskManager.getPendingTasks();
+            loadCurrentView();
         };
         
         actions["priority_tasks"] = [this]() {
             state.currentScreen = Screen::PRIORITY_TASKS;
-            state.displayTasks = taskManager.getTasksByPriority();
+            loadCurrentView();
         };
         
         actions["priority_tasks_all"] = [this]() {
             state.currentScreen = Screen::PRIORITY_TASKS;
-            vector<Task> allTasks = taskManager.getAllTasks();
-            sort(allTasks.begin(), allTasks.end(),
-                 [](const Task& a, const Task& b) { return a.priority < b.priority; });
-            state.displayTasks = allTasks;
+            loadCurrentView();
         };
         
         actions["priority_tasks_pending"] = [this]() {
@@ -245,28 +496,53 @@ private:
         };
         
         actions["sort_deadline"] = [this]() {
-            taskManager.sortByDeadline();
-            refreshCurrentView();
-            showStatusMessage("Tasks sorted by deadline!");
+            // Sorted on the worker; only the swap happens on the UI thread
+            struct SortResult {
+                uint64_t generation;
+                vector<TaskRecord> records;
+            };
+            submitQuery(
+                [this](const atomic<bool>& cancelled) {
+                    return SortResult{taskManager.getGeneration(), taskManager.sortedByDeadline(&cancelled)};
+                },
+                [this](SortResult& sorted) {
+                    bool applied = false;
+                    mutateEngine([&] { applied = taskManager.replaceOrder(sorted.records, sorted.generation); });
+                    if (applied) {
+                        refreshCurrentView();
+                        showStatusMessage("Tasks sorted by deadline!");
+                        writeThrough(daemonCommand(BatchOp::SORT));
+                    }
+                });
         };
         
         actions["undo"] = [this]() {
-            taskManager.undo();
+            if (!daemonInStep()) {
+                showStatusMessage("Another client changed the tasks; undo history starts over");
+                return;
+            }
+            bool undone = taskManager.canUndo();
+            mutateEngine([this] { taskManager.undo(); });
             refreshCurrentView();
             showStatusMessage("Undo completed!");
+            if (undone) writeThrough(daemonCommand(BatchOp::UNDO));
         };
         
         actions["redo"] = [this]() {
-            taskManager.redo();
+            if (!daemonInStep()) {
+                showStatusMessage("Another client changed the tasks; redo history starts over");
+                return;
+            }
+            bool redone = taskManager.canRedo();
+            mutateEngine([this] { taskManager.redo(); });
             refreshCurrentView();
             showStatusMessage("Redo completed!");
+            if (redone) writeThrough(daemonCommand(BatchOp::REDO));
         };
     }
     
-    void createButtons() {
-        buttons.clear();
-        
-        // Sidebar buttons - FIXED: Only create once, not every frame
+    // The sidebar is built once; later changes only flip widget flags
+    void createSidebarWidgets() {
         float y = HEADER_HEIGHT + 20;
         vector<pair<string, string>> menuItems = {
             {"Dashboard", "dashboard"},
@@ -276,6 +552,7 @@ private:
             {"Completed Tasks", "completed_tasks"},
             {"Search by Title", "search_title"},
             {"Search by Deadline", "search_deadline"},
+            {"Calendar", "calendar"},
             {"Priority View", "priority_tasks"},
             {"Top N Priority", "top_n_priority"},
             {"Priority Queue", "priority_queue"},
@@ -283,156 +560,447 @@ private:
         };
         
         for (const auto& [label, action] : menuItems) {
-            Button btn(label, Vector2f(240, 35), Vector2f(20, y), font, PRIMARY_COLOR);
+            Widget btn(label, Vector2f(240, 35), Vector2f(20, y), font, PRIMARY_COLOR);
             if (actions.find(action) != actions.end()) {
-                btn.onClick = actions[action];
+                btn.onClick = [this, onClick = actions[action]]() {
+                    state.scrollOffset = 0;     // every menu entry starts at the top of its list
+                    onClick();
+                };
             }
-            buttons.push_back(btn);
+            widgets.addStable(move(btn));
             y += 45;
         }
         
         // Undo/Redo buttons
         y += 20;
-        Button undoBtn("Undo", Vector2f(115, 35), Vector2f(20, y), font, WARNING_COLOR);
+        Widget undoBtn("Undo", Vector2f(115, 35), Vector2f(20, y), font, WARNING_COLOR);
         undoBtn.onClick = actions["undo"];
-        buttons.push_back(undoBtn);
+        undoWidget = widgets.addStable(move(undoBtn));
         
-        Button redoBtn("Redo", Vector2f(115, 35), Vector2f(145, y), font, WARNING_COLOR);
+        Widget redoBtn("Redo", Vector2f(115, 35), Vector2f(145, y), font, WARNING_COLOR);
         redoBtn.onClick = actions["redo"];
-        buttons.push_back(redoBtn);
+        redoWidget = widgets.addStable(move(redoBtn));
+    }
+    
+    // Undo and Redo are greyed out when there is nothing to undo or redo
+    void updateUndoRedoButtons() {
+        widgets.stableAt(undoWidget).enabled = taskManager.canUndo();
+        widgets.stableAt(redoWidget).enabled = taskManager.canRedo();
     }
     
     void handleInput(Event& event) {
+        TRACE_SCOPE("gui", "handleInput");
+        if (storeLoading) return;       // every action reads or writes the engine
         if (event.type == Event::MouseButtonPressed) {
             if (event.mouseButton.button == Mouse::Left) {
                 handleMouseClick(event.mouseButton.x, event.mouseButton.y);
+                invalidate(DIRTY_ALL);
+            }
+        }
+        else if (event.type == Event::MouseWheelScrolled) {
+            if (event.mouseWheelScroll.wheel == Mouse::VerticalWheel) {
+                scrollBy(-event.mouseWheelScroll.delta * TASK_ROW_HEIGHT);
             }
         }
         else if (event.type == Event::TextEntered) {
             handleTextInput(event);
+            invalidate(DIRTY_CONTENT);
         }
         else if (event.type == Event::KeyPressed) {
             if (event.key.code == Keyboard::Return) {
                 handleEnterKey();
+                invalidate(DIRTY_ALL);
             }
             else if (event.key.code == Keyboard::Escape) {
                 handleEscapeKey();
+                invalidate(DIRTY_ALL);
+            }
+            else if (event.key.code == Keyboard::F12) {
+                dumpTrace();
+            }
+            else if (event.key.code == Keyboard::F3) {
+                showProfiler = !showProfiler;
+                invalidate(DIRTY_ALL);
+            }
+            else if (event.key.code == Keyboard::F4) {
+                archiveCompletedTasks();
+                invalidate(DIRTY_ALL);
+            }
+            else if (!state.isTyping && state.currentScreen == Screen::CALENDAR &&
+                     (event.key.code == Keyboard::Left || event.key.code == Keyboard::Right)) {
+                changeCalendarYear(event.key.code == Keyboard::Left ? -1 : 1);
+            }
+            else if (!state.isTyping) {
+                float page = WINDOW_HEIGHT - HEADER_HEIGHT - TASK_ROW_HEIGHT;
+                if (event.key.code == Keyboard::PageDown) scrollBy(page);
+                else if (event.key.code == Keyboard::PageUp) scrollBy(-page);
+                else if (event.key.code == Keyboard::Down) scrollBy(TASK_ROW_HEIGHT);
+                else if (event.key.code == Keyboard::Up) scrollBy(-TASK_ROW_HEIGHT);
+                else if (event.key.code == Keyboard::Home) scrollBy(-state.scrollOffset);
+                else if (event.key.code == Keyboard::End) scrollBy(maxScrollOffset());
             }
         }
     }
     
+    // Screen y of the first task row when scrollOffset is 0
+    float listTop() const {
+        switch (state.currentScreen) {
+            case Screen::SEARCH_BY_TITLE:
+            case Screen::SEARCH_BY_DEADLINE:
+                return HEADER_HEIGHT + 190;
+            case Screen::PRIORITY_QUEUE:
+            case Screen::TOP_N_PRIORITY:
+                return HEADER_HEIGHT + 100;
+            case Screen::CALENDAR:
+                return HEADER_HEIGHT + 320;
+            default:
+                return HEADER_HEIGHT + 20;
+        }
+    }
+    
+    // Rows of the list on screen: the engine's, then the archived ones
+    size_t listedRows() const {
+        return state.displayList.size() + state.archiveRows.size(taskManager.getArchive());
+    }
+    
+    double maxScrollOffset() const {
+        double contentBottom = listTop() + double(listedRows()) * TASK_ROW_HEIGHT;
+        return max(0.0, contentBottom - WINDOW_HEIGHT + 20);
+    }
+    
+    void scrollBy(double delta) {
+        double offset = min(max(0.0, state.scrollOffset + delta), maxScrollOffset());
+        if (offset != state.scrollOffset) {
+            state.scrollOffset = offset;
+            invalidate(DIRTY_CONTENT);
+        }
+    }
+    
+    // Half-open range of listed rows whose card ends below clipTop and starts
+    // above the bottom of the window. Rows are a fixed height, so this is plain
+    // arithmetic on scrollOffset.
+    pair<size_t, size_t> visibleRows(float top, float clipTop) const {
+        double firstTop = top - state.scrollOffset;
+        double hiddenAbove = (clipTop - TASK_CARD_HEIGHT - firstTop) / TASK_ROW_HEIGHT;
+        double shownBelow = (WINDOW_HEIGHT - firstTop) / TASK_ROW_HEIGHT;
+        
+        size_t first = hiddenAbove < 0 ? 0 : size_t(hiddenAbove) + 1;
+        size_t last = shownBelow <= 0 ? 0 : size_t(ceil(shownBelow));
+        last = min(last, listedRows());
+        return {min(first, last), last};
+    }
+    
+    void drawTaskRows(float x, float top, float clipTop) {
+        auto [first, last] = visibleRows(top, clipTop);
+        float y = float(top - state.scrollOffset + double(first) * TASK_ROW_HEIGHT);
+        size_t engineRows = state.displayList.size();
+        for (size_t i = first; i < last; i++) {
+            if (i < engineRows) {
+                if (const TaskRecord* task = state.displayList.at(taskManager, i)) drawTaskCard(*task, x, y);
+            }
+            else if (const ArchivedTask* archived = archivedRow(i - engineRows)) {
+                drawTaskCard(archived->record, x, y, &archived->description);
+            }
+            y += TASK_ROW_HEIGHT;
+        }
+        frame.visibleRows += last - first;
+        
+        // Have the reader thread fetch the archive pages around the viewport
+        if (last > engineRows) {
+            size_t from = max(first, engineRows) - engineRows, to = last - engineRows;
+            if (state.archiveRows.all) {
+                taskManager.getArchive().readAhead(from, to, ARCHIVE_READ_AHEAD_PAGES);
+            }
+            else {
+                taskManager.getArchive().readAhead(state.archiveRows.rowAt(from),
+                                                   state.archiveRows.rowAt(to - 1) + 1, 0);
+            }
+        }
+    }
+    
+    // ------------------ Archived Rows ------------------
+    // Archived rows are read from the TaskArchive's page cache as they are
+    // drawn; the pages a frame draws from are held until the next frame, so
+    // the reader thread can evict them from the cache meanwhile.
+    static const size_t ARCHIVE_READ_AHEAD_PAGES = 4;       // each way, 1,024 rows
+    vector<pair<size_t, shared_ptr<const ArchivePage>>> pinnedPages;    // (page number, page)
+    
+    // The k-th archived row of the list, null if its page can't be read or
+    // is a copy from before the archive grew
+    const ArchivedTask* archivedRow(size_t k) {
+        size_t row = state.archiveRows.rowAt(k);
+        size_t number = row / TaskArchive::ROWS_PER_PAGE, slot = TaskArchive::slotOf(row);
+        for (const auto& [pinned, page] : pinnedPages) {
+            if (pinned == number) return slot < page->rows.size() ? &page->rows[slot] : nullptr;
+        }
+        shared_ptr<const ArchivePage> page = taskManager.getArchive().pageOf(row);
+        if (!page || slot >= page->rows.size()) return nullptr;
+        pinnedPages.emplace_back(number, move(page));
+        return &pinnedPages.back().second->rows[slot];
+    }
+    
+    // The archived part of a list: every archived task right away, or the ones
+    // the filter takes, scanned on the worker once the engine's rows are shown.
+    // Typing another character cancels the scan like any other query.
+    void loadArchiveRows(Screen screen, const DisplayFilter& filter) {
+        state.archiveRows = ArchiveRows();
+        if (!filter.withArchive || taskManager.getArchive().size() == 0) return;
+        if (!filter.acceptsArchived) {
+            state.archiveRows.all = true;
+            scrollBy(0);
+            return;
+        }
+        submitQuery(
+            [this, filter](const atomic<bool>& cancelled) {
+                return taskManager.getArchive().selectRows(filter.acceptsArchived, &cancelled);
+            },
+            [this, screen](vector<uint32_t>& rows) {
+                if (state.displayScreen != screen) return;
+                state.archiveRows.rows = move(rows);
+                invalidate(DIRTY_ALL);
+            });
+    }
+    
+    void archiveCompletedTasks() {
+        if (!taskManager.getArchive().isOpen()) {
+            showStatusMessage("No archive open (start with --archive FILE)");
+            return;
+        }
+        size_t moved = 0;
+        mutateEngine([&] { moved = taskManager.archiveCompleted(); });
+        pinnedPages.clear();            // the last page may have grown
+        refreshCurrentView();
+        showStatusMessage("Archived " + to_string(moved) + " completed tasks");
+    }
+    
+    // ------------------ Calendar ------------------
+    // A year of pending-task counts as a heatmap, one column per week. The
+    // counts come from the engine's per-day index on every draw, so the grid
+    // costs O(days in the year) however many tasks there are and is never
+    // behind a change. Clicking a day lists its tasks from the same index.
+    static const int CALENDAR_CELL = 14;
+    static const int CALENDAR_PITCH = 17;       // cell plus gap
+    vector<uint32_t> calendarCounts;            // scratch: [dayNumberOf(day) - dayNumberOf(Jan 1)]
+    
+    float calendarLeft() const { return SIDEBAR_WIDTH + 86; }
+    float calendarTop() const { return HEADER_HEIGHT + 110; }
+    
+    static int daysInMonth(int year, int month) {
+        static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        return month == 2 && leap ? 29 : days[month - 1];
+    }
+    
+    // 0 = Monday (Sakamoto's method)
+    static int weekdayOf(int year, int month, int day) {
+        static const int offsets[] = {0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4};
+        if (month < 3) year--;
+        int fromSunday = (year + year / 4 - year / 100 + year / 400 + offsets[month - 1] + day) % 7;
+        return (fromSunday + 6) % 7;
+    }
+    
+    // Day number of the selected day, NO_DEADLINE_KEY if there is none
+    uint32_t calendarSelection() const {
+        if (state.calendar.selectedDay == 0) return NO_DEADLINE_KEY;
+        return dayNumberOf(state.calendar.selectedYear, state.calendar.selectedMonth, state.calendar.selectedDay);
+    }
+    
+    Color heatColor(uint32_t count, uint32_t busiest) const {
+        if (count == 0) return Color(225, 228, 232);
+        static const Uint8 alpha[] = {0, 80, 140, 200, 255};
+        size_t level = (4 * size_t(count) + busiest - 1) / busiest;     // 1..4
+        Color color = PRIMARY_COLOR;
+        color.a = alpha[level];
+        return color;
+    }
+    
+    // Lists the selected day's tasks, straight from the deadline index
+    void showCalendarDay() {
+        vector<int> ids;
+        uint32_t day = calendarSelection();
+        if (day != NO_DEADLINE_KEY) ids = taskManager.tasksDueOn(day);
+        showDisplayList(Screen::CALENDAR, move(ids), taskManager.getGeneration(), filterFor(Screen::CALENDAR));
+    }
+    
+    void selectCalendarDay(int year, int month, int day) {
+        char date[16];
+        snprintf(date, sizeof(date), "%04d-%02d-%02d", year, month, day);
+        state.calendar.selectedYear = year;
+        state.calendar.selectedMonth = month;
+        state.calendar.selectedDay = day;
+        state.calendar.selectedDate = date;
+    }
+    
+    void changeCalendarYear(int delta) {
+        state.calendar.year += delta;
+        invalidate(DIRTY_CONTENT);
+    }
+    
+    // Year arrows, or a day cell: the cell is found by arithmetic on the grid
+    void handleCalendarClick(int x, int y) {
+        int year = state.calendar.year;
+        float arrowLeft = SIDEBAR_WIDTH + 50, arrowTop = HEADER_HEIGHT + 50;
+        if (y >= arrowTop - 4 && y < arrowTop + 28) {
+            if (x >= arrowLeft - 4 && x < arrowLeft + 20) changeCalendarYear(-1);
+            else if (x >= arrowLeft + 86 && x < arrowLeft + 110) changeCalendarYear(1);
+            return;
+        }
+        
+        float dx = x - calendarLeft(), dy = y - calendarTop();
+        if (dx < 0 || dy < 0) return;
+        int column = int(dx) / CALENDAR_PITCH, row = int(dy) / CALENDAR_PITCH;
+        if (row >= 7 || int(dx) % CALENDAR_PITCH >= CALENDAR_CELL || int(dy) % CALENDAR_PITCH >= CALENDAR_CELL) return;
+        
+        int dayOfYear = column * 7 + row - weekdayOf(year, 1, 1);
+        if (dayOfYear < 0) return;
+        int month = 1;
+        while (month <= 12 && dayOfYear >= daysInMonth(year, month)) dayOfYear -= daysInMonth(year, month++);
+        if (month > 12) return;
+        
+        selectCalendarDay(year, month, dayOfYear + 1);
+        state.selectedTaskId = -1;
+        state.scrollOffset = 0;
+        widgets.clearContext();
+        showCalendarDay();
+    }
+    
+    void dumpTrace() {
+        if (TraceBuffer::instance().dumpChromeJson(TRACE_FILE)) {
+            showStatusMessage("Trace written to " + TRACE_FILE);
+        }
+        else {
+            showStatusMessage("Failed to write " + TRACE_FILE);
+        }
+    }
+    
     void handleMouseClick(int x, int y) {
         Vector2i mousePos(x, y);
         
-        // Check button clicks
-        for (auto& button : buttons) {
-            if (button.isEnabled && button.contains(mousePos)) {
-                button.onClick();
-                return;
-            }
+        // Widgets first; the grid looks at only the ones near the click
+        if (widgets.click(x, y)) return;
+        
+        // The calendar grid sits above its task list
+        if (state.currentScreen == Screen::CALENDAR && y < listTop()) {
+            handleCalendarClick(x, y);
+            return;
         }
         
         // Check task list clicks
         if (state.currentScreen == Screen::VIEW_TASKS || 
             state.currentScreen == Screen::COMPLETED_TASKS ||
             state.currentScreen == Screen::PENDING_TASKS ||
-            state.currentScreen == Screen::PRIORITY_TASKS) {
+            state.currentScreen == Screen::PRIORITY_TASKS ||
+            state.currentScreen == Screen::CALENDAR) {
             handleTaskListClick(mousePos);
         }
     }
     
     void handleTaskListClick(Vector2i mousePos) {
-        float y = HEADER_HEIGHT + 20 - state.scrollOffset;
-        for (const auto& task : state.displayTasks) {
-            FloatRect taskBounds(SIDEBAR_WIDTH + 20, y, 
-                               WINDOW_WIDTH - SIDEBAR_WIDTH - 40, 80);
-            
-            if (taskBounds.contains(mousePos.x, mousePos.y)) {
-                state.selectedTaskId = task.id;
-                showTaskActions(task);
-                return;
-            }
-            y += 90;
+        // Row index straight from the click position; no walk over the list
+        float left = SIDEBAR_WIDTH + 20;
+        if (mousePos.x < left || mousePos.x >= left + CARD_WIDTH) return;
+        if (mousePos.y < HEADER_HEIGHT) return;
+        
+        double offset = mousePos.y - (listTop() - state.scrollOffset);
+        if (offset < 0) return;
+        size_t row = size_t(offset / TASK_ROW_HEIGHT);
+        double withinRow = offset - double(row) * TASK_ROW_HEIGHT;
+        if (row >= listedRows() || withinRow >= TASK_CARD_HEIGHT) return;
+        if (row >= state.displayList.size()) {
+            showStatusMessage("Archived tasks are read-only");
+            return;
         }
+        
+        const TaskRecord* record = state.displayList.at(taskManager, row);
+        if (record == nullptr) return;
+        const TaskRecord task = *record;
+        state.selectedTaskId = task.id;
+        showTaskActions(task);
     }
     
-    void showTaskActions(const Task& task) {
-        // Create action buttons for the selected task
-        createButtons(); // Recreate sidebar buttons
+    void showTaskActions(const TaskRecord& task) {
+        // Action buttons for the selected task; the sidebar stays as it is
+        widgets.clearContext();
         
         float x = SIDEBAR_WIDTH + 300;
         float y = HEADER_HEIGHT + 100;
         
         // Complete button
         if (!task.completed) {
-            Button completeBtn("Complete", Vector2f(100, 30), Vector2f(x, y), font, SUCCESS_COLOR);
+            Widget completeBtn("Complete", Vector2f(100, 30), Vector2f(x, y), font, SUCCESS_COLOR);
             completeBtn.onClick = [this, task]() {
-                taskManager.markTaskCompleted(task.id);
+                mutateEngine([&] { taskManager.markTaskCompleted(task.id); });
                 refreshCurrentView();
                 state.selectedTaskId = -1;
-                createButtons(); // Clear action buttons
+                widgets.clearContext();
                 showStatusMessage("Task completed!");
+                writeThrough(daemonCommand(BatchOp::COMPLETE, task.id));
             };
-            buttons.push_back(completeBtn);
+            widgets.addContextual(move(completeBtn));
         }
         
         // Edit button
         x += 120;
-        Button editBtn("Edit", Vector2f(100, 30), Vector2f(x, y), font, SECONDARY_COLOR);
+        Widget editBtn("Edit", Vector2f(100, 30), Vector2f(x, y), font, SECONDARY_COLOR);
         editBtn.onClick = [this, task]() {
             startEditingTask(task);
         };
-        buttons.push_back(editBtn);
+        widgets.addContextual(move(editBtn));
         
         // Delete button
         x += 120;
-        Button deleteBtn("Delete", Vector2f(100, 30), Vector2f(x, y), font, DANGER_COLOR);
+        Widget deleteBtn("Delete", Vector2f(100, 30), Vector2f(x, y), font, DANGER_COLOR);
         deleteBtn.onClick = [this, task]() {
-            taskManager.deleteTask(task.id);
+            mutateEngine([&] { taskManager.deleteTask(task.id); });
             refreshCurrentView();
             state.selectedTaskId = -1;
-            createButtons(); // Clear action buttons
+            widgets.clearContext();
             showStatusMessage("Task deleted!");
+            writeThrough(daemonCommand(BatchOp::DELETE, task.id));
         };
-        buttons.push_back(deleteBtn);
+        widgets.addContextual(move(deleteBtn));
         
         // Move to Tomorrow button
         y += 40;
         x = SIDEBAR_WIDTH + 300;
-        Button tomorrowBtn("Move to Tomorrow", Vector2f(150, 30), Vector2f(x, y), font, WARNING_COLOR);
+        Widget tomorrowBtn("Move to Tomorrow", Vector2f(150, 30), Vector2f(x, y), font, WARNING_COLOR);
         tomorrowBtn.onClick = [this, taskId = task.id]() {
             try {
                 moveTaskToTomorrow(taskId);
                 refreshCurrentView();
                 state.selectedTaskId = -1;
-                createButtons(); // Clear action buttons
+                widgets.clearContext();
                 showStatusMessage("Task moved to tomorrow!");
             } catch (const std::exception& e) {
                 showStatusMessage("Error moving task to tomorrow!");
             }
         };
-        buttons.push_back(tomorrowBtn);
+        widgets.addContextual(move(tomorrowBtn));
         
         // Update Priority button
         x += 170;
-        Button priorityBtn("Update Priority", Vector2f(150, 30), Vector2f(x, y), font, SECONDARY_COLOR);
+        Widget priorityBtn("Update Priority", Vector2f(150, 30), Vector2f(x, y), font, SECONDARY_COLOR);
         priorityBtn.onClick = [this, task]() {
             startPriorityUpdate(task);
         };
-        buttons.push_back(priorityBtn);
+        widgets.addContextual(move(priorityBtn));
         
         // Cancel button - NEW
         x += 170;
-        Button cancelBtn("Cancel", Vector2f(100, 30), Vector2f(x, y), font, Color(128, 128, 128));
+        Widget cancelBtn("Cancel", Vector2f(100, 30), Vector2f(x, y), font, Color(128, 128, 128));
         cancelBtn.onClick = [this]() {
             state.selectedTaskId = -1;
-            createButtons(); // Clear action buttons and return to normal sidebar
+            widgets.clearContext();
             showStatusMessage("Selection cancelled");
         };
-        buttons.push_back(cancelBtn);
+        widgets.addContextual(move(cancelBtn));
+        widgets.commitContext();
     }
     
-    void startEditingTask(const Task& task) {
+    void startEditingTask(const TaskRecord& record) {
+        Task task;
+        if (!taskManager.getTask(record.id, task)) return;
+        
         state.currentScreen = Screen::EDIT_TASK;
         state.editForm.isEditing = true;
         state.editForm.taskId = task.id;
@@ -445,7 +1013,7 @@ private:
         state.inputBuffer = task.title;
     }
     
-    void startPriorityUpdate(const Task& task) {
+    void startPriorityUpdate(const TaskRecord& task) {
         state.priorityUpdate.taskId = task.id;
         state.priorityUpdate.isUpdating = true;
         state.isTyping = true;
@@ -457,12 +1025,15 @@ private:
         try {
             int newPriority = stoi(state.inputBuffer);
             if (newPriority >= 1 && newPriority <= 10) {
-                Task* task = taskManager.getTask(state.priorityUpdate.taskId);
-                if (task) {
-                    taskManager.updateTask(task->id, task->title, task->description, 
-                                         task->deadline, newPriority);
+                Task task;
+                if (taskManager.getTask(state.priorityUpdate.taskId, task)) {
+                    mutateEngine([&] {
+                        taskManager.updatePriority(task.id, newPriority);
+                    });
                     refreshCurrentView();
                     showStatusMessage("Priority updated successfully!");
+                    task.priority = newPriority;
+                    writeThrough(daemonCommand(BatchOp::PRIO, task));
                 }
                 state.priorityUpdate.isUpdating = false;
                 state.isTyping = false;
@@ -478,12 +1049,24 @@ private:
     }
     
     void moveTaskToTomorrow(int taskId) {
-        Task* task = taskManager.getTask(taskId);
-        if (task) {
-            Date date(task->deadline);
+        Task task;
+        if (taskManager.getTask(taskId, task)) {
+            if (!Date::isValid(task.deadline)) {
+                showError("Task has no valid deadline");
+                return;
+            }
+            Date date(task.deadline);
             date.addDays(1);
-            taskManager.updateTask(taskId, task->title, task->description, 
-                                 date.toString(), task->priority);
+            if (!Date::isValid(date.toString())) {
+                showError("Deadline out of range");
+                return;
+            }
+            mutateEngine([&] {
+                taskManager.updateTask(taskId, task.title, task.description, 
+                                     date.toString(), task.priority);
+            });
+            task.deadline = date.toString();
+            writeThrough(daemonCommand(BatchOp::UPDATE, task));
         }
     }
     
@@ -497,6 +1080,13 @@ private:
         else if (event.text.unicode >= 32 && event.text.unicode < 128) {
             state.inputBuffer += static_cast<char>(event.text.unicode);
         }
+        else {
+            return;
+        }
+        
+        if (state.currentScreen == Screen::SEARCH_BY_TITLE && state.titleSearch.isSearching) {
+            scheduleLiveSearch();
+        }
     }
     
     void handleEnterKey() {
@@ -528,6 +1118,7 @@ private:
             state.currentScreen = Screen::VIEW_TASKS;
         }
         state.deadlineSearch.isSearching = false;
+        searchDue = false;
     }
     
     void handleAddTaskInput() {
@@ -545,7 +1136,7 @@ private:
                 break;
                 
             case 2: // Deadline
-                if (!isValidDate(state.inputBuffer)) {
+                if (!Date::isValid(state.inputBuffer)) {
                     showError("Invalid date format (YYYY-MM-DD)");
                     return;
                 }
@@ -562,17 +1153,25 @@ private:
                     state.addTaskForm.priority = priority;
                     
                     // All input received, create task
-                    taskManager.addTask(
-                        state.addTaskForm.title,
-                        state.addTaskForm.description,
-                        state.addTaskForm.deadline,
-                        state.addTaskForm.priority
-                    );
+                    int id = 0;
+                    mutateEngine([this, &id] {
+                        id = taskManager.addTask(
+                            state.addTaskForm.title,
+                            state.addTaskForm.description,
+                            state.addTaskForm.deadline,
+                            state.addTaskForm.priority
+                        );
+                    });
+                    BatchCommand added = daemonCommand(BatchOp::ADD,
+                        Task(id, state.addTaskForm.title, state.addTaskForm.description,
+                             state.addTaskForm.deadline, state.addTaskForm.priority));
                     
                     // Reset and return to dashboard
                     resetAddTaskForm();
                     state.currentScreen = Screen::DASHBOARD;
+                    refreshCurrentView();
                     showStatusMessage("Task added successfully!");
+                    writeThrough(added);
                     return;
                 }
                 catch (...) {
@@ -601,7 +1200,7 @@ private:
                 break;
                 
             case 2: // Deadline
-                if (!isValidDate(state.inputBuffer)) {
+                if (!Date::isValid(state.inputBuffer)) {
                     showError("Invalid date format (YYYY-MM-DD)");
                     return;
                 }
@@ -618,19 +1217,24 @@ private:
                     state.editForm.priority = priority;
                     
                     // All input received, update task
-                    taskManager.updateTask(
-                        state.editForm.taskId,
-                        state.editForm.title,
-                        state.editForm.description,
-                        state.editForm.deadline,
-                        state.editForm.priority
-                    );
+                    mutateEngine([this] {
+                        taskManager.updateTask(
+                            state.editForm.taskId,
+                            state.editForm.title,
+                            state.editForm.description,
+                            state.editForm.deadline,
+                            state.editForm.priority
+                        );
+                    });
                     
                     // Reset and return to view tasks
                     state.editForm.isEditing = false;
                     state.currentScreen = Screen::VIEW_TASKS;
                     refreshCurrentView();
                     showStatusMessage("Task updated successfully!");
+                    writeThrough(daemonCommand(BatchOp::UPDATE,
+                        Task(state.editForm.taskId, state.editForm.title, state.editForm.description,
+                             state.editForm.deadline, state.editForm.priority)));
                     return;
                 }
                 catch (...) {
@@ -654,31 +1258,23 @@ private:
     
     void performTitleSearch() {
         if (!state.inputBuffer.empty()) {
-            state.titleSearch.searchTitle = state.inputBuffer;
-            state.displayTasks = taskManager.searchTasks(state.titleSearch.searchTitle);
+            // Skips the rest of the debounce; usually the results are already up
+            runLiveSearch([this] { showStatusMessage("Search by title completed!"); });
             state.inputBuffer.clear();
             state.isTyping = false;
             state.titleSearch.isSearching = false;
-            showStatusMessage("Search by title completed!");
         }
     }
     
     void performDeadlineSearch() {
         if (!state.inputBuffer.empty()) {
             state.deadlineSearch.searchDate = state.inputBuffer;
-            vector<Task> allTasks = taskManager.getAllTasks();
-            state.displayTasks.clear();
-            
-            for (const auto& task : allTasks) {
-                if (task.deadline == state.deadlineSearch.searchDate) {
-                    state.displayTasks.push_back(task);
-                }
-            }
+            loadDisplayList(filterFor(Screen::SEARCH_BY_DEADLINE),
+                [this] { showStatusMessage("Search by deadline completed!"); });
             
             state.inputBuffer.clear();
             state.deadlineSearch.isSearching = false;
             state.isTyping = false;
-            showStatusMessage("Search by deadline completed!");
         }
     }
     
@@ -687,7 +1283,7 @@ private:
             int n = stoi(state.inputBuffer);
             if (n > 0 && n <= 50) {
                 state.priorityView.topN = n;
-                showTopNPriorityTasks(n);
+                showTopNPriorityTasks();
                 state.inputBuffer.clear();
                 state.isTyping = false;
                 state.priorityView.isInputting = false;
@@ -701,131 +1297,504 @@ private:
         }
     }
     
-    void showTopNPriorityTasks(int n) {
-        vector<Task> allTasks = taskManager.getPendingTasks();
-        sort(allTasks.begin(), allTasks.end(), 
-             [](const Task& a, const Task& b) { return a.priority < b.priority; });
-        
-        state.displayTasks.clear();
-        for (int i = 0; i < min(n, (int)allTasks.size()); i++) {
-            state.displayTasks.push_back(allTasks[i]);
-        }
-        
-        showStatusMessage("Showing top " + to_string(state.displayTasks.size()) + " priority tasks");
+    void showTopNPriorityTasks() {
+        loadDisplayList(filterFor(Screen::TOP_N_PRIORITY),
+            [this] { showStatusMessage("Showing top " + to_string(state.displayList.size()) + " priority tasks"); });
     }
     
     void showPriorityQueue() {
         // Show tasks in priority order (MinHeap simulation)
-        vector<Task> pendingTasks = taskManager.getPendingTasks();
-        sort(pendingTasks.begin(), pendingTasks.end(),
-             [](const Task& a, const Task& b) { return a.priority < b.priority; });
-        state.displayTasks = pendingTasks;
-        showStatusMessage("Priority Queue View - Tasks ordered by priority");
+        loadDisplayList(filterFor(Screen::PRIORITY_QUEUE),
+            [this] { showStatusMessage("Priority Queue View - Tasks ordered by priority"); });
     }
     
-    void showError(const string& message) {
-        state.addTaskForm.showError = true;
-        state.addTaskForm.errorMsg = message;
+    // ------------------ Background Queries ------------------
+    
+    // Every engine mutation from the UI thread goes through here. The running
+    // query is cancelled first (its result would be stale anyway), so waiting
+    // for its read lock takes at most one cancellation check interval.
+    template <class Mutation>
+    void mutateEngine(Mutation mutation) {
+        queries.cancel();
+        unique_lock<shared_mutex> lock(engineMutex);
+        mutation();
     }
     
-    void showStatusMessage(const string& message) {
-        state.statusMessage = message;
-        state.showStatusMessage = true;
+    // ------------------ Daemon Client ------------------
+    // Started with --connect, the GUI keeps a copy of todod's tasks, loaded
+    // the way a store is. It makes each change locally, then writes it through
+    // to the daemon in one frame with a request for the daemon's generation.
+    // If that is not the generation our change alone leads to, the daemon also
+    // ran another client's changes, refused ours or numbered an added task
+    // differently, and the copy is reloaded from it. So ids here are always the
+    // daemon's. The GUI also checks the generation every DAEMON_POLL_INTERVAL,
+    // so other clients' changes show up without a restart.
+    //
+    // Undo and redo run on the daemon's single history, which every client
+    // shares. They are only forwarded while nobody else has changed anything
+    // since our last write or reload; a reload drops our local history, which
+    // could otherwise undo someone else's change. A change that lands between
+    // that check and the undo itself is not caught. If the daemon goes away
+    // the GUI carries on with its own copy.
+    static BatchCommand daemonCommand(BatchOp op, const Task& task = Task()) {
+        BatchCommand command;
+        command.op = op;
+        command.id = task.id;
+        command.number = task.priority;
+        command.deadline = task.deadline;
+        command.text = task.title;
+        command.description = task.description;
+        return command;
     }
     
-    bool isValidDate(const string& date) {
-        if (date.length() != 10) return false;
-        if (date[4] != '-' || date[7] != '-') return false;
-        
-        try {
-            int year = stoi(date.substr(0, 4));
-            int month = stoi(date.substr(5, 2));
-            int day = stoi(date.substr(8, 2));
-            
-            return year >= 2024 && month >= 1 && month <= 12 && day >= 1 && day <= 31;
+    static BatchCommand daemonCommand(BatchOp op, int id) {
+        BatchCommand command;
+        command.op = op;
+        command.id = id;
+        return command;
+    }
+    
+    // The daemon's answer, such as the id it gave an added task; 0 if there is
+    // no daemon or it answered with nothing. Call after the local status
+    // message, so a failure here is what stays on screen. An ADD carries the
+    // id the task got here.
+    uint64_t writeThrough(const BatchCommand& command) {
+#ifdef TODO_DAEMON_CLIENT
+        if (!daemon.isConnected()) return 0;
+        BatchCommand commands[] = {command, daemonCommand(BatchOp::INFO)};
+        ResultCollector collected;
+        if (!daemon.call(commands, 2, collected)) {
+            showStatusMessage("Lost the connection to todod; changes now stay local");
+            return 0;
         }
-        catch (...) {
-            return false;
+        const RemoteResult& result = collected.results[0];
+        uint64_t answer = result.values.empty() ? 0 : result.values.front();
+        bool renumbered = command.op == BatchOp::ADD && answer != uint64_t(command.id);
+        if (result.failed || renumbered || collected.results[1].values[1] != daemonGeneration + 1) {
+            reloadFromDaemon();
+        }
+        else {
+            daemonGeneration++;
+            daemonPollAt = chrono::steady_clock::now() + DAEMON_POLL_INTERVAL;
         }
+        if (result.failed) showStatusMessage("todod: " + result.error);
+        return answer;
+#else
+        (void)command;
+        return 0;
+#endif
     }
     
-    void updateDashboard() {
-        auto allTasks = taskManager.getAllTasks();
-        auto pendingTasks = taskManager.getPendingTasks();
-        auto completedTasks = taskManager.getCompletedTasks();
-        
-        // Update display tasks with most recent tasks
-        state.displayTasks = allTasks;
-        if (state.displayTasks.size() > 5) {
-            state.displayTasks.resize(5);
+    // Whether our copy of the daemon's tasks is current; if not, reloads it
+    // and returns false. True when there is no daemon.
+    bool daemonInStep() {
+#ifdef TODO_DAEMON_CLIENT
+        if (!daemon.isConnected()) return true;
+        daemonPollAt = chrono::steady_clock::now() + DAEMON_POLL_INTERVAL;
+        BatchCommand info = daemonCommand(BatchOp::INFO);
+        ResultCollector collected;
+        if (!daemon.call(&info, 1, collected)) {
+            showStatusMessage("Lost the connection to todod; changes now stay local");
+            return true;
         }
+        if (collected.results[0].values[1] == daemonGeneration) return true;
+        reloadFromDaemon();
+        return false;
+#else
+        return true;
+#endif
     }
     
-    void refreshCurrentView() {
-        switch (state.currentScreen) {
-            case Screen::DASHBOARD:
-                updateDashboard();
-                break;
+#ifdef TODO_DAEMON_CLIENT
+    // Replaces our copy with the daemon's tasks, ids and next id, all read in
+    // one frame so they describe the same state
+    void reloadFromDaemon() {
+        TRACE_SCOPE("gui", "reloadFromDaemon");
+        daemonPollAt = chrono::steady_clock::now() + DAEMON_POLL_INTERVAL;
+        BatchCommand commands[] = {daemonCommand(BatchOp::EXPORT), daemonCommand(BatchOp::INFO)};
+        ResultCollector collected;
+        if (!daemon.call(commands, 2, collected)) {
+            showStatusMessage("Lost the connection to todod; changes now stay local");
+            return;
+        }
+        try {
+            mutateEngine([&] {
+                taskManager.replaceTasks(collected.results[0].rows);
+                taskManager.reserveIds(int(collected.results[1].values[0]));
+            });
+        }
+        catch (const invalid_argument& e) {
+            showStatusMessage(string("Failed to reload tasks from todod: ") + e.what());
+            return;
+        }
+        daemonGeneration = collected.results[1].values[1];
+        refreshCurrentView();
+    }
+#endif
+    
+    // Checks the daemon for other clients' changes once DAEMON_POLL_INTERVAL is up
+    void pollDaemon() {
+#ifdef TODO_DAEMON_CLIENT
+        if (!storeLoading && daemon.isConnected() && chrono::steady_clock::now() >= daemonPollAt) daemonInStep();
+#endif
+    }
+    
+    // Time until pollDaemon() has work; max() in local mode
+    chrono::steady_clock::duration untilDaemonPoll() const {
+#ifdef TODO_DAEMON_CLIENT
+        if (daemon.isConnected()) return daemonPollAt - chrono::steady_clock::now();
+#endif
+        return chrono::steady_clock::duration::max();
+    }
+    
+    // Runs query(cancelled) on the worker under a read lock, then apply(result)
+    // on the UI thread. Submitting again before it finishes supersedes it.
+    template <class Query, class Apply>
+    void submitQuery(Query query, Apply apply) {
+        queries.submit([this, query, apply](const atomic<bool>& cancelled) -> QueryWorker::Completion {
+            typedef decltype(query(cancelled)) Result;
+            shared_ptr<Result> result;
+            auto start = chrono::steady_clock::now();
+            {
+                shared_lock<shared_mutex> lock(engineMutex);
+                result = make_shared<Result>(query(cancelled));
+            }
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            return [this, apply, result, ms]() mutable {
+                lastQueryMs = ms;
+                apply(*result);
+            };
+        });
+        invalidate(DIRTY_CHROME);       // shows the searching indicator
+    }
+    
+    // ------------------ Display List ------------------
+    
+    // What each list screen shows. The filter travels with the loaded list, so
+    // later updates keep applying it even if the screen's inputs change.
+    DisplayFilter filterFor(Screen screen) {
+        DisplayFilter filter;
+        switch (screen) {
             case Screen::VIEW_TASKS:
-                state.displayTasks = taskManager.getAllTasks();
+                filter.withArchive = true;
                 break;
             case Screen::COMPLETED_TASKS:
-                state.displayTasks = taskManager.getCompletedTasks();
+                filter.accepts = [](const TaskRecord& task) { return task.completed; };
+                filter.withArchive = true;
                 break;
             case Screen::PENDING_TASKS:
-                state.displayTasks = taskManager.getPendingTasks();
+                filter.accepts = [](const TaskRecord& task) { return !task.completed; };
                 break;
             case Screen::PRIORITY_TASKS:
-                state.displayTasks = taskManager.getTasksByPriority();
+                filter.byPriority = true;
                 break;
             case Screen::PRIORITY_QUEUE:
-                showPriorityQueue();
+            case Screen::TOP_N_PRIORITY:
+                filter.accepts = [](const TaskRecord& task) { return !task.completed; };
+                filter.byPriority = true;
+                if (screen == Screen::TOP_N_PRIORITY) filter.limit = size_t(state.priorityView.topN);
+                break;
+            case Screen::SEARCH_BY_TITLE:
+                filter.accepts = [this, query = state.titleSearch.searchTitle](const TaskRecord& task) {
+                    return taskManager.taskMatches(task, query);
+                };
+                filter.withArchive = true;
+                filter.acceptsArchived = [query = state.titleSearch.searchTitle](const ArchivedTask& task) {
+                    return task.record.title.find(query) != string::npos ||
+                           task.description.find(query) != string::npos;
+                };
+                break;
+            case Screen::CALENDAR:
+                filter.accepts = [day = calendarSelection()](const TaskRecord& task) {
+                    return day != NO_DEADLINE_KEY && task.deadlineDay == day;
+                };
+                break;
+            case Screen::SEARCH_BY_DEADLINE:
+                filter.accepts = [day = deadlineDayNumber(state.deadlineSearch.searchDate)](const TaskRecord& task) {
+                    return day != NO_DEADLINE_KEY && task.deadlineDay == day;
+                };
+                filter.withArchive = true;
+                filter.acceptsArchived = [day = deadlineDayNumber(state.deadlineSearch.searchDate)](const ArchivedTask& task) {
+                    return day != NO_DEADLINE_KEY && task.record.deadlineDay == day;
+                };
                 break;
             default:
                 break;
         }
+        return filter;
     }
     
-    void drawScreen() {
-        window.clear(BG_COLOR);
-        
-        drawSidebar();
-        drawHeader();
+    void showDisplayList(Screen screen, vector<int> ids, uint64_t generation, DisplayFilter filter) {
+        loadArchiveRows(screen, filter);
+        state.displayList.assign(move(ids), generation, move(filter));
+        state.displayScreen = screen;
+        scrollBy(0);        // clamp to the new list length
+        invalidate(DIRTY_ALL);
+    }
+    
+    // Selects the filter's ids on the worker and shows them when they arrive
+    void loadDisplayList(DisplayFilter filter, function<void()> onLoaded = nullptr) {
+        struct Loaded {
+            vector<int> ids;
+            uint64_t generation;
+        };
+        Screen screen = state.currentScreen;
+        submitQuery(
+            [this, filter](const atomic<bool>& cancelled) {
+                Loaded loaded;
+                loaded.ids = taskManager.selectIds(
+                    [&filter](const TaskRecord& task) { return filter.admits(task); }, filter.byPriority, &cancelled);
+                if (loaded.ids.size() > filter.limit) loaded.ids.resize(filter.limit);
+                loaded.generation = taskManager.getGeneration();
+                return loaded;
+            },
+            [this, filter, screen, onLoaded](Loaded& loaded) {
+                showDisplayList(screen, move(loaded.ids), loaded.generation, filter);
+                if (onLoaded) onLoaded();
+            });
+    }
+    
+    // ------------------ Live Search ------------------
+    // The title search runs as the user types, SEARCH_DEBOUNCE after the last
+    // keystroke. Recent results are kept as match positions: a query that
+    // extends a cached one only re-checks the cached matches, and a query that
+    // is cached outright (typically after a backspace) skips both the debounce
+    // and the scan. Entries go stale with the engine generation.
+    
+    deque<shared_ptr<const SearchMatches>> searchCache;     // most recent last
+    bool searchDue = false;
+    chrono::steady_clock::time_point searchDueAt;
+    chrono::steady_clock::time_point searchTypedAt;         // oldest keystroke not yet on screen
+    
+    struct LiveSearchResult {
+        shared_ptr<const SearchMatches> matches;
+        vector<int> ids;
+    };
+    
+    shared_ptr<const SearchMatches> cachedSearch(const string& query) {
+        for (const auto& entry : searchCache) {
+            if (entry->query == query && entry->generation == taskManager.getGeneration()) return entry;
+        }
+        return nullptr;
+    }
+    
+    // The cached result that narrows `query` the most, if any
+    shared_ptr<const SearchMatches> searchSeed(const string& query) {
+        shared_ptr<const SearchMatches> seed;
+        for (const auto& entry : searchCache) {
+            if (taskManager.canRefine(*entry, query) &&
+                (!seed || entry->positions.size() < seed->positions.size())) {
+                seed = entry;
+            }
+        }
+        return seed;
+    }
+    
+    void rememberSearch(const shared_ptr<const SearchMatches>& matches) {
+        if (!matches->complete) return;
+        searchCache.erase(remove_if(searchCache.begin(), searchCache.end(),
+            [&](const shared_ptr<const SearchMatches>& entry) {
+                return entry->query == matches->query || entry->generation != matches->generation;
+            }), searchCache.end());
+        searchCache.push_back(matches);
+        if (searchCache.size() > SEARCH_CACHE_SIZE) searchCache.pop_front();
+    }
+    
+    void scheduleLiveSearch() {
+        auto now = chrono::steady_clock::now();
+        if (!searchDue) searchTypedAt = now;
+        searchDue = true;
+        searchDueAt = cachedSearch(state.inputBuffer) ? now : now + SEARCH_DEBOUNCE;
+    }
+    
+    void runLiveSearch(function<void()> onLoaded = nullptr) {
+        if (!searchDue) searchTypedAt = chrono::steady_clock::now();
+        searchDue = false;
+        if (state.currentScreen != Screen::SEARCH_BY_TITLE) return;
+        
+        string query = state.inputBuffer;
+        if (query.empty()) {
+            queries.cancel();
+            state.titleSearch.searchTitle.clear();
+            state.displayList.clear();
+            state.archiveRows = ArchiveRows();
+            scrollBy(0);
+            invalidate(DIRTY_CONTENT);
+            return;
+        }
         
+        shared_ptr<const SearchMatches> cached = cachedSearch(query);
+        shared_ptr<const SearchMatches> seed = cached ? nullptr : searchSeed(query);
+        submitQuery(
+            [this, query, cached, seed](const atomic<bool>& cancelled) {
+                LiveSearchResult result;
+                result.matches = cached ? cached
+                                        : make_shared<const SearchMatches>(taskManager.searchMatches(query, seed.get(), &cancelled));
+                result.ids = taskManager.idsAt(*result.matches);
+                return result;
+            },
+            [this, onLoaded](LiveSearchResult& result) {
+                if (state.currentScreen != Screen::SEARCH_BY_TITLE) return;
+                rememberSearch(result.matches);
+                state.titleSearch.searchTitle = result.matches->query;
+                showDisplayList(Screen::SEARCH_BY_TITLE, move(result.ids), result.matches->generation,
+                                filterFor(Screen::SEARCH_BY_TITLE));
+                
+                lastSearchLatencyMs = chrono::duration<double, milli>(chrono::steady_clock::now() - searchTypedAt).count();
+                TRACE_COUNTER("gui", "search latency us", uint64_t(lastSearchLatencyMs * 1000));
+                if (onLoaded) onLoaded();
+            });
+    }
+    
+    void showError(const string& message) {
+        state.addTaskForm.showError = true;
+        state.addTaskForm.errorMsg = message;
+    }
+    
+    void showStatusMessage(const string& message) {
+        state.statusMessage = message;
+        state.showStatusMessage = true;
+        statusHideAt = chrono::steady_clock::now() + STATUS_MESSAGE_DURATION;
+        invalidate(DIRTY_CHROME);
+    }
+    
+    void updateDashboard() {
+        // The first five tasks; the counts come straight from the engine
+        vector<int> ids;
+        for (const auto& task : taskManager.getTasks(0, 5)) ids.push_back(task.id);
+        DisplayFilter firstFive;
+        firstFive.limit = ids.size();
+        showDisplayList(Screen::DASHBOARD, move(ids), taskManager.getGeneration(), firstFive);
+    }
+    
+    // Loads the current screen's list from scratch
+    void loadCurrentView() {
+        invalidate(DIRTY_CONTENT);
         switch (state.currentScreen) {
             case Screen::DASHBOARD:
+                updateDashboard();
+                break;
+            case Screen::VIEW_TASKS:
+            case Screen::COMPLETED_TASKS:
+            case Screen::PENDING_TASKS:
+            case Screen::PRIORITY_TASKS:
+            case Screen::PRIORITY_QUEUE:
+                loadDisplayList(filterFor(state.currentScreen));
+                break;
+            case Screen::TOP_N_PRIORITY:
+                if (state.displayScreen == Screen::TOP_N_PRIORITY) loadDisplayList(filterFor(state.currentScreen));
+                break;
+            case Screen::SEARCH_BY_TITLE:
+                if (!state.titleSearch.searchTitle.empty()) loadDisplayList(filterFor(state.currentScreen));
+                break;
+            case Screen::SEARCH_BY_DEADLINE:
+                if (!state.deadlineSearch.searchDate.empty()) loadDisplayList(filterFor(state.currentScreen));
+                break;
+            case Screen::CALENDAR:
+                showCalendarDay();
+                break;
+            default:
+                break;
+        }
+    }
+    
+    // After a mutation: applies just the change to the list on screen, and
+    // only reloads if that is not possible
+    void refreshCurrentView() {
+        TRACE_SCOPE("gui", "refreshCurrentView");
+        if (state.displayScreen == state.currentScreen && state.displayList.update(taskManager)) {
+            scrollBy(0);
+            invalidate(DIRTY_CONTENT);
+        }
+        else {
+            loadCurrentView();
+        }
+    }
+    
+    void drawScreen() {
+        TRACE_SCOPE("gui", "drawScreen");
+        auto frameStart = chrono::steady_clock::now();
+        frameNumber++;
+        pinnedPages.clear();
+        surface().clear(BG_COLOR);
+        
+        if (storeLoading) {
+            drawLabel("Loading tasks…", 18, LIGHT_TEXT, SIDEBAR_WIDTH + 20, HEADER_HEIGHT + 20);
+        }
+        else switch (state.currentScreen) {
+            case Screen::DASHBOARD: {
+                TRACE_SCOPE("gui", "drawDashboard");
                 drawDashboard();
                 break;
-            case Screen::ADD_TASK:
+            }
+            case Screen::ADD_TASK: {
+                TRACE_SCOPE("gui", "drawAddTaskScreen");
                 drawAddTaskScreen();
                 break;
-            case Screen::EDIT_TASK:
+            }
+            case Screen::EDIT_TASK: {
+                TRACE_SCOPE("gui", "drawEditTaskScreen");
                 drawEditTaskScreen();
                 break;
+            }
             case Screen::VIEW_TASKS:
             case Screen::COMPLETED_TASKS:
             case Screen::PENDING_TASKS:
-            case Screen::PRIORITY_TASKS:
+            case Screen::PRIORITY_TASKS: {
+                TRACE_SCOPE("gui", "drawTaskList");
                 drawTaskList();
                 break;
-            case Screen::PRIORITY_QUEUE:
+            }
+            case Screen::PRIORITY_QUEUE: {
+                TRACE_SCOPE("gui", "drawPriorityQueueScreen");
                 drawPriorityQueueScreen();
                 break;
-            case Screen::SEARCH_BY_TITLE:
+            }
+            case Screen::SEARCH_BY_TITLE: {
+                TRACE_SCOPE("gui", "drawSearchByTitleScreen");
                 drawSearchByTitleScreen();
                 break;
-            case Screen::SEARCH_BY_DEADLINE:
+            }
+            case Screen::SEARCH_BY_DEADLINE: {
+                TRACE_SCOPE("gui", "drawSearchByDeadlineScreen");
                 drawSearchByDeadlineScreen();
                 break;
-            case Screen::TOP_N_PRIORITY:
+            }
+            case Screen::TOP_N_PRIORITY: {
+                TRACE_SCOPE("gui", "drawTopNPriorityScreen");
                 drawTopNPriorityScreen();
                 break;
-            case Screen::UPDATE_PRIORITY:
+            }
+            case Screen::UPDATE_PRIORITY: {
+                TRACE_SCOPE("gui", "drawUpdatePriorityScreen");
                 drawUpdatePriorityScreen();
                 break;
-            case Screen::SETTINGS:
+            }
+            case Screen::CALENDAR: {
+                TRACE_SCOPE("gui", "drawCalendarScreen");
+                drawCalendarScreen();
+                break;
+            }
+            case Screen::SETTINGS: {
+                TRACE_SCOPE("gui", "drawSettingsScreen");
                 drawSettingsScreen();
                 break;
+            }
+            default:
+                break;
+        }
+        
+        batch.flush(surface());
+        
+        // Chrome goes in a second batch so it covers rows scrolled under the
+        // header, and the status box and action buttons cover card text
+        drawSidebar();
+        drawHeader();
+        
+        // Searching indicator while a background query runs
+        drawnBusy = queries.busy();
+        if (drawnBusy) {
+            drawLabel("Searching…", 16, LIGHT_TEXT, WINDOW_WIDTH - 140, 20);
         }
         
         // Draw status message
@@ -833,46 +1802,69 @@ private:
             drawStatusMessage();
         }
         
-        // Draw all buttons
-        for (const auto& button : buttons) {
-            button.draw(window);
+        // Task action buttons; the sidebar ones are part of the sidebar layer
+        {
+            TRACE_SCOPE("gui", "drawButtons");
+            for (const Widget& widget : widgets.contextualWidgets()) widget.draw(batch);
         }
+        batch.flush(surface());
         
-        window.display();
+        if (showProfiler) {
+            auto overlayStart = chrono::steady_clock::now();
+            drawProfilerOverlay();
+            batch.flush(surface());
+            frame.overlayMs = chrono::duration<double, milli>(chrono::steady_clock::now() - overlayStart).count();
+        }
+        
+        trimCardCache();
+        frame.drawCalls = batch.takeDrawCalls();
+        auto displayStart = chrono::steady_clock::now();
+        frame.drawMs = chrono::duration<double, milli>(displayStart - frameStart).count();
+        
+        TRACE_SCOPE("gui", "window.display");
+        if (headless) canvas.display();
+        else window.display();
+        frame.displayMs = chrono::duration<double, milli>(chrono::steady_clock::now() - displayStart).count();
     }
     
     void drawSidebar() {
-        RectangleShape sidebar(Vector2f(SIDEBAR_WIDTH, WINDOW_HEIGHT));
-        sidebar.setFillColor(Color::White);
-        sidebar.setPosition(0, 0);
-        window.draw(sidebar);
+        TRACE_SCOPE("gui", "drawSidebar");
+        if (!storeLoading) updateUndoRedoButtons();
+        
+        // The sidebar's widgets only ever change their flags, so those are the layer's key
+        const vector<Widget>& sidebar = widgets.stableWidgets();
+        size_t enabledMask = 0, visibleMask = 0;
+        for (size_t i = 0; i < sidebar.size(); i++) {
+            if (sidebar[i].enabled) enabledMask |= size_t(1) << i;
+            if (sidebar[i].visible) visibleMask |= size_t(1) << i;
+        }
         
-        // Logo
-        Text logo;
-        logo.setFont(font);
-        logo.setString("Task Manager Pro");
-        logo.setCharacterSize(20);
-        logo.setFillColor(PRIMARY_COLOR);
-        logo.setPosition(20, 20);
-        window.draw(logo);
+        if (layerStale(sidebarLayer, {sidebar.size(), enabledMask, visibleMask})) {
+            TRACE_SCOPE("gui", "renderSidebarLayer");
+            sidebarLayer.texture.clear(Color::White);
+            
+            // Logo
+            drawLabel("Task Manager Pro", 20, PRIMARY_COLOR, 20, 20);
+            for (const Widget& widget : sidebar) widget.draw(batch);
+            finishLayer(sidebarLayer);
+        }
+        batch.drawNow(surface(), sidebarLayer.sprite);
     }
     
     void drawHeader() {
-        RectangleShape header(Vector2f(WINDOW_WIDTH - SIDEBAR_WIDTH, HEADER_HEIGHT));
-        header.setFillColor(Color::White);
-        header.setPosition(SIDEBAR_WIDTH, 0);
-        window.draw(header);
-        
-        Text title;
-        title.setFont(font);
-        title.setString(getScreenTitle());
-        title.setCharacterSize(20);
-        title.setFillColor(TEXT_COLOR);
-        title.setPosition(SIDEBAR_WIDTH + 20, 20);
-        window.draw(title);
+        TRACE_SCOPE("gui", "drawHeader");
+        const char* title = getScreenTitle();
+        
+        if (layerStale(headerLayer, {size_t(title), 0, 0})) {        // titles are string literals, so the address identifies them
+            TRACE_SCOPE("gui", "renderHeaderLayer");
+            headerLayer.texture.clear(Color::White);
+            drawText(labels, "screenTitle", title, 20, TEXT_COLOR, 20, 20);
+            finishLayer(headerLayer);
+        }
+        batch.drawNow(surface(), headerLayer.sprite);
     }
     
-    string getScreenTitle() const {
+    const char* getScreenTitle() const {
         switch (state.currentScreen) {
             case Screen::DASHBOARD: return "Dashboard";
             case Screen::ADD_TASK: return "Add New Task";
@@ -886,6 +1878,7 @@ private:
             case Screen::TOP_N_PRIORITY: return "Top N Priority Tasks";
             case Screen::PRIORITY_QUEUE: return "Priority Queue";
             case Screen::UPDATE_PRIORITY: return "Update Priority";
+            case Screen::CALENDAR: return "Deadline Calendar";
             case Screen::SETTINGS: return "Settings";
             default: return "";
         }
@@ -896,161 +1889,80 @@ private:
         float x = SIDEBAR_WIDTH + 20;
         float y = HEADER_HEIGHT + 20;
         
-        // Statistics
-        drawStatCard("Total Tasks", to_string(taskManager.getAllTasks().size()), x, y);
-        drawStatCard("Pending", to_string(taskManager.getPendingTasks().size()), x + 220, y);
-        drawStatCard("Completed", to_string(taskManager.getCompletedTasks().size()), x + 440, y);
+        // Statistics, drawn into their layer at a one pixel margin
+        size_t archived = taskManager.getArchive().size();
+        size_t total = taskManager.getTaskCount() + archived;
+        size_t pending = taskManager.getPendingCount();
+        size_t completed = taskManager.getCompletedCount() + archived;
+        if (layerStale(statsLayer, {total, pending, completed})) {
+            TRACE_SCOPE("gui", "renderStatsLayer");
+            statsLayer.texture.clear(BG_COLOR);
+            drawStatCard("Total Tasks", total, 1, 1);
+            drawStatCard("Pending", pending, 221, 1);
+            drawStatCard("Completed", completed, 441, 1);
+            finishLayer(statsLayer);
+        }
+        batch.drawNow(surface(), statsLayer.sprite);
         
         // Recent Tasks
         y += 180;
-        Text recentTitle;
-        recentTitle.setFont(font);
-        recentTitle.setString("Recent Tasks");
-        recentTitle.setCharacterSize(18);
-        recentTitle.setFillColor(TEXT_COLOR);
-        recentTitle.setPosition(x, y);
-        window.draw(recentTitle);
+        drawLabel("Recent Tasks", 18, TEXT_COLOR, x, y);
         
         y += 40;
-        for (const auto& task : state.displayTasks) {
-            drawTaskCard(task, x, y);
-            y += 90;
-        }
-    }
-    
-    void drawStatCard(const string& label, const string& value, float x, float y) {
-        RectangleShape card(Vector2f(200, 100));
-        card.setPosition(x, y);
-        card.setFillColor(Color::White);
-        card.setOutlineColor(Color(200, 200, 200));
-        card.setOutlineThickness(1);
-        window.draw(card);
-        
-        Text valueText;
-        valueText.setFont(font);
-        valueText.setString(value);
-        valueText.setCharacterSize(32);
-        valueText.setFillColor(PRIMARY_COLOR);
-        valueText.setPosition(x + 20, y + 20);
-        window.draw(valueText);
-        
-        Text labelText;
-        labelText.setFont(font);
-        labelText.setString(label);
-        labelText.setCharacterSize(16);
-        labelText.setFillColor(LIGHT_TEXT);
-        labelText.setPosition(x + 20, y + 60);
-        window.draw(labelText);
-    }
-    
-    void drawTaskCard(const Task& task, float x, float y) {
-        RectangleShape card(Vector2f(WINDOW_WIDTH - SIDEBAR_WIDTH - 40, 80));
-        card.setPosition(x, y);
-        card.setFillColor(Color::White);
-        card.setOutlineColor(Color(200, 200, 200));
-        card.setOutlineThickness(1);
-        
-        if (task.id == state.selectedTaskId) {
-            card.setOutlineColor(PRIMARY_COLOR);
-            card.setOutlineThickness(2);
-        }
-        
-        window.draw(card);
-        
-        // Title
-        Text titleText;
-        titleText.setFont(font);
-        titleText.setString(task.title);
-        titleText.setCharacterSize(16);
-        titleText.setFillColor(TEXT_COLOR);
-        titleText.setPosition(x + 20, y + 15);
-        window.draw(titleText);
-        
-        // Description
-        Text descText;
-        descText.setFont(font);
-        string desc = task.description;
-        if (desc.length() > 50) {
-            desc = desc.substr(0, 47) + "...";
+        for (size_t i = 0; i < state.displayList.size(); i++) {
+            if (const TaskRecord* task = state.displayList.at(taskManager, i)) {
+                drawTaskCard(*task, x, y);
+                y += TASK_ROW_HEIGHT;
+            }
         }
-        descText.setString(desc);
-        descText.setCharacterSize(14);
-        descText.setFillColor(LIGHT_TEXT);
-        descText.setPosition(x + 20, y + 40);
-        window.draw(descText);
-        
-        // Deadline
-        Text deadlineText;
-        deadlineText.setFont(font);
-        deadlineText.setString("Due: " + task.deadline);
-        deadlineText.setCharacterSize(14);
-        deadlineText.setFillColor(LIGHT_TEXT);
-        deadlineText.setPosition(x + 400, y + 15);
-        window.draw(deadlineText);
-        
-        // Priority
-        drawPriorityIndicator(task.priority, x + card.getSize().x - 120, y + 15);
+        frame.visibleRows += state.displayList.size();
+    }
+    
+    void drawStatCard(const char* label, size_t value, float x, float y) {
+        batch.outlinedRect(x, y, 200, 100, Color::White, Color(200, 200, 200), 1);
         
-        // Status
-        if (task.completed) {
-            CircleShape checkmark(8);
-            checkmark.setFillColor(SUCCESS_COLOR);
-            checkmark.setPosition(x + card.getSize().x - 30, y + 15);
-            window.draw(checkmark);
-            
-            Text completedText;
-            completedText.setFont(font);
-            completedText.setString("✓");
-            completedText.setCharacterSize(14);
-            completedText.setFillColor(Color::White);
-            completedText.setPosition(x + card.getSize().x - 26, y + 17);
-            window.draw(completedText);
-        }
+        drawText(values, label, to_string(value), 32, PRIMARY_COLOR, x + 20, y + 20);
+        drawLabel(label, 16, LIGHT_TEXT, x + 20, y + 60);
     }
     
-    void drawPriorityIndicator(int priority, float x, float y) {
-        CircleShape indicator(8);
-        indicator.setPosition(x, y);
+    void drawTaskCard(const TaskRecord& task, float x, float y, const string* description = nullptr) {
+        const CardCache& card = cachedCard(task, description);
+        bool selected = task.id == state.selectedTaskId;
+        batch.outlinedRect(x, y, CARD_WIDTH, TASK_CARD_HEIGHT, Color::White,
+                           selected ? PRIMARY_COLOR : Color(200, 200, 200), selected ? 2 : 1);
         
-        if (priority <= 3) indicator.setFillColor(DANGER_COLOR);
-        else if (priority <= 7) indicator.setFillColor(WARNING_COLOR);
-        else indicator.setFillColor(SUCCESS_COLOR);
+        batch.glyphs(card.title, x + 20, y + 15);
+        batch.glyphs(card.description, x + 20, y + 40);
+        batch.glyphs(card.deadline, x + 400, y + 15);
         
-        window.draw(indicator);
+        // Priority
+        batch.circle(x + CARD_WIDTH - 120, y + 15, 8, card.indicatorColor);
+        batch.glyphs(card.priority, x + CARD_WIDTH - 100, y + 11);
         
-        Text priorityText;
-        priorityText.setFont(font);
-        priorityText.setString("P" + to_string(priority));
-        priorityText.setCharacterSize(14);
-        priorityText.setFillColor(LIGHT_TEXT);
-        priorityText.setPosition(x + 20, y - 4);
-        window.draw(priorityText);
+        // Status
+        if (task.completed) {
+            batch.circle(x + CARD_WIDTH - 30, y + 15, 8, SUCCESS_COLOR);
+            batch.glyphs(checkmarkRun, x + CARD_WIDTH - 26, y + 17);
+        }
     }
     
     void drawAddTaskScreen() {
         float x = SIDEBAR_WIDTH + 50;
         float y = HEADER_HEIGHT + 50;
         
-        vector<pair<string, string*>> fields = {
-            {"Title", &state.addTaskForm.title},
-            {"Description", &state.addTaskForm.description},
-            {"Deadline (YYYY-MM-DD)", &state.addTaskForm.deadline}
-        };
+        const char* fieldLabels[] = {"Title", "Description", "Deadline (YYYY-MM-DD)"};
+        const string* fieldValues[] = {&state.addTaskForm.title, &state.addTaskForm.description, &state.addTaskForm.deadline};
         
-        for (size_t i = 0; i < fields.size(); i++) {
-            drawInputField(fields[i].first, *fields[i].second,
+        for (int i = 0; i < 3; i++) {
+            drawInputField(fieldLabels[i], *fieldValues[i],
                          x, y, i == state.addTaskForm.step);
             y += 80;
         }
         
         // Priority
-        Text priorityLabel;
-        priorityLabel.setFont(font);
-        priorityLabel.setString("Priority (1-10): " + to_string(state.addTaskForm.priority));
-        priorityLabel.setCharacterSize(16);
-        priorityLabel.setFillColor(TEXT_COLOR);
-        priorityLabel.setPosition(x, y);
-        window.draw(priorityLabel);
+        scratch.assign("Priority (1-10): ");
+        scratch += to_string(state.addTaskForm.priority);
+        drawText(labels, "priorityLabel", scratch, 16, TEXT_COLOR, x, y);
         
         if (state.addTaskForm.step == 3) {
             drawInputField("Priority", state.inputBuffer, x, y + 30, true);
@@ -1058,13 +1970,7 @@ private:
         
         // Error message
         if (state.addTaskForm.showError) {
-            Text errorText;
-            errorText.setFont(font);
-            errorText.setString(state.addTaskForm.errorMsg);
-            errorText.setCharacterSize(14);
-            errorText.setFillColor(DANGER_COLOR);
-            errorText.setPosition(x, y + 100);
-            window.draw(errorText);
+            drawText(labels, "addTaskError", state.addTaskForm.errorMsg, 14, DANGER_COLOR, x, y + 100);
         }
     }
     
@@ -1072,56 +1978,39 @@ private:
         float x = SIDEBAR_WIDTH + 50;
         float y = HEADER_HEIGHT + 50;
         
-        vector<pair<string, string*>> fields = {
-            {"Title", &state.editForm.title},
-            {"Description", &state.editForm.description},
-            {"Deadline (YYYY-MM-DD)", &state.editForm.deadline}
-        };
+        const char* fieldLabels[] = {"Title", "Description", "Deadline (YYYY-MM-DD)"};
+        const string* fieldValues[] = {&state.editForm.title, &state.editForm.description, &state.editForm.deadline};
         
-        for (size_t i = 0; i < fields.size(); i++) {
-            drawInputField(fields[i].first, *fields[i].second,
+        for (int i = 0; i < 3; i++) {
+            drawInputField(fieldLabels[i], *fieldValues[i],
                          x, y, i == state.editForm.step);
             y += 80;
         }
         
         // Priority
-        Text priorityLabel;
-        priorityLabel.setFont(font);
-        priorityLabel.setString("Priority (1-10): " + to_string(state.editForm.priority));
-        priorityLabel.setCharacterSize(16);
-        priorityLabel.setFillColor(TEXT_COLOR);
-        priorityLabel.setPosition(x, y);
-        window.draw(priorityLabel);
+        scratch.assign("Priority (1-10): ");
+        scratch += to_string(state.editForm.priority);
+        drawText(labels, "priorityLabel", scratch, 16, TEXT_COLOR, x, y);
         
         if (state.editForm.step == 3) {
             drawInputField("Priority", state.inputBuffer, x, y + 30, true);
         }
     }
     
-    void drawInputField(const string& label, const string& value,
+    void drawInputField(const char* label, const string& value,
                        float x, float y, bool isActive) {
-        Text labelText;
-        labelText.setFont(font);
-        labelText.setString(label);
-        labelText.setCharacterSize(16);
-        labelText.setFillColor(TEXT_COLOR);
-        labelText.setPosition(x, y);
-        window.draw(labelText);
-        
-        RectangleShape field(Vector2f(500, 40));
-        field.setPosition(x, y + 25);
-        field.setFillColor(Color::White);
-        field.setOutlineColor(isActive ? PRIMARY_COLOR : LIGHT_TEXT);
-        field.setOutlineThickness(1);
-        window.draw(field);
-        
-        Text valueText;
-        valueText.setFont(font);
-        valueText.setString(isActive ? state.inputBuffer + "|" : value);
-        valueText.setCharacterSize(16);
-        valueText.setFillColor(TEXT_COLOR);
-        valueText.setPosition(x + 10, y + 35);
-        window.draw(valueText);
+        drawLabel(label, 16, TEXT_COLOR, x, y);
+        
+        batch.outlinedRect(x, y + 25, 500, 40, Color::White, isActive ? PRIMARY_COLOR : LIGHT_TEXT, 1);
+        
+        if (isActive) {
+            scratch.assign(state.inputBuffer);
+            scratch += '|';
+            drawText(values, label, scratch, 16, TEXT_COLOR, x + 10, y + 35);
+        }
+        else {
+            drawText(values, label, value, 16, TEXT_COLOR, x + 10, y + 35);
+        }
     }
     
     void drawTaskList() {
@@ -1129,11 +2018,8 @@ private:
         float y = HEADER_HEIGHT + 20 - state.scrollOffset;
         
         // Check if there are no tasks to display
-        if (state.displayTasks.empty()) {
-            Text noTasksText;
-            noTasksText.setFont(font);
-            
-            string message;
+        if (listedRows() == 0) {
+            const char* message;
             switch (state.currentScreen) {
                 case Screen::COMPLETED_TASKS:
                     message = "No completed tasks to show";
@@ -1162,20 +2048,11 @@ private:
                     break;
             }
             
-            noTasksText.setString(message);
-            noTasksText.setCharacterSize(18);
-            noTasksText.setFillColor(LIGHT_TEXT);
-            noTasksText.setPosition(x + 50, y + 100);
-            window.draw(noTasksText);
+            drawLabel(message, 18, LIGHT_TEXT, x + 50, y + 100);
             return;
         }
         
-        for (const auto& task : state.displayTasks) {
-            if (y + 80 > HEADER_HEIGHT && y < WINDOW_HEIGHT) {
-                drawTaskCard(task, x, y);
-            }
-            y += 90;
-        }
+        drawTaskRows(x, listTop(), HEADER_HEIGHT);
     }
     
     // NEW DRAWING FUNCTIONS
@@ -1187,28 +2064,19 @@ private:
         drawInputField("Search by Title", state.titleSearch.searchTitle, x, y, state.isTyping);
         
         y += 100;
-        if (state.displayTasks.empty() && !state.titleSearch.searchTitle.empty()) {
-            Text noResultsText;
-            noResultsText.setFont(font);
-            noResultsText.setString("No tasks found matching '" + state.titleSearch.searchTitle + "'");
-            noResultsText.setCharacterSize(16);
-            noResultsText.setFillColor(LIGHT_TEXT);
-            noResultsText.setPosition(x, y);
-            window.draw(noResultsText);
-        } else if (!state.displayTasks.empty()) {
-            Text resultsText;
-            resultsText.setFont(font);
-            resultsText.setString("Search Results: (" + to_string(state.displayTasks.size()) + " found)");
-            resultsText.setCharacterSize(18);
-            resultsText.setFillColor(TEXT_COLOR);
-            resultsText.setPosition(x, y);
-            window.draw(resultsText);
+        if (listedRows() == 0 && !state.titleSearch.searchTitle.empty()) {
+            scratch.assign("No tasks found matching '");
+            scratch += state.titleSearch.searchTitle;
+            scratch += '\'';
+            drawText(labels, "noResults", scratch, 16, LIGHT_TEXT, x, y);
+        } else if (listedRows() > 0) {
+            scratch.assign("Search Results: (");
+            scratch += to_string(listedRows());
+            scratch += " found)";
+            drawText(labels, "results", scratch, 18, TEXT_COLOR, x, y);
             
-            y += 40;
-            for (const auto& task : state.displayTasks) {
-                drawTaskCard(task, x, y);
-                y += 90;
-            }
+            // Rows scroll underneath the results label, so clip at the list top
+            drawTaskRows(x, listTop(), listTop() + TASK_CARD_HEIGHT);
         }
     }
     
@@ -1219,30 +2087,92 @@ private:
         drawInputField("Search by Deadline (YYYY-MM-DD)", state.deadlineSearch.searchDate, x, y, state.isTyping);
         
         y += 100;
-        if (state.displayTasks.empty() && !state.deadlineSearch.searchDate.empty()) {
-            Text noResultsText;
-            noResultsText.setFont(font);
-            noResultsText.setString("No tasks found for date: " + state.deadlineSearch.searchDate);
-            noResultsText.setCharacterSize(16);
-            noResultsText.setFillColor(LIGHT_TEXT);
-            noResultsText.setPosition(x, y);
-            window.draw(noResultsText);
-        }
-        else if (!state.displayTasks.empty()) {
-            Text resultsText;
-            resultsText.setFont(font);
-            resultsText.setString("Tasks due on " + state.deadlineSearch.searchDate + ": (" + to_string(state.displayTasks.size()) + " found)");
-            resultsText.setCharacterSize(18);
-            resultsText.setFillColor(TEXT_COLOR);
-            resultsText.setPosition(x, y);
-            window.draw(resultsText);
+        if (listedRows() == 0 && !state.deadlineSearch.searchDate.empty()) {
+            scratch.assign("No tasks found for date: ");
+            scratch += state.deadlineSearch.searchDate;
+            drawText(labels, "noResults", scratch, 16, LIGHT_TEXT, x, y);
+        }
+        else if (listedRows() > 0) {
+            scratch.assign("Tasks due on ");
+            scratch += state.deadlineSearch.searchDate;
+            scratch += ": (";
+            scratch += to_string(listedRows());
+            scratch += " found)";
+            drawText(labels, "results", scratch, 18, TEXT_COLOR, x, y);
             
-            y += 40;
-            for (const auto& task : state.displayTasks) {
-                drawTaskCard(task, x, y);
-                y += 90;
+            // Rows scroll underneath the results label, so clip at the list top
+            drawTaskRows(x, listTop(), listTop() + TASK_CARD_HEIGHT);
+        }
+    }
+    
+    void drawCalendarScreen() {
+        float x = SIDEBAR_WIDTH + 50;
+        float y = HEADER_HEIGHT + 50;
+        int year = state.calendar.year;
+        
+        drawLabel("<", 20, PRIMARY_COLOR, x, y);
+        drawText(values, "calendarYear", to_string(year), 20, TEXT_COLOR, x + 30, y);
+        drawLabel(">", 20, PRIMARY_COLOR, x + 90, y);
+        
+        // One lookup per day of the year in the engine's per-day counts
+        uint32_t firstDay = dayNumberOf(year, 1, 1);
+        taskManager.pendingPerDay(firstDay, dayNumberOf(year, 12, 31), calendarCounts);
+        uint32_t busiest = 0;
+        size_t pendingInYear = 0;
+        for (uint32_t count : calendarCounts) {
+            busiest = max(busiest, count);
+            pendingInYear += count;
+        }
+        
+        float left = calendarLeft(), top = calendarTop();
+        drawLabel("Mon", 12, LIGHT_TEXT, x, top);
+        drawLabel("Wed", 12, LIGHT_TEXT, x, top + 2 * CALENDAR_PITCH);
+        drawLabel("Fri", 12, LIGHT_TEXT, x, top + 4 * CALENDAR_PITCH);
+        
+        static const char* months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                       "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+        uint32_t selected = calendarSelection();
+        int weekday = weekdayOf(year, 1, 1), column = 0;
+        for (int month = 1; month <= 12; month++) {
+            drawLabel(months[month - 1], 12, LIGHT_TEXT, left + column * CALENDAR_PITCH, top - 20);
+            for (int day = 1; day <= daysInMonth(year, month); day++) {
+                uint32_t number = dayNumberOf(year, month, day);
+                float cellX = left + column * CALENDAR_PITCH, cellY = top + weekday * CALENDAR_PITCH;
+                Color fill = heatColor(calendarCounts[number - firstDay], busiest);
+                if (number == selected) batch.outlinedRect(cellX, cellY, CALENDAR_CELL, CALENDAR_CELL, fill, TEXT_COLOR, 2);
+                else batch.rect(cellX, cellY, CALENDAR_CELL, CALENDAR_CELL, fill);
+                if (++weekday == 7) {
+                    weekday = 0;
+                    column++;
+                }
             }
         }
+        
+        // Legend and the year's total
+        y = top + 7 * CALENDAR_PITCH + 12;
+        drawLabel("Less", 12, LIGHT_TEXT, left, y);
+        for (uint32_t level = 0; level <= 4; level++) {
+            batch.rect(left + 36 + level * CALENDAR_PITCH, y + 2, CALENDAR_CELL, CALENDAR_CELL, heatColor(level, 4));
+        }
+        drawLabel("More", 12, LIGHT_TEXT, left + 40 + 5 * CALENDAR_PITCH, y);
+        scratch.assign(to_string(pendingInYear));
+        scratch += " pending tasks due in ";
+        scratch += to_string(year);
+        drawText(values, "calendarTotal", scratch, 14, TEXT_COLOR, left + 200, y);
+        
+        // The selected day's tasks
+        y = listTop() - 40;
+        if (state.calendar.selectedDay == 0) {
+            drawLabel("Click a day to list its tasks", 16, LIGHT_TEXT, x, y);
+            return;
+        }
+        scratch.assign("Tasks due on ");
+        scratch += state.calendar.selectedDate;
+        scratch += ": (";
+        scratch += to_string(listedRows());
+        scratch += " found)";
+        drawText(labels, "calendarDay", scratch, 18, TEXT_COLOR, x, y);
+        drawTaskRows(SIDEBAR_WIDTH + 20, listTop(), listTop() + TASK_CARD_HEIGHT);
     }
     
     void drawTopNPriorityScreen() {
@@ -1253,29 +2183,17 @@ private:
             drawInputField("Enter number of top priority tasks to show", "", x, y, state.isTyping);
         }
         else {
-            Text titleText;
-            titleText.setFont(font);
-            titleText.setString("Top " + to_string(state.priorityView.topN) + " Priority Tasks");
-            titleText.setCharacterSize(20);
-            titleText.setFillColor(TEXT_COLOR);
-            titleText.setPosition(x, y);
-            window.draw(titleText);
+            scratch.assign("Top ");
+            scratch += to_string(state.priorityView.topN);
+            scratch += " Priority Tasks";
+            drawText(labels, "topNTitle", scratch, 20, TEXT_COLOR, x, y);
             
             y += 50;
-            if (state.displayTasks.empty()) {
-                Text noTasksText;
-                noTasksText.setFont(font);
-                noTasksText.setString("No priority tasks to show");
-                noTasksText.setCharacterSize(16);
-                noTasksText.setFillColor(LIGHT_TEXT);
-                noTasksText.setPosition(x, y);
-                window.draw(noTasksText);
+            if (state.displayList.empty()) {
+                drawLabel("No priority tasks to show", 16, LIGHT_TEXT, x, y);
             }
             else {
-                for (const auto& task : state.displayTasks) {
-                    drawTaskCard(task, x, y);
-                    y += 90;
-                }
+                drawTaskRows(x, listTop(), listTop() + TASK_CARD_HEIGHT);
             }
         }
     }
@@ -1284,29 +2202,14 @@ private:
         float x = SIDEBAR_WIDTH + 50;
         float y = HEADER_HEIGHT + 50;
         
-        Text titleText;
-        titleText.setFont(font);
-        titleText.setString("Priority Queue (Ordered by Priority)");
-        titleText.setCharacterSize(20);
-        titleText.setFillColor(TEXT_COLOR);
-        titleText.setPosition(x, y);
-        window.draw(titleText);
+        drawLabel("Priority Queue (Ordered by Priority)", 20, TEXT_COLOR, x, y);
         
         y += 50;
-        if (state.displayTasks.empty()) {
-            Text emptyText;
-            emptyText.setFont(font);
-            emptyText.setString("Priority queue is empty");
-            emptyText.setCharacterSize(16);
-            emptyText.setFillColor(LIGHT_TEXT);
-            emptyText.setPosition(x, y);
-            window.draw(emptyText);
+        if (state.displayList.empty()) {
+            drawLabel("Priority queue is empty", 16, LIGHT_TEXT, x, y);
         }
         else {
-            for (const auto& task : state.displayTasks) {
-                drawTaskCard(task, x, y);
-                y += 90;
-            }
+            drawTaskRows(x, listTop(), listTop() + TASK_CARD_HEIGHT);
         }
     }
     
@@ -1321,85 +2224,462 @@ private:
         float x = SIDEBAR_WIDTH + 50;
         float y = HEADER_HEIGHT + 50;
         
-        Text settingsText;
-        settingsText.setFont(font);
-        settingsText.setString("Settings and Advanced Features");
-        settingsText.setCharacterSize(20);
-        settingsText.setFillColor(TEXT_COLOR);
-        settingsText.setPosition(x, y);
-        window.draw(settingsText);
+        drawLabel("Settings and Advanced Features", 20, TEXT_COLOR, x, y);
         
         y += 60;
         
         // Advanced features info
-        vector<string> features = {
+        const char* features[] = {
             "• Undo/Redo functionality available",
             "• Sort tasks by deadline",
             "• Move tasks to tomorrow",
             "• Update task priorities",
             "• Search by deadline",
+            "• Calendar of pending tasks per day (Left/Right: year)",
             "• View tasks by priority",
-            "• Separate completed/pending views"
+            "• Separate completed/pending views",
+            "• Press F3 for the profiler overlay",
+            "• Press F4 to archive completed tasks"
         };
         
-        for (const string& feature : features) {
-            Text featureText;
-            featureText.setFont(font);
-            featureText.setString(feature);
-            featureText.setCharacterSize(16);
-            featureText.setFillColor(TEXT_COLOR);
-            featureText.setPosition(x, y);
-            window.draw(featureText);
+        for (const char* feature : features) {
+            drawLabel(feature, 16, TEXT_COLOR, x, y);
             y += 30;
         }
     }
     
+    // Graph of the kept frames against the 60 fps budget, newest on the right,
+    // and the previous frame's breakdown. Everything goes through the batch,
+    // so the overlay adds one flush: a shapes draw plus one text draw.
+    void drawProfilerOverlay() {
+        TRACE_SCOPE("gui", "drawProfilerOverlay");
+        const float width = 400, graphHeight = 60, barWidth = width / PROFILER_FRAMES;
+        const float left = WINDOW_WIDTH - width - 10, top = 10;
+        const double budgetMs = 1000.0 / 60;
+        
+        batch.rect(left, top, width, graphHeight + 164, Color(30, 30, 30, 220));
+        for (size_t i = 0; i < frameHistory.size(); i++) {
+            double ms = frameHistory.at(i).totalMs();
+            float height = float(min(ms / (2 * budgetMs), 1.0)) * graphHeight;
+            Color color = ms <= budgetMs / 2 ? SUCCESS_COLOR : ms <= budgetMs ? WARNING_COLOR : DANGER_COLOR;
+            batch.rect(left + i * barWidth, top + graphHeight - height, max(barWidth - 1, 1.0f), height, color);
+        }
+        batch.rect(left, top + graphHeight / 2, width, 1, Color(255, 255, 255, 120));    // 16.7 ms
+        
+        FrameSample last = frameHistory.size() ? frameHistory.latest() : FrameSample();
+        char line[128];
+        float y = top + graphHeight + 8;
+        auto row = [&](const char* slot) {
+            drawText(labels, slot, line, 13, Color::White, left + 8, y);
+            y += 22;
+        };
+        
+        snprintf(line, sizeof(line), "Frame %.2f ms   avg %.2f   max %.2f",
+                 last.totalMs(), frameHistory.averageMs(), frameHistory.maxMs());
+        row("profiler.frame");
+        snprintf(line, sizeof(line), "Update %.2f   Draw %.2f   Display %.2f   Overlay %.2f ms",
+                 last.updateMs, last.drawMs - last.overlayMs, last.displayMs, last.overlayMs);
+        row("profiler.phases");
+        snprintf(line, sizeof(line), "Draw calls %u   Allocations %llu   Visible rows %zu",
+                 last.drawCalls, last.allocations, last.visibleRows);
+        row("profiler.counts");
+        if (storeLoading) snprintf(line, sizeof(line), "Loading tasks");
+        else snprintf(line, sizeof(line), "Tasks %zu   Listed %zu   Id index %.1f KB",
+                      taskManager.getTaskCount(), listedRows(), taskManager.indexBytes() / 1024.0);
+        row("profiler.engine");
+        snprintf(line, sizeof(line), "Archived %zu   Page cache %.1f MB",
+                 taskManager.getArchive().size(), taskManager.getArchive().cacheBytes() / 1048576.0);
+        row("profiler.archive");
+        snprintf(line, sizeof(line), "Last query %.1f ms   Search latency %.1f ms",
+                 lastQueryMs, lastSearchLatencyMs);
+        row("profiler.queries");
+        snprintf(line, sizeof(line), "Startup: first frame %.1f ms   tasks loaded %.1f ms",
+                 firstFrameMs, storeReadyMs);
+        row("profiler.startup");
+    }
+    
     void drawStatusMessage() {
-        RectangleShape msgBox(Vector2f(400, 50));
-        msgBox.setPosition(SIDEBAR_WIDTH + 50, WINDOW_HEIGHT - 100);
-        msgBox.setFillColor(Color(50, 50, 50, 200));
-        window.draw(msgBox);
-        
-        Text msgText;
-        msgText.setFont(font);
-        msgText.setString(state.statusMessage);
-        msgText.setCharacterSize(14);
-        msgText.setFillColor(Color::White);
-        msgText.setPosition(SIDEBAR_WIDTH + 60, WINDOW_HEIGHT - 85);
-        window.draw(msgText);
-        
-        // Auto-hide after some time (simplified)
-        static int counter = 0;
-        counter++;
-        if (counter > 180) { // ~3 seconds at 60 FPS
+        batch.rect(SIDEBAR_WIDTH + 50, WINDOW_HEIGHT - 100, 400, 50, Color(50, 50, 50, 200));
+        drawText(labels, "status", state.statusMessage, 14, Color::White, SIDEBAR_WIDTH + 60, WINDOW_HEIGHT - 85);
+    }
+    
+    // Fires any timer that is due
+    void updateTimers() {
+        auto now = chrono::steady_clock::now();
+        if (state.showStatusMessage && now >= statusHideAt) {
             state.showStatusMessage = false;
-            counter = 0;
+            invalidate(DIRTY_ALL);      // the box sat over the content
+        }
+        if (searchDue && now >= searchDueAt) {
+            runLiveSearch();
+        }
+    }
+    
+    // Blocks until an event arrives. While a timer or a background query is
+    // pending it polls instead: one sleep of at most TIMER_POLL_INTERVAL, then
+    // back to the loop to check on them.
+    bool waitForEvent(Event& event) {
+        bool querying = queries.busy() || queries.hasResult() || storeLoading;
+        chrono::steady_clock::duration untilPoll = untilDaemonPoll();
+        bool polling = untilPoll != chrono::steady_clock::duration::max();
+        if (!state.showStatusMessage && !searchDue && !querying && !polling) {
+            return window.waitEvent(event);
+        }
+        if (window.pollEvent(event)) return true;
+        
+        auto now = chrono::steady_clock::now();
+        chrono::steady_clock::duration wait = min<chrono::steady_clock::duration>(TIMER_POLL_INTERVAL, untilPoll);
+        if (state.showStatusMessage) {
+            wait = min<chrono::steady_clock::duration>(wait, statusHideAt - now);
+        }
+        if (searchDue) {
+            wait = min<chrono::steady_clock::duration>(wait, searchDueAt - now);
+        }
+        if (wait > chrono::steady_clock::duration::zero()) this_thread::sleep_for(wait);
+        return false;
+    }
+    
+    void processEvent(Event& event) {
+        if (event.type == Event::Closed) {
+            window.close();
+        }
+        else if (event.type == Event::Resized) {
+            invalidateLayers();
+            invalidate(DIRTY_ALL);
+        }
+        else if (event.type == Event::GainedFocus) {
+            invalidate(DIRTY_ALL);
+        }
+        else {
+            handleInput(event);
         }
     }
 
 public:
     TaskManagerGUI() {
+        taskManager.setThreadCount(thread::hardware_concurrency());
         initWindow();
     }
     
     void run() {
         while (window.isOpen()) {
             Event event;
-            while (window.pollEvent(event)) {
-                if (event.type == Event::Closed)
-                    window.close();
-                else
-                    handleInput(event);
+            bool waited = false;
+            if (!dirty) {
+                TRACE_SCOPE("gui", "waitEvent");
+                waited = waitForEvent(event);
+            }
+            
+            auto updateStart = chrono::steady_clock::now();
+            if (waited)
+                processEvent(event);
+            
+            while (true) {
+                bool hasEvent;
+                {
+                    TRACE_SCOPE("gui", "pollEvent");
+                    hasEvent = window.pollEvent(event);
+                }
+                if (!hasEvent)
+                    break;
+                processEvent(event);
+            }
+            
+            update();
+            if (!dirty || !window.isOpen())
+                continue;
+            drawFrame(updateStart);
+        }
+        
+#ifdef TODO_ENABLE_TRACE
+        TraceBuffer::instance().dumpChromeJson(TRACE_FILE);
+#endif
+    }
+    
+    // Opens the archive of completed tasks; list views page it in as they scroll
+    bool openArchive(const string& path) {
+        return taskManager.setArchivePath(path);
+    }
+    
+#ifdef TODO_DAEMON_CLIENT
+    // Client mode: the tasks come from todod, read on the loader thread. The
+    // export, the next id and the generation travel in one frame, so they
+    // describe the same state and later adds here get the ids the daemon will
+    // give them.
+    bool connectDaemon(const string& path) {
+        if (!daemon.connect(path)) return false;
+        loadStore([this] {
+            BatchCommand commands[] = {daemonCommand(BatchOp::EXPORT), daemonCommand(BatchOp::INFO)};
+            ResultCollector collected;
+            if (!daemon.call(commands, 2, collected)) throw runtime_error("lost the connection to todod");
+            {
+                unique_lock<shared_mutex> lock(engineMutex);
+                taskManager.reserveIds(int(collected.results[1].values[0]));
             }
+            daemonGeneration = collected.results[1].values[1];
+            daemonPollAt = chrono::steady_clock::now() + DAEMON_POLL_INTERVAL;
+            return move(collected.results[0].rows);
+        });
+        return true;
+    }
+#endif
+    
+    // Loads the task store without holding up the first frame: `read` runs on
+    // a loader thread, which then imports the tasks under the engine lock.
+    // Frames drawn meanwhile show a placeholder.
+    void loadStore(function<vector<Task>()> read) {
+        storeLoading = true;
+        storeLoad = async(launch::async, [this, read = move(read)] {
+            vector<Task> tasks = read();
+            unique_lock<shared_mutex> lock(engineMutex);
+            taskManager.importTasks(tasks);
+        });
+    }
+    
+    // ------------------ Render Benchmark ------------------
+    // Drives the regular update and draw code into the offscreen canvas over a
+    // generated task set: each scripted screen is opened, its list loaded, and
+    // then `frames` frames are drawn, scrolling half a row per frame where the
+    // screen scrolls and redrawing everything where it does not. Prints one
+    // JSON line per screen.
+    
+    struct Headless {};
+    
+    explicit TaskManagerGUI(Headless) {
+        headless = true;
+        taskManager.setThreadCount(thread::hardware_concurrency());
+        if (!canvas.create(WINDOW_WIDTH, WINDOW_HEIGHT)) {
+            throw runtime_error("Failed to create the offscreen canvas");
+        }
+        initResources();
+    }
+    
+    void runRenderBench(size_t taskCount, int frames) {
+        importBenchTasks(taskCount);
+        
+        struct Step {
+            const char* name;
+            function<void()> open;
+            bool scrolls;
+            bool profiler;
+        };
+        const Step steps[] = {
+            {"dashboard", [this] { actions["dashboard"](); }, false, false},
+            {"view_tasks", [this] { actions["view_tasks"](); }, true, false},
+            {"pending_tasks", [this] { actions["pending_tasks"](); }, true, false},
+            {"priority_tasks", [this] { actions["priority_tasks"](); }, true, false},
+            {"search_title", [this] {
+                actions["search_title"]();
+                state.inputBuffer = "task 4";
+                performTitleSearch();
+            }, true, false},
+            {"settings", [this] { state.currentScreen = Screen::SETTINGS; }, false, false},
+            {"view_tasks_profiler", [this] { actions["view_tasks"](); }, true, true},
+        };
+        
+        for (const Step& step : steps) {
+            step.open();
+            finishQueries();
+            state.scrollOffset = 0;
+            showProfiler = step.profiler;
             
-            drawScreen();
+            vector<double> frameMs;
+            vector<double> allocations;
+            double overlayMs = 0;
+            for (int i = 0; i < frames; i++) {
+                auto updateStart = chrono::steady_clock::now();
+                if (!step.scrolls) {
+                    invalidate(DIRTY_ALL);
+                }
+                else if (state.scrollOffset >= maxScrollOffset()) {
+                    state.scrollOffset = 0;
+                    invalidate(DIRTY_CONTENT);
+                }
+                else {
+                    scrollBy(TASK_ROW_HEIGHT / 2);
+                }
+                update();
+                drawFrame(updateStart);
+                frameMs.push_back(frame.totalMs());
+                allocations.push_back(double(frame.allocations));
+                overlayMs += frame.overlayMs;
+            }
+            
+            double firstMs = frameMs.front();
+            printf("{\"bench\":\"gui_render\",\"screen\":\"%s\",\"task_count\":%zu,\"frames\":%d,"
+                   "\"first_ms\":%.3f,\"p50_ms\":%.3f,\"p90_ms\":%.3f,\"p99_ms\":%.3f,\"max_ms\":%.3f,"
+                   "\"allocs_p50\":%.0f,\"allocs_max\":%.0f,\"draw_calls\":%u,\"overlay_ms\":%.3f}\n",
+                   step.name, taskCount, frames,
+                   firstMs, percentile(frameMs, 50), percentile(frameMs, 90), percentile(frameMs, 99),
+                   percentile(frameMs, 100), percentile(allocations, 50), percentile(allocations, 100),
+                   frame.drawCalls, overlayMs / frames);
+            fflush(stdout);
+        }
+        showProfiler = false;
+    }
+
+    // Startup with `taskCount` generated tasks standing in for a saved store:
+    // construction to the first frame (drawn while the tasks load), to the
+    // tasks being in, and to the first frame that shows them. Prints one JSON line.
+    void runStartupBench(size_t taskCount) {
+        double resourcesMs = chrono::duration<double, milli>(chrono::steady_clock::now() - createdAt).count();
+        loadStore([taskCount] { return benchTasks(taskCount); });
+        auto updateStart = chrono::steady_clock::now();
+        update();
+        drawFrame(updateStart);
+        
+        while (storeLoading) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+            update();
+        }
+        finishQueries();
+        updateStart = chrono::steady_clock::now();
+        update();
+        drawFrame(updateStart);
+        double loadedFrameMs = chrono::duration<double, milli>(chrono::steady_clock::now() - createdAt).count();
+        
+        printf("{\"bench\":\"gui_startup\",\"task_count\":%zu,\"resources_ms\":%.3f,"
+               "\"first_frame_ms\":%.3f,\"store_ready_ms\":%.3f,\"loaded_frame_ms\":%.3f}\n",
+               taskCount, resourcesMs, firstFrameMs, storeReadyMs, loadedFrameMs);
+        fflush(stdout);
+    }
+
+private:
+    // Timers and finished background queries; runs once per loop iteration
+    void update() {
+        if (storeLoading && storeLoad.wait_for(chrono::seconds(0)) == future_status::ready) {
+            finishStoreLoad();
+        }
+        updateTimers();
+        pollDaemon();
+        if (queries.poll()) invalidate(DIRTY_ALL);
+        if (queries.busy() != drawnBusy) invalidate(DIRTY_CHROME);
+    }
+    
+    void drawFrame(chrono::steady_clock::time_point updateStart) {
+        TRACE_SCOPE("gui", "frame");
+        frame = FrameSample();
+        frame.updateMs = chrono::duration<double, milli>(chrono::steady_clock::now() - updateStart).count();
+        unsigned long long allocationsBefore = alloc_counter::allocations();
+        drawScreen();
+        dirty = 0;
+        
+        // Should stay at 0 for frames that only scroll over cached cards
+        frame.allocations = alloc_counter::allocations() - allocationsBefore;
+        frameHistory.push(frame);
+        TRACE_COUNTER("gui", "heap allocations", frame.allocations);
+        
+        if (firstFrameMs < 0) {
+            firstFrameMs = chrono::duration<double, milli>(chrono::steady_clock::now() - createdAt).count();
+            TRACE_COUNTER("gui", "first frame us", uint64_t(firstFrameMs * 1000));
         }
     }
+    
+    void finishStoreLoad() {
+        storeLoading = false;
+        storeReadyMs = chrono::duration<double, milli>(chrono::steady_clock::now() - createdAt).count();
+        try {
+            storeLoad.get();
+        } catch (const exception& e) {
+            showStatusMessage(string("Failed to load tasks: ") + e.what());
+        }
+        loadCurrentView();
+        invalidate(DIRTY_ALL);
+    }
+    
+    // Waits out the background query and applies its result
+    void finishQueries() {
+        while (queries.busy() || queries.hasResult()) {
+            if (!queries.poll()) this_thread::sleep_for(chrono::milliseconds(1));
+        }
+    }
+    
+    // Same shape as the engine benchmark's data: scattered priorities and
+    // deadlines, a third of the tasks completed
+    void importBenchTasks(size_t count) {
+        taskManager.importTasks(benchTasks(count));
+    }
+    
+    static vector<Task> benchTasks(size_t count) {
+        vector<Task> tasks;
+        tasks.reserve(count);
+        char deadline[16];
+        for (size_t i = 0; i < count; i++) {
+            int n = int(i * 2654435761u % 1000003);
+            snprintf(deadline, sizeof(deadline), "%04d-%02d-%02d", 2025 + n % 3, 1 + n % 12, 1 + n % 28);
+            tasks.emplace_back(int(i + 1), "Task " + to_string(n) + " follow up with the team",
+                               "Description for task " + to_string(n), deadline, 1 + n % 10);
+            tasks.back().completed = (n % 3 == 0);
+        }
+        return tasks;
+    }
 };
 
-int main() {
+// Usage: ToDoApp [--archive FILE] | [--connect [SOCKET]]
+//               | [--bench [--startup] [--tasks N,N,...] [--frames N]]
+int main(int argc, char** argv) {
     try {
+        bool bench = false;
+        bool startup = false;
+        const char* archivePath = nullptr;
+        bool connect = false;
+        string socketPath;
+        vector<size_t> taskCounts = {1000, 10000, 100000, 1000000};
+        int frames = 240;
+        for (int i = 1; i < argc; i++) {
+            if (strcmp(argv[i], "--bench") == 0) {
+                bench = true;
+            }
+            else if (strcmp(argv[i], "--startup") == 0) {
+                startup = true;
+            }
+            else if (strcmp(argv[i], "--archive") == 0 && i + 1 < argc) {
+                archivePath = argv[++i];
+            }
+            else if (strcmp(argv[i], "--connect") == 0) {
+                connect = true;
+                if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) socketPath = argv[++i];
+            }
+            else if (strcmp(argv[i], "--tasks") == 0 && i + 1 < argc) {
+                taskCounts.clear();
+                for (char* item = strtok(argv[++i], ","); item != nullptr; item = strtok(nullptr, ",")) {
+                    taskCounts.push_back(strtoul(item, nullptr, 10));
+                }
+            }
+            else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+                frames = max(1, atoi(argv[++i]));
+            }
+        }
+        
+        if (bench) {
+            // A fresh GUI per size, so caches and the glyph atlas start cold each time
+            for (size_t count : taskCounts) {
+                TaskManagerGUI gui{TaskManagerGUI::Headless()};
+                if (startup) gui.runStartupBench(count);
+                else gui.runRenderBench(count, frames);
+            }
+            return 0;
+        }
+        
+        // Archiving moves tasks out of the engine, which the daemon would not follow
+        if (connect && archivePath) {
+            throw runtime_error("--archive cannot be combined with --connect");
+        }
+        
         TaskManagerGUI app;
+        if (archivePath && !app.openArchive(archivePath)) {
+            throw runtime_error(string("Failed to open archive ") + archivePath);
+        }
+        if (connect) {
+#ifdef TODO_DAEMON_CLIENT
+            if (socketPath.empty()) socketPath = defaultSocketPath();
+            if (!app.connectDaemon(socketPath)) {
+                throw runtime_error("Cannot connect to todod at " + socketPath + ": " + strerror(errno));
+            }
+#else
+            throw runtime_error("--connect needs Unix domain sockets, which this build lacks");
+#endif
+        }
         app.run();
         return 0;
     }
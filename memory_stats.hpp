@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ------------------ Memory Accounting ------------------
+// Object and payload sizes are exact (sizeof / capacity). Allocator overhead is
+// an estimate modelled on glibc malloc: 8 byte chunk header, 16 byte rounding,
+// 32 byte minimum chunk.
+
+inline size_t allocationOverhead(size_t requested) {
+    size_t chunk = (requested + sizeof(size_t) + 15) & ~size_t(15);
+    if (chunk < 32) chunk = 32;
+    return chunk - requested;
+}
+
+struct MemoryUsage {
+    size_t structBytes = 0;     // containers, nodes and the Task objects themselves
+    size_t stringBytes = 0;     // heap payloads of strings too long for the small-string buffer
+    size_t overheadBytes = 0;   // estimated allocator headers and rounding
+    size_t allocations = 0;
+
+    size_t total() const { return structBytes + stringBytes + overheadBytes; }
+
+    void addAllocation(size_t bytes) {
+        allocations++;
+        overheadBytes += allocationOverhead(bytes);
+    }
+
+    void addString(const std::string& s) {
+        if (s.capacity() > std::string().capacity()) {    // SSO strings own no heap block
+            stringBytes += s.capacity() + 1;
+            addAllocation(s.capacity() + 1);
+        }
+    }
+
+    // Works for any task type exposing title/description/deadline strings
+    template <class T>
+    void addTaskStrings(const T& task) {
+        addString(task.title);
+        addString(task.description);
+        addString(task.deadline);
+    }
+
+    // Hot records keep only the title as a string; the deadline is a day
+    // number and the description lives in the ColdStore
+    template <class T>
+    void addRecordStrings(const T& record) {
+        addString(record.title);
+    }
+
+    MemoryUsage& operator+=(const MemoryUsage& other) {
+        structBytes += other.structBytes;
+        stringBytes += other.stringBytes;
+        overheadBytes += other.overheadBytes;
+        allocations += other.allocations;
+        return *this;
+    }
+};
+
+struct MemoryReport {
+    size_t taskCount = 0;
+    std::vector<std::pair<std::string, MemoryUsage>> components;
+
+    MemoryUsage total() const {
+        MemoryUsage sum;
+        for (const auto& component : components) sum += component.second;
+        return sum;
+    }
+
+    double bytesPerTask() const {
+        return taskCount == 0 ? 0.0 : double(total().total()) / taskCount;
+    }
+
+    void print(std::ostream& out) const {
+        out << std::left << std::setw(16) << "Component"
+            << std::right << std::setw(12) << "Structs"
+            << std::setw(12) << "Strings"
+            << std::setw(12) << "Overhead"
+            << std::setw(12) << "Total"
+            << std::setw(8) << "Allocs" << "\n";
+
+        auto row = [&out](const std::string& name, const MemoryUsage& usage) {
+            out << std::left << std::setw(16) << name
+                << std::right << std::setw(12) << usage.structBytes
+                << std::setw(12) << usage.stringBytes
+                << std::setw(12) << usage.overheadBytes
+                << std::setw(12) << usage.total()
+                << std::setw(8) << usage.allocations << "\n";
+        };
+
+        for (const auto& component : components) row(component.first, component.second);
+        row("TOTAL", total());
+
+        out << "Tasks: " << taskCount << ", bytes per task: "
+            << std::fixed << std::setprecision(1) << bytesPerTask() << "\n";
+        out.unsetf(std::ios::floatfield);
+    }
+};
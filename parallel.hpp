@@ -0,0 +1,199 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ------------------ ThreadPool ------------------
+// Fixed set of workers that run one chunked job at a time. The calling
+// thread works on chunks too, so a pool of size N uses N-1 extra threads.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::mutex runMutex;                // serialises concurrent callers of run()
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(size_t)>* job = nullptr;
+    size_t jobChunks = 0;
+    std::atomic<size_t> nextChunk{0};
+    size_t activeWorkers = 0;
+    unsigned long long generation = 0;
+    bool stopping = false;
+
+    void drain() {
+        size_t chunk;
+        while ((chunk = nextChunk.fetch_add(1)) < jobChunks) {
+            (*job)(chunk);
+        }
+    }
+
+    void workerLoop() {
+        unsigned long long seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            drain();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--activeWorkers == 0) done.notify_one();
+            }
+        }
+    }
+
+public:
+    explicit ThreadPool(size_t threads) {
+        for (size_t i = 1; i < threads; i++) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    // Calls fn(0) .. fn(chunks - 1) across the pool and returns when all are done
+    void run(size_t chunks, const std::function<void(size_t)>& fn) {
+        if (chunks == 0) return;
+        std::lock_guard<std::mutex> runLock(runMutex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            jobChunks = chunks;
+            nextChunk = 0;
+            activeWorkers = workers.size();
+            generation++;
+        }
+        wake.notify_all();
+        drain();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return activeWorkers == 0; });
+        job = nullptr;
+    }
+};
+
+// ------------------ Cancellation ------------------
+// Long scans poll a caller-owned flag every CANCEL_CHECK_INTERVAL items and
+// stop early once it is raised. A cancelled scan returns a partial result
+// that the caller is expected to throw away.
+
+const size_t CANCEL_CHECK_INTERVAL = 4096;
+
+inline bool isCancelled(const std::atomic<bool>* cancelled) {
+    return cancelled != nullptr && cancelled->load(std::memory_order_relaxed);
+}
+
+// ------------------ Parallel Algorithms ------------------
+// Results are assembled in chunk order, so they match the serial versions exactly.
+
+const size_t PARALLEL_THRESHOLD = 50000;    // below this the serial path wins
+
+inline size_t chunkCountFor(const ThreadPool& pool, size_t items) {
+    size_t chunks = pool.size() * 4;        // a few chunks per thread evens out skew
+    return std::max<size_t>(1, std::min(chunks, items));
+}
+
+template <class T, class Pred>
+std::vector<T> parallelFilter(const std::vector<T>& items, Pred pred, ThreadPool& pool,
+                              const std::atomic<bool>* cancelled = nullptr) {
+    size_t chunks = chunkCountFor(pool, items.size());
+    size_t chunkSize = (items.size() + chunks - 1) / chunks;
+    std::vector<std::vector<T>> parts(chunks);
+
+    pool.run(chunks, [&](size_t chunk) {
+        size_t begin = chunk * chunkSize;
+        size_t end = std::min(items.size(), begin + chunkSize);
+        for (size_t i = begin; i < end; i++) {
+            if ((i - begin) % CANCEL_CHECK_INTERVAL == 0 && isCancelled(cancelled)) return;
+            if (pred(items[i])) parts[chunk].push_back(items[i]);
+        }
+    });
+
+    size_t total = 0;
+    for (const auto& part : parts) total += part.size();
+    std::vector<T> result;
+    result.reserve(total);
+    for (auto& part : parts) {
+        std::move(part.begin(), part.end(), std::back_inserter(result));
+    }
+    return result;
+}
+
+// Indices i in [0, count) for which pred(i) holds, ascending
+template <class Pred>
+std::vector<uint32_t> parallelFilterIndices(size_t count, Pred pred, ThreadPool& pool,
+                                            const std::atomic<bool>* cancelled = nullptr) {
+    size_t chunks = chunkCountFor(pool, count);
+    size_t chunkSize = (count + chunks - 1) / chunks;
+    std::vector<std::vector<uint32_t>> parts(chunks);
+
+    pool.run(chunks, [&](size_t chunk) {
+        size_t begin = chunk * chunkSize;
+        size_t end = std::min(count, begin + chunkSize);
+        for (size_t i = begin; i < end; i++) {
+            if ((i - begin) % CANCEL_CHECK_INTERVAL == 0 && isCancelled(cancelled)) return;
+            if (pred(i)) parts[chunk].push_back(uint32_t(i));
+        }
+    });
+
+    size_t total = 0;
+    for (const auto& part : parts) total += part.size();
+    std::vector<uint32_t> result;
+    result.reserve(total);
+    for (const auto& part : parts) result.insert(result.end(), part.begin(), part.end());
+    return result;
+}
+
+// Stable merge sort: sort chunks in parallel, then merge pairs of runs in parallel
+template <class T, class Less>
+void parallelStableSort(std::vector<T>& items, Less less, ThreadPool& pool) {
+    size_t runs = 1;
+    while (runs < pool.size() && runs < items.size()) runs *= 2;
+    if (runs == 1) {
+        std::stable_sort(items.begin(), items.end(), less);
+        return;
+    }
+
+    size_t runSize = (items.size() + runs - 1) / runs;
+    auto bound = [&](size_t run) { return std::min(items.size(), run * runSize); };
+
+    pool.run(runs, [&](size_t run) {
+        std::stable_sort(items.begin() + bound(run), items.begin() + bound(run + 1), less);
+    });
+
+    std::vector<T> buffer(items.size());
+    for (size_t width = 1; width < runs; width *= 2) {
+        size_t merges = runs / (2 * width);
+        pool.run(merges, [&](size_t merge) {
+            size_t lo = bound(merge * 2 * width);
+            size_t mid = bound(merge * 2 * width + width);
+            size_t hi = bound(merge * 2 * width + 2 * width);
+            std::merge(std::make_move_iterator(items.begin() + lo), std::make_move_iterator(items.begin() + mid),
+                       std::make_move_iterator(items.begin() + mid), std::make_move_iterator(items.begin() + hi),
+                       buffer.begin() + lo, less);
+        });
+        items.swap(buffer);
+    }
+}
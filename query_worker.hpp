@@ -0,0 +1,150 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// ------------------ QueryWorker ------------------
+// Runs long queries on one background thread so the UI thread never waits on
+// a scan. Every job gets its own cancellation flag, and submitting a job
+// raises the flag of the one before it, so a newer query always supersedes a
+// stale one. A job returns a completion that poll() runs on the UI thread;
+// completions of cancelled jobs are dropped. Spent completions are destroyed
+// back on the worker, so freeing a large superseded result never stalls a frame.
+class QueryWorker {
+public:
+    typedef std::function<void()> Completion;
+    typedef std::function<Completion(const std::atomic<bool>& cancelled)> Job;
+
+private:
+    typedef std::shared_ptr<std::atomic<bool>> Flag;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    Job pending;
+    Flag pendingFlag;
+    Flag runningFlag;                   // null while idle
+    Completion ready;                   // finished and not yet polled
+    std::vector<Completion> spent;      // waiting to be destroyed on the worker
+    bool stopping = false;
+    std::thread thread;                 // last, so everything above exists before it starts
+
+    // Caller holds mutex
+    void cancelLocked() {
+        if (pendingFlag) {
+            pendingFlag->store(true);
+            pendingFlag.reset();
+            pending = nullptr;
+        }
+        if (runningFlag) runningFlag->store(true);
+        if (ready) spent.push_back(std::move(ready));
+        ready = nullptr;
+    }
+
+    void loop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || pending || !spent.empty(); });
+            if (stopping) return;
+
+            if (!spent.empty()) {
+                std::vector<Completion> garbage;
+                garbage.swap(spent);
+                lock.unlock();
+                garbage.clear();
+                lock.lock();
+                continue;
+            }
+
+            Job job = std::move(pending);
+            pending = nullptr;
+            Flag flag = std::move(pendingFlag);
+            runningFlag = flag;
+            lock.unlock();
+
+            Completion completion = job(*flag);
+            job = nullptr;
+
+            lock.lock();
+            runningFlag.reset();
+            if (completion && !flag->load()) {
+                ready = std::move(completion);
+            }
+            else if (completion) {
+                lock.unlock();
+                completion = nullptr;
+                lock.lock();
+            }
+        }
+    }
+
+public:
+    QueryWorker() : thread([this] { loop(); }) {}
+
+    ~QueryWorker() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            cancelLocked();
+            stopping = true;
+        }
+        wake.notify_one();
+        thread.join();
+    }
+
+    QueryWorker(const QueryWorker&) = delete;
+    QueryWorker& operator=(const QueryWorker&) = delete;
+
+    // Queues job, cancelling whatever is queued, running or finished but unpolled
+    void submit(Job job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            cancelLocked();
+            pending = std::move(job);
+            pendingFlag = std::make_shared<std::atomic<bool>>(false);
+        }
+        wake.notify_one();
+    }
+
+    // Raises the running job's flag and drops anything queued. Does not wait:
+    // the job notices within one CANCEL_CHECK_INTERVAL of its scan.
+    void cancel() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            cancelLocked();
+        }
+        wake.notify_one();
+    }
+
+    // A job is queued or running
+    bool busy() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pending || runningFlag;
+    }
+
+    bool hasResult() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return bool(ready);
+    }
+
+    // Runs the finished job's completion on the calling thread. Returns false if there was none.
+    bool poll() {
+        Completion completion;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!ready) return false;
+            completion = std::move(ready);
+            ready = nullptr;
+        }
+        completion();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            spent.push_back(std::move(completion));
+        }
+        wake.notify_one();
+        return true;
+    }
+};
@@ -0,0 +1,415 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "parallel.hpp"
+#include "task_record.hpp"
+
+// ------------------ TaskArchive ------------------
+// Completed tasks moved out of RAM into an append-only file, for stores where
+// most finished work is never looked at again. Rows are encoded in pages of
+// ROWS_PER_PAGE; every page but the last is full, so row r lives in page
+// r / ROWS_PER_PAGE. Only the page index (12 bytes a page, in `path`.idx,
+// followed by the highest archived id) stays in RAM. Pages are decoded on demand into an LRU cache capped in
+// bytes, and a reader thread fills the cache ahead of the viewport, so
+// scrolling anywhere in a list of tens of millions of rows touches a page or
+// two and RSS stays at the cache cap.
+
+struct ArchivedTask {
+    TaskRecord record;                  // descriptionRef is unused
+    std::string description;
+};
+
+struct ArchivePage {
+    std::vector<ArchivedTask> rows;
+    size_t bytes = 0;                   // approximate heap footprint, for the cache cap
+};
+
+class TaskArchive {
+public:
+    static const size_t ROWS_PER_PAGE = 256;
+    static const size_t DEFAULT_CACHE_BYTES = 32 << 20;
+    static const size_t MAX_READ_AHEAD = 64;        // pages queued at once; sparse search rows can span many
+
+private:
+    struct PageEntry {
+        uint64_t offset;
+        uint32_t rows;
+    };
+
+    struct CachedPage {
+        size_t number;
+        std::shared_ptr<const ArchivePage> page;
+    };
+
+    std::string filePath;
+    mutable std::fstream file;
+    std::vector<PageEntry> index;
+    uint64_t fileSize = 0;
+    size_t rowCount = 0;
+    int topId = 0;                          // highest id archived
+    mutable std::mutex fileMutex;           // guards file, index and fileSize
+
+    mutable std::list<CachedPage> lru;      // most recently used at the front
+    mutable std::unordered_map<size_t, std::list<CachedPage>::iterator> cached;
+    mutable size_t cachedBytes = 0;
+    mutable uint64_t epoch = 0;             // bumped when append() rewrites a page
+    size_t cacheCapacity = DEFAULT_CACHE_BYTES;
+    mutable std::mutex cacheMutex;          // guards lru, cached, cachedBytes and epoch
+
+    mutable std::deque<size_t> wanted;      // pages the reader thread should load, nearest first
+    mutable std::condition_variable wake;
+    bool stopping = false;
+    std::thread reader;
+
+    template <class T>
+    static void put(std::string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <class T>
+    static T take(const char*& in) {
+        T value;
+        std::memcpy(&value, in, sizeof(T));
+        in += sizeof(T);
+        return value;
+    }
+
+    static void encode(std::string& out, const ArchivedTask& task) {
+        const TaskRecord& record = task.record;
+        put<int32_t>(out, record.id);
+        put<uint32_t>(out, record.version);
+        put<int32_t>(out, record.priority);
+        put<uint8_t>(out, record.completed);
+        std::string deadline = record.deadline();
+        put<uint16_t>(out, uint16_t(deadline.size()));
+        put<uint32_t>(out, uint32_t(record.title.size()));
+        put<uint32_t>(out, uint32_t(task.description.size()));
+        out += deadline;
+        out += record.title;
+        out += task.description;
+    }
+
+    static std::shared_ptr<ArchivePage> decode(const std::vector<char>& bytes, uint32_t rows) {
+        auto page = std::make_shared<ArchivePage>();
+        page->rows.resize(rows);
+        page->bytes = sizeof(ArchivePage) + rows * sizeof(ArchivedTask);
+        const char* in = bytes.data();
+        for (ArchivedTask& task : page->rows) {
+            TaskRecord& record = task.record;
+            record.id = take<int32_t>(in);
+            record.version = take<uint32_t>(in);
+            record.priority = take<int32_t>(in);
+            record.completed = take<uint8_t>(in) != 0;
+            uint16_t deadlineLength = take<uint16_t>(in);
+            uint32_t titleLength = take<uint32_t>(in);
+            uint32_t descriptionLength = take<uint32_t>(in);
+            record.deadlineDay = deadlineDayNumber(std::string_view(in, deadlineLength));
+            in += deadlineLength;
+            record.title.assign(in, titleLength);
+            in += titleLength;
+            task.description.assign(in, descriptionLength);
+            in += descriptionLength;
+            page->bytes += titleLength + descriptionLength;
+        }
+        return page;
+    }
+
+    // Caller holds fileMutex
+    std::vector<char> readPageLocked(size_t number) const {
+        uint64_t end = number + 1 < index.size() ? index[number + 1].offset : fileSize;
+        std::vector<char> bytes(size_t(end - index[number].offset));
+        file.clear();
+        file.seekg(std::streamoff(index[number].offset));
+        file.read(bytes.data(), std::streamsize(bytes.size()));
+        return bytes;
+    }
+
+    std::shared_ptr<ArchivePage> readPage(size_t number) const {
+        std::vector<char> bytes;
+        uint32_t rows;
+        {
+            std::lock_guard<std::mutex> lock(fileMutex);
+            if (number >= index.size()) return nullptr;
+            bytes = readPageLocked(number);
+            rows = index[number].rows;
+        }
+        return decode(bytes, rows);
+    }
+
+    // Caller holds cacheMutex
+    std::shared_ptr<const ArchivePage> findLocked(size_t number) const {
+        auto found = cached.find(number);
+        if (found == cached.end()) return nullptr;
+        lru.splice(lru.begin(), lru, found->second);
+        return found->second->page;
+    }
+
+    // Caches a page read while the epoch was `seen`. A read that raced an
+    // append() may hold the page as it was before, so it is not cached.
+    void insert(size_t number, std::shared_ptr<const ArchivePage> page, uint64_t seen) const {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        if (seen != epoch || cached.count(number)) return;     // stale, or the other thread got there first
+        lru.push_front(CachedPage{number, page});
+        cached[number] = lru.begin();
+        cachedBytes += page->bytes;
+        while (cachedBytes > cacheCapacity && lru.size() > 1) {
+            cachedBytes -= lru.back().page->bytes;
+            cached.erase(lru.back().number);
+            lru.pop_back();
+        }
+    }
+
+    void evict(size_t number) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        epoch++;
+        auto found = cached.find(number);
+        if (found == cached.end()) return;
+        cachedBytes -= found->second->page->bytes;
+        lru.erase(found->second);
+        cached.erase(found);
+    }
+
+    void readLoop() {
+        std::unique_lock<std::mutex> lock(cacheMutex);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || !wanted.empty(); });
+            if (stopping) return;
+            size_t number = wanted.front();
+            wanted.pop_front();
+            if (cached.count(number)) continue;
+            uint64_t seen = epoch;
+            lock.unlock();
+            if (auto page = readPage(number)) insert(number, page, seen);
+            lock.lock();
+        }
+    }
+
+    bool writeIndex() {
+        std::ofstream out(filePath + ".idx", std::ios::binary | std::ios::trunc);
+        uint64_t pages = index.size();
+        out.write(reinterpret_cast<const char*>(&pages), sizeof(pages));
+        for (const PageEntry& entry : index) {
+            out.write(reinterpret_cast<const char*>(&entry.offset), sizeof(entry.offset));
+            out.write(reinterpret_cast<const char*>(&entry.rows), sizeof(entry.rows));
+        }
+        int32_t id = topId;
+        out.write(reinterpret_cast<const char*>(&id), sizeof(id));
+        return bool(out);
+    }
+
+    // True if every page starts inside the file after the one before and is
+    // long enough for its rows' fixed fields; fileSize must be set
+    bool pagesFit() const {
+        const uint64_t rowHeader = 4 + 4 + 4 + 1 + 2 + 4 + 4;
+        for (size_t number = 0; number < index.size(); number++) {
+            uint64_t end = number + 1 < index.size() ? index[number + 1].offset : fileSize;
+            if (index[number].offset > end || index[number].rows > (end - index[number].offset) / rowHeader) return false;
+        }
+        return true;
+    }
+
+    bool readIndex() {
+        std::ifstream in(filePath + ".idx", std::ios::binary | std::ios::ate);
+        if (!in) return false;
+        uint64_t indexSize = uint64_t(in.tellg());
+        in.seekg(0);
+        uint64_t pages = 0;
+        in.read(reinterpret_cast<char*>(&pages), sizeof(pages));
+        // A count the file cannot hold is corrupt; don't allocate for it
+        const uint64_t entrySize = sizeof(uint64_t) + sizeof(uint32_t);
+        if (!in || pages > (indexSize - sizeof(pages)) / entrySize) return false;
+        index.resize(size_t(pages));
+        for (PageEntry& entry : index) {
+            in.read(reinterpret_cast<char*>(&entry.offset), sizeof(entry.offset));
+            in.read(reinterpret_cast<char*>(&entry.rows), sizeof(entry.rows));
+        }
+        if (!in || !pagesFit()) {
+            index.clear();
+            return false;
+        }
+        // Indexes written before the id was kept end here; scan() finds it
+        int32_t id = -1;
+        if (in.read(reinterpret_cast<char*>(&id), sizeof(id))) topId = id;
+        else topId = -1;
+        return true;
+    }
+
+    // The highest id in the file, by decoding every page; caller holds fileMutex
+    int scanTopId() const {
+        int top = 0;
+        for (size_t number = 0; number < index.size(); number++) {
+            std::shared_ptr<ArchivePage> page = decode(readPageLocked(number), index[number].rows);
+            for (const ArchivedTask& task : page->rows) top = std::max(top, task.record.id);
+        }
+        return top;
+    }
+
+public:
+    TaskArchive() {}
+
+    ~TaskArchive() {
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        if (reader.joinable()) reader.join();
+    }
+
+    TaskArchive(const TaskArchive&) = delete;
+    TaskArchive& operator=(const TaskArchive&) = delete;
+
+    // Opens the archive at `path`, creating it if there is none. Returns false
+    // if the file can't be opened or its index does not match it.
+    bool open(const std::string& path, size_t cacheBytes = DEFAULT_CACHE_BYTES) {
+        if (isOpen()) return false;
+        filePath = path;
+        cacheCapacity = cacheBytes;
+        file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+        if (!file.is_open()) {
+            file.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) return false;
+        }
+        file.seekg(0, std::ios::end);
+        fileSize = uint64_t(file.tellg());
+
+        if (fileSize > 0 && (!readIndex() || index.empty() || index.back().offset > fileSize)) {
+            file.close();
+            index.clear();
+            return false;
+        }
+        rowCount = 0;
+        for (const PageEntry& entry : index) rowCount += entry.rows;
+        if (topId < 0) {
+            topId = scanTopId();
+            writeIndex();
+        }
+        reader = std::thread([this] { readLoop(); });
+        return true;
+    }
+
+    bool isOpen() const { return file.is_open(); }
+    size_t size() const { return rowCount; }
+    size_t pageCount() const { return index.size(); }
+    int maxId() const { return topId; }     // 0 if empty
+    const std::string& path() const { return filePath; }
+
+    // Appends rows, topping up the last page first so every page but the last
+    // stays full. A reader that read the old last page meanwhile keeps its
+    // copy, which may be shorter than the page now is; it is not cached.
+    bool append(const std::vector<ArchivedTask>& rows) {
+        if (!isOpen() || rows.empty()) return isOpen();
+        std::lock_guard<std::mutex> lock(fileMutex);
+
+        std::vector<ArchivedTask> partial;
+        uint64_t position = fileSize;
+        if (!index.empty() && index.back().rows < ROWS_PER_PAGE) {
+            size_t last = index.size() - 1;
+            partial = decode(readPageLocked(last), index.back().rows)->rows;
+            position = index.back().offset;
+            rowCount -= index.back().rows;
+            index.pop_back();
+            evict(last);
+        }
+
+        std::string bytes;
+        size_t inPage = 0;
+        auto add = [&](const ArchivedTask& task) {
+            if (inPage == 0) index.push_back(PageEntry{position + bytes.size(), 0});
+            encode(bytes, task);
+            topId = std::max(topId, task.record.id);
+            index.back().rows++;
+            rowCount++;
+            inPage = (inPage + 1) % ROWS_PER_PAGE;
+        };
+        for (const ArchivedTask& task : partial) add(task);
+        for (const ArchivedTask& task : rows) add(task);
+
+        file.clear();
+        file.seekp(std::streamoff(position));
+        file.write(bytes.data(), std::streamsize(bytes.size()));
+        file.flush();
+        fileSize = position + bytes.size();
+        return bool(file) && writeIndex();
+    }
+
+    // The page holding row `row`, read and decoded now if it is not cached.
+    // Null past the end. The page stays valid for as long as it is held; check
+    // slotOf(row) against its size, since a page held across an append() can
+    // be short.
+    std::shared_ptr<const ArchivePage> pageOf(size_t row) const {
+        size_t number = row / ROWS_PER_PAGE;
+        uint64_t seen;
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            if (auto page = findLocked(number)) return page;
+            seen = epoch;
+        }
+        std::shared_ptr<const ArchivePage> page = readPage(number);
+        if (page) insert(number, page, seen);
+        return page;
+    }
+
+    static size_t slotOf(size_t row) { return row % ROWS_PER_PAGE; }
+
+    // Queues the pages of rows [first, last) and `pages` pages on either side
+    // for the reader thread, nearest first, at most MAX_READ_AHEAD of them.
+    // Replaces the previous request, so a jump does not leave a backlog behind.
+    void readAhead(size_t first, size_t last, size_t pages) const {
+        if (!isOpen() || last <= first) return;
+        size_t low = first / ROWS_PER_PAGE, high = (last - 1) / ROWS_PER_PAGE;
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            wanted.clear();
+            for (size_t number = low; number <= high && wanted.size() < MAX_READ_AHEAD; number++) {
+                if (!cached.count(number)) wanted.push_back(number);
+            }
+            for (size_t step = 1; step <= pages && wanted.size() < MAX_READ_AHEAD; step++) {
+                if (high + step < index.size() && !cached.count(high + step)) wanted.push_back(high + step);
+                if (low >= step && !cached.count(low - step)) wanted.push_back(low - step);
+            }
+            if (wanted.empty()) return;
+        }
+        wake.notify_one();
+    }
+
+    // Rows accepted by pred, in archive order. Streams the file page by page
+    // past the cache, so a scan does not evict what the views are showing.
+    template <class Pred>
+    std::vector<uint32_t> selectRows(Pred accepts, const std::atomic<bool>* cancelled = nullptr) const {
+        std::vector<uint32_t> rows;
+        for (size_t number = 0; number < pageCount(); number++) {
+            if (isCancelled(cancelled)) break;
+            std::shared_ptr<const ArchivePage> page;
+            {
+                std::lock_guard<std::mutex> lock(cacheMutex);
+                page = findLocked(number);
+            }
+            if (!page) page = readPage(number);
+            if (!page) break;
+            for (size_t i = 0; i < page->rows.size(); i++) {
+                if (accepts(page->rows[i])) rows.push_back(uint32_t(number * ROWS_PER_PAGE + i));
+            }
+        }
+        return rows;
+    }
+
+    size_t cacheBytes() const {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        return cachedBytes;
+    }
+
+    size_t indexBytes() const { return index.capacity() * sizeof(PageEntry); }
+};
@@ -0,0 +1,202 @@
+#pragma once
+#if defined(__unix__) || defined(__APPLE__)
+#define TODO_DAEMON_CLIENT 1
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "task_protocol.hpp"
+
+// $XDG_RUNTIME_DIR/todod.sock, or /tmp/todod-<uid>.sock without one
+inline std::string defaultSocketPath() {
+    const char* runtime = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime != nullptr && *runtime != '\0') return std::string(runtime) + "/todod.sock";
+    return "/tmp/todod-" + std::to_string(getuid()) + ".sock";
+}
+
+// ------------------ TaskClient ------------------
+// Blocking connection to todod (task_protocol.hpp). send() writes one frame
+// and returns at once, so several can be in flight; receive() takes the
+// responses back in the same order. Any I/O or decoding failure closes the
+// connection, after which both report failure.
+class TaskClient {
+private:
+    int fd = -1;
+    uint32_t nextTag = 1;
+    wire::Buffer out;           // the frame being sent
+    wire::Buffer in;            // received bytes; in[consumed..] not yet decoded
+    size_t consumed = 0;
+
+    bool writeAll(const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            data += n;
+            size -= size_t(n);
+        }
+        return true;
+    }
+
+    // Reads until in[consumed..] holds a whole frame; returns its size
+    size_t nextFrame() {
+        while (true) {
+            size_t available = in.size() - consumed;
+            if (available >= 4) {
+                uint32_t body = wire::getU32(in.data() + consumed);
+                if (body < wire::HEADER_SIZE - 4 || body > wire::MAX_RESPONSE_SIZE) return 0;
+                if (available >= 4 + size_t(body)) return 4 + size_t(body);
+            }
+            if (consumed > 0) {
+                in.erase(in.begin(), in.begin() + consumed);
+                consumed = 0;
+            }
+            size_t old = in.size();
+            in.resize(old + (64u << 10));
+            ssize_t n = ::read(fd, in.data() + old, in.size() - old);
+            in.resize(old + (n > 0 ? size_t(n) : 0));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return 0;
+        }
+    }
+
+public:
+    TaskClient() = default;
+    TaskClient(const TaskClient&) = delete;
+    TaskClient& operator=(const TaskClient&) = delete;
+
+    ~TaskClient() {
+        close();
+    }
+
+    // False with errno set if there is no daemon at `path`
+    bool connect(const std::string& path) {
+        close();
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            errno = ENAMETOOLONG;
+            return false;
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return false;
+        if (::connect(fd, (const sockaddr*)&address, sizeof(address)) != 0) {
+            int error = errno;
+            close();
+            errno = error;
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+        in.clear();
+        consumed = 0;
+    }
+
+    bool isConnected() const {
+        return fd >= 0;
+    }
+
+    // Sends commands[0..count) as one frame; returns its tag, 0 on failure
+    uint32_t send(const BatchCommand* commands, size_t count) {
+        if (fd < 0) return 0;
+        uint32_t tag = nextTag++;
+        if (nextTag == 0) nextTag = 1;
+        out.clear();
+        size_t start = wire::beginFrame(out, tag, count);
+        for (size_t i = 0; i < count; i++) wire::putCommand(out, commands[i]);
+        wire::finishFrame(out, start);
+        if (!writeAll(out.data(), out.size())) {
+            close();
+            return 0;
+        }
+        return tag;
+    }
+
+    uint32_t send(const BatchCommand& command) {
+        return send(&command, 1);
+    }
+
+    // Waits for the next response and replays its results into `sink` (see
+    // CommandRunner). lineOf(i) gives the line reported for a failure of the
+    // frame's i-th command. Returns the frame's tag, 0 on failure.
+    template <class Sink, class LineOf>
+    uint32_t receive(Sink& sink, LineOf lineOf) {
+        if (fd < 0) return 0;
+        size_t size = nextFrame();
+        if (size == 0) {
+            close();
+            return 0;
+        }
+        const char* frame = in.data() + consumed;
+        uint32_t tag = wire::getU32(frame + 4);
+        wire::Reader reader(frame + wire::HEADER_SIZE, frame + size);
+        uint64_t count = reader.varint();
+        bool ok = reader.ok;
+        for (uint64_t i = 0; ok && i < count; i++) ok = wire::readResult(reader, sink, lineOf);
+        if (!ok || !reader.atEnd()) {
+            close();
+            return 0;
+        }
+        consumed += size;
+        return tag;
+    }
+
+    template <class Sink>
+    uint32_t receive(Sink& sink) {
+        return receive(sink, [](size_t index) { return index; });
+    }
+
+    // One round trip
+    template <class Sink>
+    bool call(const BatchCommand* commands, size_t count, Sink& sink) {
+        uint32_t tag = send(commands, count);
+        return tag != 0 && receive(sink) == tag;
+    }
+};
+
+// ------------------ ResultCollector ------------------
+// A sink that keeps every result, for callers that want values rather than text
+struct RemoteResult {
+    bool failed = false;
+    std::string error;
+    std::vector<uint64_t> values;
+    std::vector<Task> rows;
+};
+
+class ResultCollector {
+public:
+    std::vector<RemoteResult> results;
+
+    void values(const uint64_t* values, size_t count) {
+        results.emplace_back();
+        results.back().values.assign(values, values + count);
+    }
+
+    void rows(size_t count, bool) {
+        results.emplace_back();
+        results.back().rows.reserve(count);
+    }
+
+    void row(const TaskRecord& task, const std::string* description) {
+        results.back().rows.emplace_back(task.id, task.title, description ? *description : std::string(),
+                                         task.deadline(), task.priority);
+        results.back().rows.back().completed = task.completed;
+    }
+
+    void fail(size_t, const char* message) {
+        results.emplace_back();
+        results.back().failed = true;
+        results.back().error = message;
+    }
+};
+
+#endif
@@ -7,7 +7,17 @@
 #include <vector>
 #include <memory>
 #include <algorithm>
+#include <deque>
 #include <stdexcept>
+#include "trace.hpp"
+#include "memory_stats.hpp"
+#include "task_sort.hpp"
+#include "parallel.hpp"
+#include "cold_store.hpp"
+#include "task_record.hpp"
+#include "task_archive.hpp"
+#include "deadline_index.hpp"
+#include "title_index.hpp"
 
 using namespace std;
 
@@ -19,17 +29,26 @@ class Stack;
 // ------------------ Simple Date Class ------------------
 class Date {
 public:
-    int year;
-    int month;
-    int day;
+    int year = 0;
+    int month = 0;
+    int day = 0;
 
     Date(string dateString) {
         sscanf(dateString.c_str(), "%d-%d-%d", &year, &month, &day);
     }
 
+    // True if `dateString` is a whole "YYYY-MM-DD" with every part in range
+    static bool isValid(const string& dateString) {
+        int y = 0, m = 0, d = 0, used = 0;
+        if (sscanf(dateString.c_str(), "%d-%d-%d%n", &y, &m, &d, &used) != 3 || size_t(used) != dateString.size()) {
+            return false;
+        }
+        return y >= 1 && y <= 9999 && m >= 1 && m <= 12 && d >= 1 && d <= 31;
+    }
+
     string toString() {
-        char buffer[11];
-        sprintf(buffer, "%04d-%02d-%02d", year, month, day);
+        char buffer[40];            // room for three full ints, whatever the fields hold
+        snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", year, month, day);
         return string(buffer);
     }
 
@@ -83,14 +102,40 @@ struct Task {
     }
 };
 
+// ------------------ SearchMatches ------------------
+// Result of an incremental title/description search: positions into the
+// record order, tagged with the query and the generation they were computed
+// against. Anything that matches "abc" also matches "ab", so a later query
+// containing this one only has to re-check these positions, as long as the
+// tasks have not changed in between.
+struct SearchMatches {
+    std::string query;
+    uint64_t generation = 0;
+    std::vector<uint32_t> positions;    // ascending
+    bool complete = true;               // false if the scan was cancelled partway
+};
+
+// ------------------ TaskChange ------------------
+// One entry of the TaskManager's change journal: the task `id` was added,
+// removed or edited, bringing the store to `generation`. `reordered` entries
+// stand for changes to many tasks at once (a sort, a bulk import).
+struct TaskChange {
+    uint64_t generation;
+    int id;
+    bool reordered;
+};
+
+const size_t CHANGE_LOG_SIZE = 1024;        // journal entries kept for changesSince()
+const uint32_t NO_POSITION = UINT32_MAX;
+
 // ------------------ Node ------------------
 class Node {
 public:
-    Task task;
+    TaskRecord task;
     Node* next;
     Node* prev;
 
-    Node(Task t) : task(t), next(nullptr), prev(nullptr) {}
+    Node(const TaskRecord& t) : task(t), next(nullptr), prev(nullptr) {}
 };
 
 // ------------------ UndoAction ------------------
@@ -109,30 +154,41 @@ public:
 };
 
 // ------------------ Stack ------------------
+// The last MAX_SIZE undo steps, in a ring: once full, a push drops the oldest
+// step, so a long (or scripted) session keeps recording instead of refusing.
 class Stack {
 private:
     UndoAction stack[MAX_SIZE];
-    int top;
+    int top;        // slot of the newest action
+    int count;
 
 public:
-    Stack() : top(-1) {}
+    Stack() : top(-1), count(0) {}
 
     bool isFull() {
-        return top == MAX_SIZE - 1;
+        return count == MAX_SIZE;
     }
 
-    bool isEmpty() {
-        return top == -1;
+    bool isEmpty() const {
+        return count == 0;
     }
 
     void push(UndoAction value) {
-        if (isFull()) {
-            cout << "Stack overflow" << endl;
-        }
-        else {
-            top++;
-            stack[top] = value;
-        }
+        top = (top + 1) % MAX_SIZE;
+        stack[top] = std::move(value);
+        if (count < MAX_SIZE) count++;
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+    // Oldest first
+    std::vector<UndoAction> contents() const {
+        std::vector<UndoAction> actions;
+        actions.reserve(count);
+        for (int i = count - 1; i >= 0; i--) actions.push_back(stack[(top - i + MAX_SIZE) % MAX_SIZE]);
+        return actions;
     }
 
     UndoAction pop() {
@@ -140,16 +196,29 @@ public:
             cout << "Stack underflow" << endl;
             return UndoAction();
         }
-        else {
-            return stack[top--];
+        UndoAction action = std::move(stack[top]);
+        top = (top + MAX_SIZE - 1) % MAX_SIZE;
+        count--;
+        return action;
+    }
+
+    // Popped slots keep their strings until overwritten, so every slot is counted
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        usage.structBytes = sizeof(*this);
+        for (const auto& action : stack) {
+            usage.addString(action.type);
+            usage.addTaskStrings(action.before);
+            usage.addTaskStrings(action.after);
         }
+        return usage;
     }
 };
 
 // ------------------ MinHeap ------------------
 class MinHeap {
 private:
-    Task heap[MAX_SIZE];
+    std::vector<TaskRecord> heap;
     int size;
 
     int parent(int i) { return (i - 1) / 2; }
@@ -183,36 +252,45 @@ private:
 public:
     MinHeap() : size(0) {}
 
-    void insert(Task task) {
-        if (size >= MAX_SIZE) {
-            cout << "Heap is full!" << endl;
-            return;
-        }
-        heap[size] = task;
+    void insert(const TaskRecord& task) {
+        heap.push_back(task);
         shiftUp(size);
         size++;
     }
 
-    Task extractMin() {
+    TaskRecord extractMin() {
         if (size == 0) {
             cout << "Heap is empty!" << endl;
-            return Task();
+            return TaskRecord();
         }
-        Task root = heap[0];
+        TaskRecord root = heap[0];
         heap[0] = heap[size - 1];
+        heap.pop_back();
         size--;
         shiftDown(0);
         return root;
     }
 
+    void reserve(size_t count) { heap.reserve(count); }
+
     bool empty() {
         return size == 0;
     }
 
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        usage.structBytes = sizeof(*this) + heap.capacity() * sizeof(TaskRecord);
+        if (heap.capacity()) usage.addAllocation(heap.capacity() * sizeof(TaskRecord));
+        for (const auto& task : heap) {
+            usage.addRecordStrings(task);
+        }
+        return usage;
+    }
+
     void display() {
         MinHeap tempHeap = *this;
         while (!tempHeap.empty()) {
-            Task task = tempHeap.extractMin();
+            TaskRecord task = tempHeap.extractMin();
             cout << "- " << task.title << " (Priority: " << task.priority << ")" << endl;
         }
     }
@@ -227,8 +305,23 @@ private:
 
 public:
     TaskList() : head(nullptr), tail(nullptr), nextId(1) {}
+    ~TaskList() { clear(); }
+
+    TaskList(const TaskList&) = delete;
+    TaskList& operator=(const TaskList&) = delete;
 
-    void insert(Task task) {
+    void clear() {
+        Node* current = head;
+        while (current != nullptr) {
+            Node* next = current->next;
+            delete current;
+            current = next;
+        }
+        head = nullptr;
+        tail = nullptr;
+    }
+
+    void insert(const TaskRecord& task) {
         Node* newNode = new Node(task);
         if (head == nullptr) {
             head = newNode;
@@ -257,34 +350,33 @@ public:
     }
 
     void sortByDeadline() {
-        vector<Task> tasks;
-        Node* current = head;
-        while (current != nullptr) {
-            tasks.push_back(current->task);
-            current = current->next;
+        // Radix sort (day number, node) pairs, then relink the nodes in that order.
+        // Records never move, only the next/prev pointers change.
+        vector<SortEntry<Node*>> entries;
+        for (Node* current = head; current != nullptr; current = current->next) {
+            entries.push_back({current->task.deadlineDay, current});
         }
+        radixSortByKey(entries);
 
-        for (size_t i = 0; i < tasks.size(); i++) {
-            for (size_t j = i + 1; j < tasks.size(); j++) {
-                Date date1(tasks[i].deadline);
-                Date date2(tasks[j].deadline);
-                if (date2.isLessThan(date1)) {
-                    swap(tasks[i], tasks[j]);
-                }
+        Node* previous = nullptr;
+        for (const auto& entry : entries) {
+            entry.handle->prev = previous;
+            if (previous != nullptr) {
+                previous->next = entry.handle;
             }
+            else {
+                head = entry.handle;
+            }
+            previous = entry.handle;
         }
-
-        // Rebuild the list
-        current = head;
-        size_t index = 0;
-        while (current != nullptr && index < tasks.size()) {
-            current->task = tasks[index++];
-            current = current->next;
+        if (previous != nullptr) {
+            previous->next = nullptr;
         }
+        tail = previous;
     }
 
-    vector<Task> getAllTasks() {
-        vector<Task> tasks;
+    vector<TaskRecord> getAllTasks() {
+        vector<TaskRecord> tasks;
         Node* current = head;
         while (current != nullptr) {
             tasks.push_back(current->task);
@@ -293,8 +385,8 @@ public:
         return tasks;
     }
 
-    vector<Task> getPendingTasks() {
-        vector<Task> tasks;
+    vector<TaskRecord> getPendingTasks() {
+        vector<TaskRecord> tasks;
         Node* current = head;
         while (current != nullptr) {
             if (!current->task.completed) {
@@ -305,8 +397,8 @@ public:
         return tasks;
     }
 
-    vector<Task> getCompletedTasks() {
-        vector<Task> tasks;
+    vector<TaskRecord> getCompletedTasks() {
+        vector<TaskRecord> tasks;
         Node* current = head;
         while (current != nullptr) {
             if (current->task.completed) {
@@ -322,7 +414,7 @@ public:
         while (current != nullptr) {
             if (current->task.id == id) {
                 current->task.title = newTitle;
-                current->task.deadline = newDeadline;
+                current->task.deadlineDay = deadlineDayNumber(newDeadline);
                 cout << "Task updated successfully!" << endl;
                 return;
             }
@@ -332,261 +424,908 @@ public:
     }
 
     Node* getHead() { return head; }
+
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        usage.structBytes = sizeof(*this);
+        for (Node* current = head; current != nullptr; current = current->next) {
+            usage.structBytes += sizeof(Node);
+            usage.addAllocation(sizeof(Node));
+            usage.addRecordStrings(current->task);
+        }
+        return usage;
+    }
 };
 
 // ------------------ TaskManager ------------------
 class TaskManager {
 private:
-    std::vector<Task> tasks;
+    std::vector<TaskRecord> records;        // hot fields, in display order
+    ColdStore cold;                         // descriptions, optionally paged from disk
+    TaskArchive archive;                    // completed tasks moved out of RAM, once setArchivePath() is called
     int nextId = 1;
-    TaskList list;
-    MinHeap heap;
+    uint32_t nextVersion = 1;               // unique across all tasks, so (id, version) never repeats
+    uint64_t generation = 0;                // bumped on every change to the task set or its order
+    std::deque<TaskChange> changeLog;       // the last CHANGE_LOG_SIZE changes, oldest first
+    std::vector<uint32_t> positionOfId;     // id -> index into records, NO_POSITION if absent; ids are dense
+    DeadlineIndex deadlines;                // ids by deadline day, with pending counts per day
+    TitleIndex titles;                      // ids by exact title
+    size_t completedCount = 0;
+    int batchDepth = 0;                     // open beginBatch() calls
+    bool batchChanged = false;
+    // List and heap mirrors are rebuilt on first use after a change rather than
+    // on every mutation, so a change never pays for an O(n) rebuild up front
+    mutable TaskList list;
+    mutable MinHeap heap;
+    mutable bool mirrorsStale = false;
     Stack undoActions;
     Stack redoActions;
+    std::shared_ptr<ThreadPool> pool;       // null = serial queries
+    size_t parallelThreshold = PARALLEL_THRESHOLD;
+
+    bool useParallel(size_t count) const {
+        return pool && pool->size() > 1 && count >= parallelThreshold;
+    }
+
+    bool matchesQuery(const TaskRecord& task, const std::string& query) const {
+        return task.title.find(query) != std::string::npos ||       //no position if no match is found
+               cold.contains(task.descriptionRef, query);
+    }
+
+    template <class Pred>
+    std::vector<TaskRecord> filterTasks(Pred pred, const std::atomic<bool>* cancelled = nullptr) const {
+        if (useParallel(records.size())) {
+            return parallelFilter(records, pred, *pool, cancelled);
+        }
+        std::vector<TaskRecord> results;
+        for (size_t i = 0; i < records.size(); i++) {
+            if (i % CANCEL_CHECK_INTERVAL == 0 && isCancelled(cancelled)) break;
+            if (pred(records[i])) results.push_back(records[i]);
+        }
+        return results;
+    }
+
+    // The priority sorts bucket on 1-10 directly, so nothing else gets stored
+    static void checkPriority(int priority) {
+        if (priority < 1 || priority > 10) {
+            throw std::invalid_argument("Priority must be between 1 and 10");
+        }
+    }
 
-    // Helper method that rebuilds the TaskList and MinHeap
-    // so they match the current state of the tasks vector after sorting or changes
+    static void checkPriorities(const std::vector<Task>& tasks) {
+        for (const auto& task : tasks) checkPriority(task.priority);
+    }
+
+    std::vector<TaskRecord>::iterator findRecord(int id) {
+        size_t position = positionOf(id);
+        return position == NO_POSITION ? records.end() : records.begin() + position;
+    }
+
+    void indexPositions(size_t from) {
+        for (size_t i = from; i < records.size(); i++) {
+            positionOfId[records[i].id] = uint32_t(i);
+        }
+    }
+
+    TaskRecord makeRecord(const Task& task) {
+        TaskRecord record;
+        record.id = task.id;
+        record.descriptionRef = cold.put(task.description);
+        assignHotFields(record, task);
+        record.version = nextVersion++;
+        return record;
+    }
+
+    static void assignHotFields(TaskRecord& record, const Task& task) {
+        record.title = task.title;
+        record.deadlineDay = deadlineDayNumber(task.deadline);
+        record.priority = task.priority;
+        record.completed = task.completed;
+    }
+
+    // Moves the task to its new day bucket, or just adjusts the pending count
+    void reindexDeadline(const TaskRecord& record, uint32_t oldDay, bool wasCompleted) {
+        uint32_t newDay = record.deadlineDay;
+        if (oldDay == newDay) {
+            deadlines.setCompleted(newDay, wasCompleted, record.completed);
+        }
+        else {
+            deadlines.remove(record.id, oldDay, wasCompleted);
+            deadlines.add(record.id, newDay, record.completed);
+        }
+    }
+
+    void rebuildDeadlineIndex() {
+        deadlines.clear();
+        deadlines.addRange(records, 0);
+    }
+
+    void assignRecord(TaskRecord& record, const Task& task) {
+        if (record.completed != task.completed) {
+            if (task.completed) completedCount++;
+            else completedCount--;
+        }
+        uint32_t oldDay = record.deadlineDay;
+        bool wasCompleted = record.completed;
+        bool retitled = record.title != task.title;
+        if (retitled) titles.remove(record.title, record.id);
+        assignHotFields(record, task);
+        if (retitled) titles.add(record.title, record.id);
+        reindexDeadline(record, oldDay, wasCompleted);
+        cold.set(record.descriptionRef, task.description);
+        record.version = nextVersion++;
+    }
+
+    // Bulk loads pass indexDeadline = false and index the new range in one go
+    void appendRecord(const Task& task, bool indexDeadline = true) {
+        records.push_back(makeRecord(task));
+        if (task.completed) completedCount++;
+        if (indexDeadline) deadlines.add(task.id, deadlineDayNumber(task.deadline), task.completed);
+        titles.add(task.title, task.id);
+        if (size_t(task.id) >= positionOfId.size()) positionOfId.resize(task.id + 1, NO_POSITION);
+        positionOfId[task.id] = uint32_t(records.size() - 1);
+    }
+
+    // Records behind the erased one shift down, so their positions are re-indexed
+    void eraseRecord(std::vector<TaskRecord>::iterator it) {
+        if (it->completed) completedCount--;
+        deadlines.remove(it->id, it->deadlineDay, it->completed);
+        titles.remove(it->title, it->id);
+        cold.erase(it->descriptionRef);
+        positionOfId[it->id] = NO_POSITION;
+        size_t position = it - records.begin();
+        records.erase(it);
+        indexPositions(position);
+    }
+
+    Task toTask(const TaskRecord& record) const {
+        Task task(record.id, record.title, cold.get(record.descriptionRef),
+                  record.deadline(), record.priority);
+        task.completed = record.completed;
+        return task;
+    }
+
+    // Called after every change: journals it and marks the TaskList and MinHeap
+    // mirrors out of date so ensureMirrors() rebuilds them from the records on
+    // next use. Without an id the change counts as a reorder of everything.
     void syncDataStructures() {
+        journalChange({generation + 1, 0, true});
+    }
+
+    void syncDataStructures(int changedId) {
+        journalChange({generation + 1, changedId, false});
+    }
+
+    // Inside a batch every change is journaled under the same next generation,
+    // which endBatch() publishes
+    void journalChange(const TaskChange& change) {
+        if (batchDepth == 0) generation = change.generation;
+        else batchChanged = true;
+        mirrorsStale = true;
+        changeLog.push_back(change);
+        if (changeLog.size() > CHANGE_LOG_SIZE) changeLog.pop_front();
+    }
+
+    void ensureMirrors() const {
+        if (!mirrorsStale) return;
+        TRACE_SCOPE("engine", "TaskManager::ensureMirrors");
         // Clear and rebuild TaskList
-        list = TaskList();
-        for (const auto& task : tasks) {
-            Task taskCopy = task;
-            taskCopy.id = task.id;
-            list.insert(taskCopy);
+        list.clear();
+        for (const auto& record : records) {
+            list.insert(record);
         }
         
         // Clear and rebuild MinHeap with pending tasks only
         heap = MinHeap();
-        for (const auto& task : tasks) {
-            if (!task.completed) {
-                heap.insert(task);
+        for (const auto& record : records) {
+            if (!record.completed) {
+                heap.insert(record);
             }
         }
+        mirrorsStale = false;
+    }
+
+    // Stable counting sort of positions by priority, so ties keep record order;
+    // every stored priority is 1-10 (checkPriority)
+    std::vector<uint32_t> orderByPriority(const std::vector<uint32_t>& positions) const {
+        std::vector<SortEntry<uint32_t>> entries;
+        entries.reserve(positions.size());
+        for (uint32_t position : positions) {
+            entries.push_back({uint32_t(records[position].priority), position});
+        }
+        countingSortByKey(entries, PRIORITY_BUCKETS);
+
+        std::vector<uint32_t> ordered;
+        ordered.reserve(entries.size());
+        for (const auto& entry : entries) ordered.push_back(entry.handle);
+        return ordered;
+    }
+
+    // Positions of the records accepted by pred, in record order
+    template <class Pred>
+    std::vector<uint32_t> selectPositions(Pred accepts, const std::atomic<bool>* cancelled) const {
+        auto matches = [&](size_t i) { return accepts(records[i]); };
+        if (useParallel(records.size())) {
+            return parallelFilterIndices(records.size(), matches, *pool, cancelled);
+        }
+        std::vector<uint32_t> positions;
+        for (size_t i = 0; i < records.size(); i++) {
+            if (i % CANCEL_CHECK_INTERVAL == 0 && isCancelled(cancelled)) break;
+            if (matches(i)) positions.push_back(uint32_t(i));
+        }
+        return positions;
+    }
+
+    std::vector<TaskRecord> gatherByPriority(bool pendingOnly, const std::atomic<bool>* cancelled) const {
+        auto positions = selectPositions([pendingOnly](const TaskRecord& task) {
+            return !pendingOnly || !task.completed;
+        }, cancelled);
+        if (isCancelled(cancelled)) return {};
+        positions = orderByPriority(positions);
+
+        std::vector<TaskRecord> prioritized;
+        prioritized.reserve(positions.size());
+        for (size_t i = 0; i < positions.size(); i++) {
+            if (i % CANCEL_CHECK_INTERVAL == 0 && isCancelled(cancelled)) return {};
+            prioritized.push_back(records[positions[i]]);
+        }
+        return prioritized;
+    }
+
+    std::vector<SortEntry<uint32_t>> deadlineOrder() const {
+        auto entries = makeSortEntries(records,
+            [](const TaskRecord& task) { return task.deadlineDay; });
+        if (useParallel(entries.size())) {
+            parallelStableSort(entries,
+                [](const SortEntry<uint32_t>& a, const SortEntry<uint32_t>& b) { return a.key < b.key; },
+                *pool);
+        }
+        else {
+            radixSortByKey(entries);
+        }
+        return entries;
     }
 
 public:
     TaskManager() {}
 
+    // Queries over at least `threshold` tasks are split across `threads` threads.
+    // 0 or 1 thread turns the parallel path off. Results are identical either way.
+    void setThreadCount(size_t threads, size_t threshold = PARALLEL_THRESHOLD) {
+        pool = threads > 1 ? std::make_shared<ThreadPool>(threads) : nullptr;
+        parallelThreshold = threshold;
+    }
+
+    size_t getThreadCount() const {
+        return pool ? pool->size() : 1;
+    }
+
+    // Groups the mutations up to the matching endBatch() into one step of the
+    // store: they share a single generation, so a reader comparing generations
+    // sees all of them or none. Undo history is still kept per mutation.
+    // Batches nest; only the outermost endBatch() publishes.
+    void beginBatch() {
+        batchDepth++;
+    }
+
+    void endBatch() {
+        if (--batchDepth > 0 || !batchChanged) return;
+        batchChanged = false;
+        generation++;
+    }
+
+    // Moves descriptions into a spill file; afterwards they are paged in on demand
+    // through an LRU cache of `cacheBytes`. Returns false if the file can't be created.
+    bool setColdStorePath(const std::string& path, size_t cacheBytes = 1 << 20) {
+        return cold.openFile(path, cacheBytes);
+    }
+
+    // Opens (or creates) the on-disk archive of completed tasks, read through a
+    // page cache of `cacheBytes`. Returns false if it can't be opened. New ids
+    // start past the archive's, so archived and live tasks never share one.
+    bool setArchivePath(const std::string& path, size_t cacheBytes = TaskArchive::DEFAULT_CACHE_BYTES) {
+        if (!archive.open(path, cacheBytes)) return false;
+        reserveIds(archive.maxId() + 1);
+        return true;
+    }
+
+    // Moves every completed task out of RAM into the archive, where it is
+    // read-only. Undo and redo history is dropped, since it may refer to the
+    // moved tasks. Returns how many were moved; 0 if there is no archive or
+    // writing it failed, in which case nothing changes.
+    size_t archiveCompleted() {
+        TRACE_SCOPE("engine", "TaskManager::archiveCompleted");
+        if (!archive.isOpen() || completedCount == 0) return 0;
+
+        std::vector<ArchivedTask> moved;
+        moved.reserve(completedCount);
+        for (const auto& record : records) {
+            if (!record.completed) continue;
+            moved.push_back(ArchivedTask{record, cold.get(record.descriptionRef)});
+            moved.back().record.descriptionRef = NO_COLD_REF;
+        }
+        if (!archive.append(moved)) return 0;
+
+        for (const auto& record : records) {
+            if (!record.completed) continue;
+            cold.erase(record.descriptionRef);
+            titles.remove(record.title, record.id);
+            positionOfId[record.id] = NO_POSITION;
+        }
+        records.erase(std::remove_if(records.begin(), records.end(),
+                                     [](const TaskRecord& record) { return record.completed; }),
+                      records.end());
+        indexPositions(0);
+        rebuildDeadlineIndex();
+        completedCount = 0;
+        undoActions.clear();
+        redoActions.clear();
+        syncDataStructures();
+        return moved.size();
+    }
+
+    const TaskArchive& getArchive() const {
+        return archive;
+    }
+
     int addTask(const std::string& title, const std::string& desc, 
                 const std::string& deadline, int priority) {
+        TRACE_SCOPE("engine", "TaskManager::addTask");
         if (title.empty()) {
             throw std::invalid_argument("Title cannot be empty");
         }
-        if (priority < 1 || priority > 10) {
-            throw std::invalid_argument("Priority must be between 1 and 10");
+        checkPriority(priority);
+        if (!Date::isValid(deadline)) {
+            throw std::invalid_argument("Deadline must be YYYY-MM-DD");
         }
         
-        Task newTask(nextId, title, desc, deadline, priority);
+        // Stored as a day number, so the undo entry holds the deadline as it reads back
+        Task newTask(nextId, title, desc, dayNumberToString(deadlineDayNumber(deadline)), priority);
         
         // Store for undo
         UndoAction action("add", Task(), newTask);
         undoActions.push(action);
         
         // Add to main storage
-        tasks.push_back(newTask);
+        appendRecord(newTask);
         
         // Sync all data structures
-        syncDataStructures();
+        syncDataStructures(newTask.id);
         
         return nextId++;
     }
 
+    // Bulk load (e.g. from a saved store); keeps the given ids and records no undo history
+    void importTasks(const std::vector<Task>& tasks) {
+        TRACE_SCOPE("engine", "TaskManager::importTasks");
+        checkPriorities(tasks);
+        size_t from = records.size();
+        records.reserve(records.size() + tasks.size());
+        titles.reserve(records.size() + tasks.size());
+        for (const auto& task : tasks) {
+            appendRecord(task, false);
+            nextId = std::max(nextId, task.id + 1);
+        }
+        deadlines.addRange(records, from);
+        syncDataStructures();
+    }
+
+    // Replaces every task with `tasks`, keeping their ids and order, as when a
+    // copy of another store is reloaded after that store moved on. Undo and
+    // redo history is dropped, since it may refer to tasks that are gone.
+    // New ids start past the highest given or archived one; reserveIds()
+    // continues the other store's numbering instead.
+    void replaceTasks(const std::vector<Task>& tasks) {
+        TRACE_SCOPE("engine", "TaskManager::replaceTasks");
+        checkPriorities(tasks);
+        for (const auto& record : records) {
+            cold.erase(record.descriptionRef);
+            positionOfId[record.id] = NO_POSITION;
+        }
+        records.clear();
+        deadlines.clear();
+        titles.clear();
+        completedCount = 0;
+        undoActions.clear();
+        redoActions.clear();
+        nextId = archive.maxId() + 1;
+        importTasks(tasks);
+    }
+
     void deleteTask(int id) {
-        auto it = std::find_if(tasks.begin(), tasks.end(),
-            [id](const Task& task) { return task.id == id; });
-        if (it != tasks.end()) {
+        TRACE_SCOPE("engine", "TaskManager::deleteTask");
+        auto it = findRecord(id);
+        if (it != records.end()) {
             // Store for undo
-            UndoAction action("delete", *it, Task());
+            UndoAction action("delete", toTask(*it), Task());
             undoActions.push(action);
             
-            tasks.erase(it);
-            syncDataStructures();
+            eraseRecord(it);
+            syncDataStructures(id);
         }
     }
 
     void updateTask(int id, const std::string& title, const std::string& desc,
                    const std::string& deadline, int priority) {
-        auto it = std::find_if(tasks.begin(), tasks.end(),
-            [id](const Task& task) { return task.id == id; });
-        if (it != tasks.end()) {
+        TRACE_SCOPE("engine", "TaskManager::updateTask");
+        checkPriority(priority);
+        if (!Date::isValid(deadline)) {
+            throw std::invalid_argument("Deadline must be YYYY-MM-DD");
+        }
+        auto it = findRecord(id);
+        if (it != records.end()) {
             // Store original for undo
-            Task beforeTask = *it;
+            Task beforeTask = toTask(*it);
             
             // Update task
-            it->title = title;
-            it->description = desc;
-            it->deadline = deadline;
-            it->priority = priority;
+            Task afterTask = beforeTask;
+            afterTask.title = title;
+            afterTask.description = desc;
+            afterTask.deadline = deadline;
+            afterTask.priority = priority;
+            assignRecord(*it, afterTask);
             
             // Store for undo
-            UndoAction action("edit", beforeTask, *it);
+            UndoAction action("edit", beforeTask, toTask(*it));
             undoActions.push(action);
             
             // Sync all data structures
-            syncDataStructures();
+            syncDataStructures(id);
         }
     }
 
     void markTaskCompleted(int id) {
-        auto it = std::find_if(tasks.begin(), tasks.end(),
-            [id](const Task& task) { return task.id == id; });
-        if (it != tasks.end()) {
-            Task beforeTask = *it;
+        TRACE_SCOPE("engine", "TaskManager::markTaskCompleted");
+        auto it = findRecord(id);
+        if (it != records.end()) {
+            Task beforeTask = toTask(*it);
+            if (!it->completed) completedCount++;
+            deadlines.setCompleted(it->deadlineDay, it->completed, true);
             it->completed = true;
+            it->version = nextVersion++;
             
-            UndoAction action("edit", beforeTask, *it);
+            UndoAction action("edit", beforeTask, toTask(*it));
             undoActions.push(action);
             
-            syncDataStructures();
+            syncDataStructures(id);
         }
     }
 
-    std::vector<Task> getAllTasks() const {
-        return tasks;
+    size_t getTaskCount() const {
+        return records.size();
     }
 
-    std::vector<Task> getPendingTasks() const {
-        std::vector<Task> pending;
-        std::copy_if(tasks.begin(), tasks.end(), std::back_inserter(pending),
-            [](const Task& task) { return !task.completed; });
-        return pending;
+    size_t getPendingCount() const {
+        return records.size() - completedCount;
     }
 
-    std::vector<Task> getCompletedTasks() const {
-        std::vector<Task> completed;
-        std::copy_if(tasks.begin(), tasks.end(), std::back_inserter(completed),
-            [](const Task& task) { return task.completed; });
-        return completed;
+    size_t getCompletedCount() const {
+        return completedCount;
     }
 
-    std::vector<Task> searchTasks(const std::string& query) const {
-        std::vector<Task> results;
-        std::copy_if(tasks.begin(), tasks.end(), std::back_inserter(results),
-            [&query](const Task& task) {
-                return task.title.find(query) != std::string::npos ||
-                       task.description.find(query) != std::string::npos;       //no position if no match is found
-            });
-        return results;
+    // Pending tasks due on each day number in [first, last] (see dayNumberOf),
+    // into counts[day - first]. Reads the maintained per-day counts: the cost
+    // depends on the number of days, not tasks.
+    void pendingPerDay(uint32_t first, uint32_t last, std::vector<uint32_t>& counts) const {
+        deadlines.pendingCounts(first, last, counts);
     }
 
-    std::vector<Task> getTasksByPriority() const {
-        std::vector<Task> prioritized = tasks;
-        std::sort(prioritized.begin(), prioritized.end(),
-            [](const Task& a, const Task& b) {
-                return a.priority < b.priority;
-            });
-        return prioritized;
+    // Ids of every task titled exactly `title`, in display order; O(1) expected
+    // plus the matches
+    std::vector<int> findByTitle(const std::string& title) const {
+        std::vector<int> ids;
+        titles.forEachCandidate(title, [&](int id) {
+            if (records[positionOfId[id]].title == title) ids.push_back(id);
+        });
+        std::sort(ids.begin(), ids.end(),
+                  [this](int a, int b) { return positionOfId[a] < positionOfId[b]; });
+        return ids;
+    }
+
+    // Ids of the tasks (pending or completed) due on `day`, in display order
+    std::vector<int> tasksDueOn(uint32_t day) const {
+        TRACE_SCOPE("engine", "TaskManager::tasksDueOn");
+        const std::vector<int>* due = deadlines.idsOn(day);
+        if (due == nullptr) return {};
+        std::vector<int> ids(*due);
+        std::sort(ids.begin(), ids.end(),
+                  [this](int a, int b) { return positionOfId[a] < positionOfId[b]; });
+        return ids;
+    }
+
+    // Changes whenever a task is added, removed, edited or reordered
+    uint64_t getGeneration() const {
+        return generation;
+    }
+
+    // The id the next addTask() will assign
+    int getNextId() const {
+        return nextId;
+    }
+
+    // Makes later adds assign ids from `next` on (never lower), so a copy of
+    // another manager's tasks keeps handing out the same ids as the original
+    void reserveIds(int next) {
+        nextId = std::max(nextId, next);
+    }
+
+    // Bytes held by the id index and the change journal; O(1), unlike memoryReport()
+    size_t indexBytes() const {
+        return positionOfId.capacity() * sizeof(uint32_t) + changeLog.size() * sizeof(TaskChange);
+    }
+
+    // Index of the task in display order, NO_POSITION if there is no such id
+    size_t positionOf(int id) const {
+        if (id < 0 || size_t(id) >= positionOfId.size()) return NO_POSITION;
+        return positionOfId[id];
+    }
+
+    // Ids of the tasks added, removed or edited since `since`, oldest first and
+    // possibly repeated. Returns false if that is not known: the journal no
+    // longer reaches back that far, or the tasks were reordered in between.
+    bool changesSince(uint64_t since, std::vector<int>& changedIds) const {
+        changedIds.clear();
+        if (since == generation) return true;
+        if (changeLog.empty() || changeLog.front().generation > since + 1) return false;
+        for (auto it = std::lower_bound(changeLog.begin(), changeLog.end(), since + 1,
+                 [](const TaskChange& change, uint64_t g) { return change.generation < g; });
+             it != changeLog.end(); ++it) {
+            if (it->reordered) return false;
+            changedIds.push_back(it->id);
+        }
+        return true;
+    }
+
+    // The query methods below take an optional cancellation flag. They may run
+    // on another thread alongside other const calls, but not alongside a
+    // mutation; once the flag is raised they return early with a partial result.
+
+    std::vector<TaskRecord> getAllTasks(const std::atomic<bool>* cancelled = nullptr) const {
+        TRACE_SCOPE("engine", "TaskManager::getAllTasks");
+        if (cancelled == nullptr) return records;
+        return filterTasks([](const TaskRecord&) { return true; }, cancelled);
+    }
+
+    // Up to `count` records starting at position `first`, in display order
+    std::vector<TaskRecord> getTasks(size_t first, size_t count) const {
+        first = std::min(first, records.size());
+        count = std::min(count, records.size() - first);
+        return std::vector<TaskRecord>(records.begin() + first, records.begin() + first + count);
+    }
+
+    // Records in display order, for views that stream them instead of copying;
+    // invalidated by any mutation
+    std::vector<TaskRecord>::const_iterator begin() const { return records.begin(); }
+    std::vector<TaskRecord>::const_iterator end() const { return records.end(); }
+
+    std::vector<TaskRecord> getPendingTasks(const std::atomic<bool>* cancelled = nullptr) const {
+        TRACE_SCOPE("engine", "TaskManager::getPendingTasks");
+        return filterTasks([](const TaskRecord& task) { return !task.completed; }, cancelled);
     }
 
-    Task* getTask(int id) {
-        auto it = std::find_if(tasks.begin(), tasks.end(),
-            [id](const Task& task) { return task.id == id; });      //auto it automatically deduces the iterator type
-        return it != tasks.end() ? &(*it) : nullptr;        //*it: Dereferences the iterator to get the actual Task object
-                                                            //&(*it): Gets the address of the found task — returns a pointer (Task*)
+    std::vector<TaskRecord> getCompletedTasks(const std::atomic<bool>* cancelled = nullptr) const {
+        TRACE_SCOPE("engine", "TaskManager::getCompletedTasks");
+        return filterTasks([](const TaskRecord& task) { return task.completed; }, cancelled);
     }
 
+    std::vector<TaskRecord> searchTasks(const std::string& query, const std::atomic<bool>* cancelled = nullptr) const {
+        TRACE_SCOPE("engine", "TaskManager::searchTasks");
+        return filterTasks([this, &query](const TaskRecord& task) { return matchesQuery(task, query); }, cancelled);
+    }
+
+    // True if `previous` can seed a search for `query`: complete, still
+    // current, and its query is contained in the new one
+    bool canRefine(const SearchMatches& previous, const std::string& query) const {
+        return previous.complete && previous.generation == generation &&
+               query.find(previous.query) != std::string::npos;
+    }
+
+    // Same matches as searchTasks(), as positions. With a usable `previous`
+    // only its positions are re-checked instead of every record.
+    SearchMatches searchMatches(const std::string& query, const SearchMatches* previous = nullptr,
+                                const std::atomic<bool>* cancelled = nullptr) const {
+        TRACE_SCOPE("engine", "TaskManager::searchMatches");
+        SearchMatches result;
+        result.query = query;
+        result.generation = generation;
+
+        if (previous != nullptr && canRefine(*previous, query)) {
+            const std::vector<uint32_t>& candidates = previous->positions;
+            auto matches = [&](size_t i) { return matchesQuery(records[candidates[i]], query); };
+            if (useParallel(candidates.size())) {
+                result.positions = parallelFilterIndices(candidates.size(), matches, *pool, cancelled);
+                for (uint32_t& position : result.positions) position = candidates[position];
+            }
+            else {
+                for (size_t i = 0; i < candidates.size(); i++) {
+                    if (i % CANCEL_CHECK_INTERVAL == 0 && isCancelled(cancelled)) break;
+                    if (matches(i)) result.positions.push_back(candidates[i]);
+                }
+            }
+        }
+        else {
+            result.positions = selectPositions(
+                [&](const TaskRecord& task) { return matchesQuery(task, query); }, cancelled);
+        }
+        result.complete = !isCancelled(cancelled);
+        return result;
+    }
+
+    // Ids of the tasks at `matches`, which must still be current
+    std::vector<int> idsAt(const SearchMatches& matches) const {
+        TRACE_SCOPE("engine", "TaskManager::idsAt");
+        std::vector<int> ids;
+        if (matches.generation != generation) return ids;
+        ids.reserve(matches.positions.size());
+        for (uint32_t position : matches.positions) ids.push_back(records[position].id);
+        return ids;
+    }
+
+    bool taskMatches(const TaskRecord& task, const std::string& query) const {
+        return matchesQuery(task, query);
+    }
+
+    // Ids of the tasks accepted by pred, in record order or, with byPriority,
+    // by priority with ties in record order (the order getTasksByPriority uses)
+    template <class Pred>
+    std::vector<int> selectIds(Pred accepts, bool byPriority, const std::atomic<bool>* cancelled = nullptr) const {
+        TRACE_SCOPE("engine", "TaskManager::selectIds");
+        std::vector<uint32_t> positions = selectPositions(accepts, cancelled);
+        if (isCancelled(cancelled)) return {};
+        if (byPriority) positions = orderByPriority(positions);
+
+        std::vector<int> ids;
+        ids.reserve(positions.size());
+        for (uint32_t position : positions) ids.push_back(records[position].id);
+        return ids;
+    }
+
+    std::vector<TaskRecord> searchByDeadline(const std::string& date, const std::atomic<bool>* cancelled = nullptr) const {
+        TRACE_SCOPE("engine", "TaskManager::searchByDeadline");
+        uint32_t day = deadlineDayNumber(date);
+        return filterTasks([day](const TaskRecord& task) { return day != NO_DEADLINE_KEY && task.deadlineDay == day; }, cancelled);
+    }
+
+    // Stable counting sort over (priority, index) pairs; records are copied once, already in order
+    std::vector<TaskRecord> getTasksByPriority(const std::atomic<bool>* cancelled = nullptr) const {
+        TRACE_SCOPE("engine", "TaskManager::getTasksByPriority");
+        return gatherByPriority(false, cancelled);
+    }
+
+    std::vector<TaskRecord> getPendingTasksByPriority(const std::atomic<bool>* cancelled = nullptr) const {
+        TRACE_SCOPE("engine", "TaskManager::getPendingTasksByPriority");
+        return gatherByPriority(true, cancelled);
+    }
+
+    const TaskRecord* getRecord(int id) const {
+        size_t position = positionOf(id);
+        return position == NO_POSITION ? nullptr : &records[position];
+    }
+
+    // Full task including its cold fields; returns false if the id is unknown
+    bool getTask(int id, Task& out) const {
+        TRACE_SCOPE("engine", "TaskManager::getTask");
+        const TaskRecord* record = getRecord(id);
+        if (record == nullptr) return false;
+        out = toTask(*record);
+        return true;
+    }
+
+    std::string getDescription(const TaskRecord& record) const {
+        return cold.get(record.descriptionRef);
+    }
+
+    // LSD radix sort on day numbers; each record is moved once instead of swapped repeatedly
     void sortByDeadline() {
-        std::sort(tasks.begin(), tasks.end(),
-            [](const Task& a, const Task& b) {
-                Date dateA(a.deadline);
-                Date dateB(b.deadline);
-                return dateA.isLessThan(dateB);
-            });
+        TRACE_SCOPE("engine", "TaskManager::sortByDeadline");
+        auto entries = deadlineOrder();
+        applySortOrder(records, entries);
+        indexPositions(0);
+        syncDataStructures();
+    }
+
+    // Read-only half of sortByDeadline for running off the UI thread: returns
+    // the records in deadline order without touching the store. Hand the
+    // result to replaceOrder() together with the generation read beforehand.
+    std::vector<TaskRecord> sortedByDeadline(const std::atomic<bool>* cancelled = nullptr) const {
+        TRACE_SCOPE("engine", "TaskManager::sortedByDeadline");
+        auto entries = deadlineOrder();
+        std::vector<TaskRecord> sorted;
+        if (isCancelled(cancelled)) return sorted;
+        sorted.reserve(entries.size());
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (i % CANCEL_CHECK_INTERVAL == 0 && isCancelled(cancelled)) return {};
+            sorted.push_back(records[entries[i].handle]);
+        }
+        return sorted;
+    }
+
+    // Swaps in a reordering of the current records. Refused (returns false) if
+    // anything changed since `expectedGeneration`. On success `ordered` holds
+    // the previous records, so the caller decides where they get freed.
+    bool replaceOrder(std::vector<TaskRecord>& ordered, uint64_t expectedGeneration) {
+        TRACE_SCOPE("engine", "TaskManager::replaceOrder");
+        if (expectedGeneration != generation || ordered.size() != records.size()) return false;
+        records.swap(ordered);
+        indexPositions(0);
         syncDataStructures();
+        return true;
     }
 
     void editTask(int id, const string& newTitle, const string& newDeadline) {
-        auto it = std::find_if(tasks.begin(), tasks.end(),
-            [id](const Task& task) { return task.id == id; });
-        if (it != tasks.end()) {
-            Task beforeTask = *it;
+        TRACE_SCOPE("engine", "TaskManager::editTask");
+        if (!Date::isValid(newDeadline)) {
+            throw std::invalid_argument("Deadline must be YYYY-MM-DD");
+        }
+        auto it = findRecord(id);
+        if (it != records.end()) {
+            Task beforeTask = toTask(*it);
             
+            if (it->title != newTitle) {
+                titles.remove(it->title, id);
+                titles.add(newTitle, id);
+            }
             it->title = newTitle;
-            it->deadline = newDeadline;
+            it->deadlineDay = deadlineDayNumber(newDeadline);
+            it->version = nextVersion++;
+            reindexDeadline(*it, deadlineDayNumber(beforeTask.deadline), it->completed);
             
-            UndoAction action("edit", beforeTask, *it);
+            UndoAction action("edit", beforeTask, toTask(*it));
             undoActions.push(action);
             
-            syncDataStructures();
+            syncDataStructures(id);
         }
     }
 
     void updatePriority(int id, int newPriority) {
-        auto it = std::find_if(tasks.begin(), tasks.end(),
-            [id](const Task& task) { return task.id == id; });
-        if (it != tasks.end()) {
-            Task beforeTask = *it;
+        TRACE_SCOPE("engine", "TaskManager::updatePriority");
+        checkPriority(newPriority);
+        auto it = findRecord(id);
+        if (it != records.end()) {
+            Task beforeTask = toTask(*it);
             
             it->priority = newPriority;
+            it->version = nextVersion++;
             
-            UndoAction action("edit", beforeTask, *it);
+            UndoAction action("edit", beforeTask, toTask(*it));
             undoActions.push(action);
             
-            syncDataStructures();
+            syncDataStructures(id);
         }
     }
 
+    // Undo and redo steps, oldest first
+    std::vector<UndoAction> getUndoHistory() const {
+        return undoActions.contents();
+    }
+
+    std::vector<UndoAction> getRedoHistory() const {
+        return redoActions.contents();
+    }
+
+    // Makes this manager, which must be empty, a copy of one with these tasks
+    // (in display order), next id, generation and undo history, so that both
+    // handle the same commands alike from here on
+    void restoreState(const std::vector<Task>& tasks, int next, uint64_t atGeneration,
+                      const std::vector<UndoAction>& undo, const std::vector<UndoAction>& redo) {
+        checkPriorities(tasks);
+        for (const auto& steps : {&undo, &redo}) {
+            for (const UndoAction& action : *steps) {
+                checkPriority(action.before.priority);
+                checkPriority(action.after.priority);
+            }
+        }
+        importTasks(tasks);
+        reserveIds(next);
+        for (const UndoAction& action : undo) undoActions.push(action);
+        for (const UndoAction& action : redo) redoActions.push(action);
+        generation = atGeneration;
+        changeLog.clear();
+        changeLog.push_back({generation, 0, true});
+    }
+
+    bool canUndo() const {
+        return !undoActions.isEmpty();
+    }
+
+    bool canRedo() const {
+        return !redoActions.isEmpty();
+    }
+
     void undo() {
+        TRACE_SCOPE("engine", "TaskManager::undo");
         if (!undoActions.isEmpty()) {
             UndoAction action = undoActions.pop();
+            int changedId = action.type == "add" ? action.after.id : action.before.id;
             
             if (action.type == "add") {
                 // Remove the added task
-                auto it = std::find_if(tasks.begin(), tasks.end(),
-                    [&action](const Task& task) { return task.id == action.after.id; });
-                if (it != tasks.end()) {
-                    tasks.erase(it);
+                auto it = findRecord(action.after.id);
+                if (it != records.end()) {
+                    eraseRecord(it);
                 }
             }
             else if (action.type == "edit") {
                 // Restore the previous version
-                auto it = std::find_if(tasks.begin(), tasks.end(),
-                    [&action](const Task& task) { return task.id == action.before.id; });
-                if (it != tasks.end()) {
-                    *it = action.before;
+                auto it = findRecord(action.before.id);
+                if (it != records.end()) {
+                    assignRecord(*it, action.before);
                 }
             }
             else if (action.type == "delete") {
                 // Restore the deleted task
-                tasks.push_back(action.before);
+                appendRecord(action.before);
             }
             
-            syncDataStructures();
+            syncDataStructures(changedId);
             redoActions.push(action);
         }
     }
 
     void redo() {
+        TRACE_SCOPE("engine", "TaskManager::redo");
         if (!redoActions.isEmpty()) {
             UndoAction action = redoActions.pop();
+            int changedId = action.type == "add" ? action.after.id : action.before.id;
             
             if (action.type == "add") {
                 // Re-add the task
-                tasks.push_back(action.after);
+                appendRecord(action.after);
             }
             else if (action.type == "edit") {
                 // Restore the edited version
-                auto it = std::find_if(tasks.begin(), tasks.end(),
-                    [&action](const Task& task) { return task.id == action.after.id; });
-                if (it != tasks.end()) {
-                    *it = action.after;
+                auto it = findRecord(action.after.id);
+                if (it != records.end()) {
+                    assignRecord(*it, action.after);
                 }
             }
             else if (action.type == "delete") {
                 // Re-delete the task
-                auto it = std::find_if(tasks.begin(), tasks.end(),
-                    [&action](const Task& task) { return task.id == action.before.id; });
-                if (it != tasks.end()) {
-                    tasks.erase(it);
+                auto it = findRecord(action.before.id);
+                if (it != records.end()) {
+                    eraseRecord(it);
                 }
             }
             
-            syncDataStructures();
+            syncDataStructures(changedId);
             undoActions.push(action);
         }
     }
     
+    MemoryReport memoryReport() const {
+        TRACE_SCOPE("engine", "TaskManager::memoryReport");
+        MemoryReport report;
+        report.taskCount = records.size();
+
+        MemoryUsage storage;
+        storage.structBytes = sizeof(records) + records.capacity() * sizeof(TaskRecord);
+        if (records.capacity() > 0) storage.addAllocation(records.capacity() * sizeof(TaskRecord));
+        for (const auto& record : records) {
+            storage.addRecordStrings(record);
+        }
+
+        ensureMirrors();
+        report.components.push_back({"hot records", storage});
+        report.components.push_back({"cold store", cold.memoryUsage()});
+
+        MemoryUsage index;
+        index.structBytes = positionOfId.capacity() * sizeof(uint32_t) + changeLog.size() * sizeof(TaskChange);
+        if (positionOfId.capacity() > 0) index.addAllocation(positionOfId.capacity() * sizeof(uint32_t));
+        report.components.push_back({"id index", index});
+        report.components.push_back({"deadline index", deadlines.memoryUsage()});
+        report.components.push_back({"title index", titles.memoryUsage()});
+
+        MemoryUsage archived;
+        archived.structBytes = archive.indexBytes() + archive.cacheBytes();
+        report.components.push_back({"archive pages", archived});
+        report.components.push_back({"list index", list.memoryUsage()});
+        report.components.push_back({"heap index", heap.memoryUsage()});
+        report.components.push_back({"undo log", undoActions.memoryUsage()});
+        report.components.push_back({"redo log", redoActions.memoryUsage()});
+        return report;
+    }
+
     // Getter methods for data structures
-    MinHeap& getHeap() { return heap; }
-    TaskList& getList() { return list; }
-};
\ No newline at end of file
+    MinHeap& getHeap() { ensureMirrors(); return heap; }
+    TaskList& getList() { ensureMirrors(); return list; }
+};
@@ -0,0 +1,1262 @@
+#include "task_manager.hpp"
+#include "query_worker.hpp"
+#include "display_list.hpp"
+#include "frame_stats.hpp"
+#include "batch_script.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#ifdef __linux__
+#include <csignal>
+#include <unordered_map>
+#include <sys/wait.h>
+#include "task_server.hpp"
+#include "task_client.hpp"
+#include "task_snapshot.hpp"
+#endif
+
+using namespace std;
+
+// ------------------ Benchmark Helpers ------------------
+// Every result is printed as one JSON object per line so runs can be diffed
+// or collected by CI. Usage:
+//   task_manager_bench [section] [--tasks N] [--threads N] [--max-bytes-per-task N]
+//                      [--archive-rows N]
+
+struct BenchOptions {
+    string section;
+    size_t taskCount = 1000000;     // size of generated sets for the scaling benchmarks
+    size_t maxThreads = 0;          // 0 = hardware_concurrency()
+    double maxBytesPerTask = 0;     // 0 = no budget check
+    size_t archiveRows = 10000000;  // rows written for the archive section
+};
+
+static bool failed = false;
+
+string makeTitle(int i) {
+    return "Task " + to_string(i) + " follow up with the team";
+}
+
+string makeDescription(int i) {
+    return "Description for task " + to_string(i) + ", long enough to leave the SSO buffer";
+}
+
+string makeDeadline(int i) {
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", 2025 + i % 3, 1 + i % 12, 1 + i % 28);
+    return string(buffer);
+}
+
+vector<Task> makeTasks(size_t count) {
+    vector<Task> tasks;
+    tasks.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        int n = int(i * 2654435761u % 1000003);   // scatter keys so the input is not presorted
+        tasks.emplace_back(int(i + 1), makeTitle(n), makeDescription(n), makeDeadline(n), 1 + n % 10);
+        tasks.back().completed = (n % 3 == 0);
+    }
+    return tasks;
+}
+
+template <class Fn>
+double timeMs(Fn fn) {
+    auto start = chrono::steady_clock::now();
+    fn();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+void report(const string& bench, const string& variant, size_t count, double ms, size_t threads = 1) {
+    cout << "{\"bench\":\"" << bench << "\",\"variant\":\"" << variant
+         << "\",\"task_count\":" << count << ",\"threads\":" << threads
+         << ",\"ms\":" << fixed << setprecision(2) << ms << "}" << endl;
+}
+
+void check(bool ok, const string& what) {
+    if (!ok) {
+        cerr << "mismatch: " << what << endl;
+        failed = true;
+    }
+}
+
+bool sameOrder(const vector<Task>& a, const vector<Task>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].id != b[i].id) return false;
+    }
+    return true;
+}
+
+// ------------------ Sorting ------------------
+// Compares the comparison sorts the engine used to run over full Task
+// objects with the counting/radix paths over (key, index) pairs.
+void benchSort(const BenchOptions& options) {
+    const vector<Task> source = makeTasks(options.taskCount);
+    size_t n = source.size();
+
+    // Priority: copy + std::stable_sort vs counting sort + gather
+    vector<Task> byComparison, byCounting;
+    report("sort_priority", "std_sort", n, timeMs([&] {
+        byComparison = source;
+        stable_sort(byComparison.begin(), byComparison.end(),
+            [](const Task& a, const Task& b) { return a.priority < b.priority; });
+    }));
+    report("sort_priority", "counting", n, timeMs([&] {
+        auto entries = makeSortEntries(source,
+            [](const Task& task) { return uint32_t(task.priority); });
+        countingSortByKey(entries, PRIORITY_BUCKETS);
+        byCounting.clear();
+        byCounting.reserve(entries.size());
+        for (const auto& entry : entries) byCounting.push_back(source[entry.handle]);
+    }));
+    check(sameOrder(byComparison, byCounting), "priority order");
+
+    // Deadline: std::sort with the Date comparator vs radix on day numbers
+    vector<Task> byDate = source, byRadix = source;
+    report("sort_deadline", "std_sort", n, timeMs([&] {
+        stable_sort(byDate.begin(), byDate.end(),
+            [](const Task& a, const Task& b) {
+                Date dateA(a.deadline);
+                Date dateB(b.deadline);
+                return dateA.isLessThan(dateB);
+            });
+    }));
+    report("sort_deadline", "radix", n, timeMs([&] {
+        auto entries = makeSortEntries(byRadix,
+            [](const Task& task) { return deadlineDayNumber(task.deadline); });
+        radixSortByKey(entries);
+        applySortOrder(byRadix, entries);
+    }));
+    check(sameOrder(byDate, byRadix), "deadline order");
+
+    // Composite (deadline, priority)
+    vector<Task> byPair = source, byComposite = source;
+    report("sort_deadline_priority", "std_sort", n, timeMs([&] {
+        stable_sort(byPair.begin(), byPair.end(),
+            [](const Task& a, const Task& b) {
+                uint32_t dayA = deadlineDayNumber(a.deadline), dayB = deadlineDayNumber(b.deadline);
+                return dayA != dayB ? dayA < dayB : a.priority < b.priority;
+            });
+    }));
+    report("sort_deadline_priority", "radix", n, timeMs([&] {
+        auto entries = makeSortEntries(byComposite,
+            [](const Task& task) { return deadlinePriorityKey(task.deadline, task.priority); });
+        radixSortByKey(entries);
+        applySortOrder(byComposite, entries);
+    }));
+    check(sameOrder(byPair, byComposite), "deadline/priority order");
+}
+
+// ------------------ Parallel Queries ------------------
+// Scaling curve from 1 to hardware_concurrency() threads for the same
+// filter/search/sort paths TaskManager takes above PARALLEL_THRESHOLD.
+void benchParallel(const BenchOptions& options) {
+    const vector<Task> source = makeTasks(options.taskCount);
+    size_t n = source.size();
+
+    auto isPending = [](const Task& task) { return !task.completed; };
+    const string query = "task 42";
+    auto matches = [&query](const Task& task) {
+        return task.title.find(query) != string::npos ||
+               task.description.find(query) != string::npos;
+    };
+    auto byKey = [](const SortEntry<uint32_t>& a, const SortEntry<uint32_t>& b) { return a.key < b.key; };
+    const auto deadlineEntries = makeSortEntries(source,
+        [](const Task& task) { return deadlineDayNumber(task.deadline); });
+
+    vector<Task> serialPending, serialSearch;
+    copy_if(source.begin(), source.end(), back_inserter(serialPending), isPending);
+    copy_if(source.begin(), source.end(), back_inserter(serialSearch), matches);
+    auto serialSorted = deadlineEntries;
+    radixSortByKey(serialSorted);
+
+    size_t maxThreads = options.maxThreads ? options.maxThreads : max(1u, thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        ThreadPool pool(threads);
+
+        vector<Task> pending, found;
+        report("parallel_filter", "pending", n, timeMs([&] {
+            pending = parallelFilter(source, isPending, pool);
+        }), threads);
+        check(sameOrder(pending, serialPending), "parallel filter");
+
+        report("parallel_search", "substring", n, timeMs([&] {
+            found = parallelFilter(source, matches, pool);
+        }), threads);
+        check(sameOrder(found, serialSearch), "parallel search");
+
+        auto sorted = deadlineEntries;
+        report("parallel_sort", "merge", n, timeMs([&] {
+            parallelStableSort(sorted, byKey, pool);
+        }), threads);
+        bool same = true;
+        for (size_t i = 0; i < sorted.size(); i++) {
+            if (sorted[i].handle != serialSorted[i].handle) same = false;
+        }
+        check(same, "parallel sort");
+
+        if (threads < maxThreads && threads * 2 > maxThreads) threads = maxThreads / 2;
+    }
+}
+
+// ------------------ Memory ------------------
+// Footprint at 10k, 100k and 1M tasks (up to --tasks). The undo and redo rings
+// are fixed-size, so they only stop dominating bytes per task at these sizes;
+// the budget applies to the largest size measured.
+void benchMemory(const BenchOptions& options) {
+    vector<size_t> sizes;
+    for (size_t count : {10000, 100000, 1000000}) {
+        if (count <= max<size_t>(options.taskCount, 10000)) sizes.push_back(count);
+    }
+    for (size_t count : sizes) {
+        TaskManager manager;
+        for (size_t i = 0; i < count; i++) {
+            manager.addTask(makeTitle(int(i)), makeDescription(int(i)), makeDeadline(int(i)), 1 + int(i % 10));
+        }
+
+        MemoryReport report = manager.memoryReport();
+        cout << "{\"bench\":\"memory\",\"task_count\":" << count;
+        for (const auto& component : report.components) {
+            cout << ",\"" << component.first << "\":" << component.second.total();
+        }
+        cout << ",\"total\":" << report.total().total()
+             << ",\"bytes_per_task\":" << fixed << setprecision(1) << report.bytesPerTask()
+             << "}" << endl;
+
+        if (count == sizes.back() && options.maxBytesPerTask > 0 && report.bytesPerTask() > options.maxBytesPerTask) {
+            cerr << "memory regression: " << report.bytesPerTask() << " bytes/task at "
+                 << count << " tasks exceeds budget of " << options.maxBytesPerTask << endl;
+            failed = true;
+        }
+    }
+}
+
+// ------------------ Working Set ------------------
+// Bytes a list view holds: full Task copies (description included) versus the
+// hot TaskRecords the engine now returns, and the engine footprint with the
+// cold store in memory versus paged from a spill file.
+template <class T, class AddStrings>
+MemoryUsage vectorUsage(const vector<T>& items, AddStrings addStrings) {
+    MemoryUsage usage;
+    usage.structBytes = items.capacity() * sizeof(T);
+    if (items.capacity()) usage.addAllocation(items.capacity() * sizeof(T));
+    for (const auto& item : items) addStrings(usage, item);
+    return usage;
+}
+
+void benchWorkingSet(const BenchOptions& options) {
+    vector<Task> source = makeTasks(options.taskCount);
+    size_t n = source.size();
+
+    MemoryUsage fullList = vectorUsage(source,
+        [](MemoryUsage& usage, const Task& task) { usage.addTaskStrings(task); });
+
+    for (bool spill : {false, true}) {
+        TaskManager manager;
+        if (spill && !manager.setColdStorePath("task_manager_bench.cold")) {
+            cerr << "cannot create task_manager_bench.cold" << endl;
+            failed = true;
+            continue;
+        }
+        manager.importTasks(source);
+
+        vector<TaskRecord> hotList;
+        double ms = timeMs([&] { hotList = manager.getAllTasks(); });
+        MemoryUsage hot = vectorUsage(hotList,
+            [](MemoryUsage& usage, const TaskRecord& record) { usage.addRecordStrings(record); });
+        MemoryReport engine = manager.memoryReport();
+
+        cout << "{\"bench\":\"working_set\",\"cold_store\":\"" << (spill ? "file" : "memory")
+             << "\",\"task_count\":" << n
+             << ",\"full_list_bytes\":" << fullList.total()
+             << ",\"hot_list_bytes\":" << hot.total()
+             << ",\"shrink\":" << fixed << setprecision(2) << double(fullList.total()) / hot.total()
+             << ",\"list_ms\":" << ms
+             << ",\"engine_bytes_per_task\":" << setprecision(1) << engine.bytesPerTask()
+             << "}" << endl;
+    }
+    remove("task_manager_bench.cold");
+}
+
+// ------------------ Worker ------------------
+// What the UI thread pays when queries run on the QueryWorker: the longest
+// poll() loop iteration while a search runs (the frame budget the worker
+// leaves intact), the time from cancel() to holding the engine's write lock
+// (what a mutation waits for), and applying a result by swapping it in.
+void benchWorker(const BenchOptions& options) {
+    TaskManager manager;
+    manager.importTasks(makeTasks(options.taskCount));
+    size_t n = options.taskCount;
+    shared_mutex engineMutex;
+    QueryWorker worker;
+
+    const string query = "task 42";
+    const vector<TaskRecord> expected = manager.searchTasks(query);
+
+    auto submitSearch = [&](vector<TaskRecord>& displayed, bool& done) {
+        worker.submit([&](const atomic<bool>& cancelled) -> QueryWorker::Completion {
+            auto result = make_shared<vector<TaskRecord>>();
+            {
+                shared_lock<shared_mutex> lock(engineMutex);
+                *result = manager.searchTasks(query, &cancelled);
+            }
+            return [&displayed, &done, result] {
+                displayed.swap(*result);
+                done = true;
+            };
+        });
+    };
+
+    vector<TaskRecord> displayed;
+    bool done = false;
+    double longestPollMs = 0;
+    double totalMs = timeMs([&] {
+        submitSearch(displayed, done);
+        while (!done) {
+            longestPollMs = max(longestPollMs, timeMs([&] { worker.poll(); }));
+            this_thread::sleep_for(chrono::microseconds(200));
+        }
+    });
+    report("worker_search", "submit_to_result", n, totalMs);
+    report("worker_search", "longest_ui_poll", n, longestPollMs);
+    check(displayed.size() == expected.size(), "worker search");
+
+    // Cancel partway through the scan, then take the write lock like a mutation does
+    const int rounds = 5;
+    double worstCancelMs = 0;
+    for (int i = 0; i < rounds; i++) {
+        vector<TaskRecord> ignored;
+        bool ignoredDone = false;
+        submitSearch(ignored, ignoredDone);
+        this_thread::sleep_for(chrono::milliseconds(2));
+        worstCancelMs = max(worstCancelMs, timeMs([&] {
+            worker.cancel();
+            unique_lock<shared_mutex> lock(engineMutex);
+        }));
+        while (worker.busy()) this_thread::sleep_for(chrono::microseconds(200));
+        check(!worker.poll(), "cancelled query delivered a result");
+    }
+    report("worker_cancel", "cancel_to_write_lock", n, worstCancelMs);
+
+    vector<TaskRecord> replacement = manager.getAllTasks();
+    size_t applied = replacement.size();
+    report("worker_apply", "swap", applied, timeMs([&] { displayed.swap(replacement); }));
+}
+
+// ------------------ Live Search ------------------
+// Types a query one character at a time and times each keystroke's search:
+// a full scan against refining the previous keystroke's matches, plus turning
+// the matches into display ids. Then backspaces through the cached prefixes.
+void benchLiveSearch(const BenchOptions& options) {
+    TaskManager manager;
+    manager.importTasks(makeTasks(options.taskCount));
+    size_t n = options.taskCount;
+
+    const string typed = "task 4217";
+    vector<SearchMatches> cache;
+    for (size_t length = 1; length <= typed.size(); length++) {
+        string query = typed.substr(0, length);
+
+        SearchMatches full;
+        report("live_search_full_scan", query, n, timeMs([&] { full = manager.searchMatches(query); }));
+
+        SearchMatches refined;
+        const SearchMatches* previous = cache.empty() ? nullptr : &cache.back();
+        report("live_search_refine", query, previous ? previous->positions.size() : n, timeMs([&] { refined = manager.searchMatches(query, previous); }));
+        check(refined.positions == full.positions, "refined search " + query);
+
+        vector<int> ids;
+        report("live_search_ids", query, refined.positions.size(), timeMs([&] { ids = manager.idsAt(refined); }));
+        check(ids.size() == manager.searchTasks(query).size(), "search ids " + query);
+        cache.push_back(move(refined));
+    }
+
+    // Backspace: the shorter query is already cached, only its ids are gathered
+    for (size_t i = cache.size(); i-- > 1;) {
+        vector<int> ids;
+        report("live_search_backspace", cache[i - 1].query, cache[i - 1].positions.size(),
+               timeMs([&] { ids = manager.idsAt(cache[i - 1]); }));
+    }
+}
+
+// ------------------ Display List ------------------
+// Cost of bringing a list screen up to date after one mutation: applying the
+// change through DisplayList::update() against reloading the whole list.
+// Each updated list is checked against a fresh load.
+void benchDisplayList(const BenchOptions& options) {
+    TaskManager manager;
+    manager.importTasks(makeTasks(options.taskCount));
+    size_t n = options.taskCount;
+
+    struct View {
+        const char* name;
+        DisplayFilter filter;
+    };
+    vector<View> views(3);
+    views[0].name = "all";
+    views[1].name = "pending";
+    views[1].filter.accepts = [](const TaskRecord& task) { return !task.completed; };
+    views[2].name = "pending_by_priority";
+    views[2].filter.accepts = views[1].filter.accepts;
+    views[2].filter.byPriority = true;
+
+    auto load = [&manager](const DisplayFilter& filter) {
+        return manager.selectIds([&filter](const TaskRecord& task) { return filter.admits(task); }, filter.byPriority);
+    };
+
+    for (View& view : views) {
+        DisplayList list;
+        list.assign(load(view.filter), manager.getGeneration(), view.filter);
+
+        // Pending tasks from the middle, so the list has to shift
+        auto pending = manager.selectIds([](const TaskRecord& task) { return !task.completed; }, false);
+        int completed = pending[pending.size() / 2];
+        int edited = pending[pending.size() / 3];
+
+        manager.markTaskCompleted(completed);
+        report("display_update", string(view.name) + "/complete", n, timeMs([&] { check(list.update(manager), "display update"); }));
+
+        const TaskRecord* task = manager.getRecord(edited);
+        manager.updatePriority(edited, task->priority % 10 + 1);
+        report("display_update", string(view.name) + "/priority", n, timeMs([&] { check(list.update(manager), "display update"); }));
+
+        manager.deleteTask(edited);
+        report("display_update", string(view.name) + "/delete", n, timeMs([&] { check(list.update(manager), "display update"); }));
+
+        manager.undo();
+        report("display_update", string(view.name) + "/undo", n, timeMs([&] { check(list.update(manager), "display update"); }));
+
+        vector<int> fresh;
+        report("display_reload", view.name, n, timeMs([&] { fresh = load(view.filter); }));
+        bool same = fresh.size() == list.size();
+        for (size_t i = 0; same && i < fresh.size(); i++) same = fresh[i] == list.idAt(i);
+        check(same, string("display list ") + view.name);
+    }
+}
+
+// ------------------ Calendar ------------------
+// A year of pending counts per day, read from the engine's deadline index
+// against counting them with a scan of every task, and one day's tasks from
+// the index against a filtered selectIds(). The index is checked against the
+// scan again after an add, a completion and a move to the next day.
+void benchCalendar(const BenchOptions& options) {
+    TaskManager manager;
+    const vector<Task> tasks = makeTasks(options.taskCount);
+    size_t n = tasks.size();
+    report("calendar_import", "with_deadline_index", n, timeMs([&] { manager.importTasks(tasks); }));
+
+    const int year = 2026;
+    const uint32_t first = dayNumberOf(year, 1, 1), last = dayNumberOf(year, 12, 31);
+    auto scanCounts = [&] {
+        vector<uint32_t> counts(last - first + 1, 0);
+        manager.selectIds([&](const TaskRecord& task) {
+            uint32_t day = task.deadlineDay;
+            if (!task.completed && day >= first && day <= last) counts[day - first]++;
+            return false;
+        }, false);
+        return counts;
+    };
+    auto checkCounts = [&](const string& what) {
+        vector<uint32_t> counts;
+        manager.pendingPerDay(first, last, counts);
+        check(counts == scanCounts(), "calendar counts " + what);
+    };
+
+    vector<uint32_t> counts, scanned;
+    report("calendar_year", "index", n, timeMs([&] { manager.pendingPerDay(first, last, counts); }));
+    report("calendar_year", "scan", n, timeMs([&] { scanned = scanCounts(); }));
+    check(counts == scanned, "calendar counts");
+
+    const uint32_t day = dayNumberOf(year, 2, 2);       // makeDeadline(1)
+    vector<int> due, selected;
+    report("calendar_day", "index", n, timeMs([&] { due = manager.tasksDueOn(day); }));
+    report("calendar_day", "scan", n, timeMs([&] {
+        selected = manager.selectIds([day](const TaskRecord& task) { return task.deadlineDay == day; }, false);
+    }));
+    check(due == selected, "calendar day");
+
+    if (due.empty()) {
+        check(false, "calendar day has tasks");
+        return;
+    }
+    int added = manager.addTask("Calendar task", "", "2026-02-02", 5);     // untimed: the first add grows the records
+    checkCounts("after add");
+    report("calendar_mutation", "complete", n, timeMs([&] { manager.markTaskCompleted(due.front()); }));
+    checkCounts("after complete");
+    Task moved;
+    manager.getTask(added, moved);
+    report("calendar_mutation", "move_to_tomorrow", n, timeMs([&] {
+        manager.updateTask(added, moved.title, moved.description, "2026-02-03", moved.priority);
+    }));
+    checkCounts("after move");
+    manager.undo();
+    manager.undo();
+    manager.undo();
+    checkCounts("after undo");
+    check(manager.tasksDueOn(day) == due, "calendar day after undo");
+}
+
+// ------------------ Title Index ------------------
+// Exact-title lookups through the engine's title index against a scan of
+// every record, per lookup. Generated titles repeat, so some lookups return
+// several ids. The index is checked against the scan after a rename, a
+// delete and their undo.
+void benchTitleIndex(const BenchOptions& options) {
+    TaskManager manager;
+    const vector<Task> tasks = makeTasks(options.taskCount);
+    size_t n = tasks.size();
+    report("title_index", "import", n, timeMs([&] { manager.importTasks(tasks); }));
+
+    auto scan = [&manager](const string& title) {
+        return manager.selectIds([&title](const TaskRecord& task) { return task.title == title; }, false);
+    };
+
+    const size_t lookups = 10000, scans = 20;
+    size_t found = 0;
+    double indexMs = timeMs([&] {
+        for (size_t i = 0; i < lookups; i++) found += manager.findByTitle(tasks[i * 7919 % n].title).size();
+    });
+    report("title_lookup", "index_x10000", n, indexMs);
+    double scanMs = timeMs([&] {
+        for (size_t i = 0; i < scans; i++) check(manager.findByTitle(tasks[i].title) == scan(tasks[i].title), "title lookup");
+    });
+    report("title_lookup", "scan_x20", n, scanMs);
+    cout << "{\"bench\":\"title_lookup\",\"index_per_sec\":" << fixed << setprecision(0)
+         << (indexMs > 0 ? lookups / indexMs * 1000 : 0) << ",\"scan_per_sec\":" << (scanMs > 0 ? scans / scanMs * 1000 : 0) << "}" << endl;
+    check(found >= lookups, "title lookups found their tasks");
+
+    const string title = tasks[n / 2].title;
+    const int renamed = manager.findByTitle(title).front();
+    manager.editTask(renamed, "Renamed task", "2026-01-01");
+    check(manager.findByTitle(title) == scan(title) && manager.findByTitle("Renamed task") == vector<int>{renamed}, "title after rename");
+    manager.deleteTask(renamed);
+    check(manager.findByTitle("Renamed task").empty(), "title after delete");
+    manager.undo();
+    manager.undo();
+    check(manager.findByTitle(title) == scan(title) && manager.findByTitle("Renamed task").empty(), "title after undo");
+}
+
+#ifdef __linux__
+// ------------------ Daemon ------------------
+// Load test of the todod protocol: a TaskServer over --tasks tasks on its own
+// thread and 1, 8 or 64 client threads, each with its own connection, sharing
+// DAEMON_REQUESTS commands (nine gets of a random task to one priority
+// change). They are sent one per round trip, as 16 pipelined single-command
+// frames in flight, and as 16-command frames. A command's latency runs from
+// sending its frame to reading the answer.
+struct CountingSink {
+    size_t errors = 0;
+
+    void values(const uint64_t*, size_t) {}
+    void rows(size_t, bool) {}
+    void row(const TaskRecord&, const string*) {}
+    void fail(size_t, const char*) { errors++; }
+};
+
+void benchDaemon(const BenchOptions& options) {
+    const size_t DAEMON_REQUESTS = 100000, DEPTH = 16;
+    struct Mode {
+        const char* name;
+        size_t frameCommands;
+        size_t inFlight;
+    };
+    const Mode modes[] = {{"round_trip", 1, 1}, {"pipelined", 1, DEPTH}, {"batched", DEPTH, 1}};
+
+    TaskManager manager;
+    manager.importTasks(makeTasks(options.taskCount));
+    const int maxId = int(options.taskCount);
+    string path = "/tmp/todo_bench_" + to_string(getpid()) + ".sock";
+    TaskServer server(manager);
+    if (!server.listen(path)) {
+        check(false, "daemon listen on " + path + ": " + strerror(errno));
+        return;
+    }
+    thread serverThread([&server] { server.run(); });
+
+    for (const Mode& mode : modes) {
+        for (size_t clients : {1, 8, 64}) {
+            size_t framesPerClient = DAEMON_REQUESTS / clients / mode.frameCommands;
+            vector<vector<float>> latencies(clients);
+            atomic<size_t> errors{0};
+            double ms = timeMs([&] {
+                vector<thread> threads;
+                for (size_t c = 0; c < clients; c++) {
+                    threads.emplace_back([&, c] {
+                        TaskClient client;
+                        if (!client.connect(path)) {
+                            errors++;
+                            return;
+                        }
+                        mt19937 rng(uint32_t(c + 1));
+                        CountingSink sink;
+                        vector<BatchCommand> frame(mode.frameCommands);
+                        deque<pair<uint32_t, chrono::steady_clock::time_point>> sent;
+                        vector<float>& samples = latencies[c];
+                        samples.reserve(framesPerClient * mode.frameCommands);
+                        for (size_t next = 0, done = 0; done < framesPerClient; done++) {
+                            for (; sent.size() < mode.inFlight && next < framesPerClient; next++) {
+                                for (BatchCommand& command : frame) {
+                                    command.id = 1 + int(rng() % maxId);
+                                    command.op = rng() % 10 == 0 ? BatchOp::PRIO : BatchOp::GET;
+                                    command.number = 1 + int(rng() % 10);
+                                }
+                                sent.emplace_back(client.send(frame.data(), frame.size()), chrono::steady_clock::now());
+                            }
+                            if (client.receive(sink) != sent.front().first) {
+                                errors++;
+                                return;
+                            }
+                            float us = chrono::duration<float, micro>(chrono::steady_clock::now() - sent.front().second).count();
+                            samples.insert(samples.end(), mode.frameCommands, us);
+                            sent.pop_front();
+                        }
+                        errors += sink.errors;
+                    });
+                }
+                for (thread& t : threads) t.join();
+            });
+
+            vector<float> all;
+            for (const vector<float>& samples : latencies) all.insert(all.end(), samples.begin(), samples.end());
+            sort(all.begin(), all.end());
+            auto percentile = [&all](double p) { return all.empty() ? 0.0f : all[min(all.size() - 1, size_t(p * all.size()))]; };
+            cout << "{\"bench\":\"daemon\",\"variant\":\"" << mode.name << "\",\"task_count\":" << options.taskCount
+                 << ",\"clients\":" << clients << ",\"requests\":" << all.size()
+                 << ",\"req_per_sec\":" << fixed << setprecision(0) << (ms > 0 ? all.size() / ms * 1000 : 0)
+                 << setprecision(1) << ",\"p50_us\":" << percentile(0.5) << ",\"p99_us\":" << percentile(0.99)
+                 << ",\"p999_us\":" << percentile(0.999) << ",\"max_us\":" << (all.empty() ? 0.0f : all.back()) << "}" << endl;
+            check(errors == 0, string("daemon ") + mode.name + " requests");
+        }
+    }
+
+    server.stop();
+    serverThread.join();
+}
+
+// ------------------ Shared Snapshot ------------------
+// Reads per second from the shared-memory snapshot with 1, 2, 4 and 8 reader
+// processes, each alternating a counts read and a fifteen-row page at a
+// random position for SNAPSHOT_SECONDS. Meanwhile this process plays a busy
+// daemon: it deletes and restores a random task every millisecond,
+// republishing the counts on every change and the table every 100 ms.
+// Deleting shifts the text of every later row, so a reader that mixed two
+// tables would pair ids with the wrong titles; readers check the number in
+// every row's title against the generated task for its id.
+struct ReaderResult {
+    uint64_t reads = 0;
+    uint64_t retries = 0;
+    uint64_t bad = 0;
+};
+
+ReaderResult readSnapshot(const string& name, size_t taskCount, double seconds, uint32_t seed) {
+    ReaderResult result;
+    SnapshotReader reader;
+    if (!reader.open(name)) {
+        result.bad++;
+        return result;
+    }
+    mt19937 rng(seed);
+    SnapshotCounts counts;
+    vector<TaskRecord> rows;
+    auto end = chrono::steady_clock::now() + chrono::duration<double>(seconds);
+    while (chrono::steady_clock::now() < end) {
+        for (int i = 0; i < 64; i++) {
+            reader.readCounts(counts);
+            if (counts.pending + counts.completed != counts.tasks) result.bad++;
+            reader.readTasks(rng() % taskCount, 15, rows, &counts);
+            if (counts.pending + counts.completed != counts.tasks) result.bad++;
+            for (const TaskRecord& task : rows) {
+                int n = int(size_t(task.id - 1) * 2654435761u % 1000003), titled = -1;
+                if (task.title.size() > 5) from_chars(task.title.data() + 5, task.title.data() + task.title.size(), titled);
+                if (titled != n || task.deadlineDay != deadlineDayNumber(makeDeadline(n))) result.bad++;
+            }
+            result.reads += 2;
+        }
+    }
+    result.retries = reader.getRetries();
+    return result;
+}
+
+void benchSnapshot(const BenchOptions& options) {
+    const double SNAPSHOT_SECONDS = 1.0;
+    const auto PUBLISH_INTERVAL = chrono::milliseconds(100);
+
+    TaskManager manager;
+    manager.importTasks(makeTasks(options.taskCount));
+    string name = "/todo_bench_" + to_string(getpid());
+    SnapshotWriter writer;
+    if (!writer.create(name, 256u << 20)) {
+        check(false, "snapshot create " + name + ": " + strerror(errno));
+        return;
+    }
+    writer.publishCounts(manager);
+    report("snapshot_publish", "tasks", options.taskCount, timeMs([&] { writer.publishTasks(manager); }));
+    report("snapshot_publish", "counts", options.taskCount, timeMs([&] { writer.publishCounts(manager); }));
+
+    for (int processes : {1, 2, 4, 8}) {
+        vector<pid_t> children;
+        vector<int> pipes;
+        for (int p = 0; p < processes; p++) {
+            int fds[2];
+            if (pipe(fds) != 0) break;
+            pid_t pid = fork();
+            if (pid == 0) {
+                ::close(fds[0]);
+                ReaderResult result = readSnapshot(name, options.taskCount, SNAPSHOT_SECONDS, uint32_t(p + 1));
+                ssize_t written = write(fds[1], &result, sizeof(result));
+                _exit(written == ssize_t(sizeof(result)) ? 0 : 1);
+            }
+            ::close(fds[1]);
+            children.push_back(pid);
+            pipes.push_back(fds[0]);
+        }
+
+        // The writer side, for as long as the readers run
+        mt19937 rng(7);
+        size_t publishes = 0;
+        auto nextPublish = chrono::steady_clock::now() + PUBLISH_INTERVAL;
+        auto end = chrono::steady_clock::now() + chrono::duration<double>(SNAPSHOT_SECONDS);
+        while (chrono::steady_clock::now() < end) {
+            manager.deleteTask(1 + int(rng() % options.taskCount));
+            writer.publishCounts(manager);
+            manager.undo();
+            writer.publishCounts(manager);
+            if (chrono::steady_clock::now() >= nextPublish) {
+                writer.publishTasks(manager);
+                publishes++;
+                nextPublish = chrono::steady_clock::now() + PUBLISH_INTERVAL;
+            }
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+
+        ReaderResult total;
+        for (size_t p = 0; p < children.size(); p++) {
+            ReaderResult result;
+            bool ok = read(pipes[p], &result, sizeof(result)) == ssize_t(sizeof(result));
+            ::close(pipes[p]);
+            int status = 0;
+            waitpid(children[p], &status, 0);
+            check(ok && WIFEXITED(status) && WEXITSTATUS(status) == 0, "snapshot reader exited");
+            total.reads += result.reads;
+            total.retries += result.retries;
+            total.bad += result.bad;
+        }
+        cout << "{\"bench\":\"snapshot\",\"task_count\":" << options.taskCount << ",\"processes\":" << processes
+             << ",\"reads_per_sec\":" << fixed << setprecision(0) << total.reads / SNAPSHOT_SECONDS
+             << ",\"retries\":" << total.retries << ",\"table_publishes\":" << publishes << "}" << endl;
+        check(int(children.size()) == processes && total.bad == 0, "snapshot reads consistent");
+    }
+}
+
+// ------------------ Replication ------------------
+// Acknowledged writes per second and their latency from 1 and 8 clients, on
+// a primary todod alone and with a follower attached (which holds every
+// answer until the follower has the change), plus the follower's lag. Then a
+// follower attaching late, which starts from a state transfer: it must have
+// every earlier write, and undoing on the primary must change both alike.
+// Then a failover: 8 clients write until the primary is killed with SIGKILL,
+// the follower is promoted, and every write the primary acknowledged must be
+// on it. The primary runs in a child process so it can die outright; the
+// follower runs on a thread here.
+struct WriteLog {
+    vector<pair<int, string>> added;    // acknowledged adds: id, title
+    vector<int> completed;              // acknowledged completions
+    vector<float> latencies;
+    bool lostConnection = false;
+};
+
+// Keeps 16 single-command frames in flight until `end` or until the
+// connection drops: adds titled "r<client>-<n>", every fourth one a
+// completion of the client's latest acknowledged add
+void writeLoad(const string& path, size_t client, chrono::steady_clock::time_point end, WriteLog& log) {
+    const size_t DEPTH = 16;
+    struct Sent {
+        uint32_t tag;
+        chrono::steady_clock::time_point at;
+        BatchCommand command;
+    };
+    TaskClient connection;
+    if (!connection.connect(path)) {
+        log.lostConnection = true;
+        return;
+    }
+    deque<Sent> sent;
+    ResultCollector results;
+    for (size_t next = 0;; ) {
+        for (; sent.size() < DEPTH && chrono::steady_clock::now() < end; next++) {
+            BatchCommand command;
+            if (next % 4 == 3 && !log.added.empty()) {
+                command.op = BatchOp::COMPLETE;
+                command.id = log.added.back().first;
+            }
+            else {
+                command.op = BatchOp::ADD;
+                command.number = 1 + int(next % 10);
+                command.deadline = makeDeadline(int(next));
+                command.text = "r" + to_string(client) + "-" + to_string(next);
+            }
+            uint32_t tag = connection.send(command);
+            if (tag == 0) {
+                log.lostConnection = true;
+                return;
+            }
+            sent.push_back({tag, chrono::steady_clock::now(), move(command)});
+        }
+        if (sent.empty()) return;
+        results.results.clear();
+        if (connection.receive(results) != sent.front().tag) {
+            log.lostConnection = true;
+            return;
+        }
+        const Sent& answered = sent.front();
+        if (!results.results[0].failed) {
+            if (answered.command.op == BatchOp::ADD) log.added.emplace_back(int(results.results[0].values[0]), answered.command.text);
+            else log.completed.push_back(answered.command.id);
+        }
+        log.latencies.push_back(chrono::duration<float, micro>(chrono::steady_clock::now() - answered.at).count());
+        sent.pop_front();
+    }
+}
+
+// Acknowledged writes in `logs` that the daemon at `path` does not have
+size_t lostWrites(const string& path, const vector<WriteLog>& logs) {
+    TaskClient connection;
+    BatchCommand exportAll;
+    exportAll.op = BatchOp::EXPORT;
+    ResultCollector results;
+    if (!connection.connect(path) || !connection.call(&exportAll, 1, results)) return SIZE_MAX;
+    unordered_map<int, const Task*> byId;
+    for (const Task& task : results.results[0].rows) byId[task.id] = &task;
+    size_t lost = 0;
+    for (const WriteLog& log : logs) {
+        for (const auto& added : log.added) {
+            auto it = byId.find(added.first);
+            if (it == byId.end() || it->second->title != added.second) lost++;
+        }
+        for (int id : log.completed) {
+            auto it = byId.find(id);
+            if (it == byId.end() || !it->second->completed) lost++;
+        }
+    }
+    return lost;
+}
+
+// Whether the daemons at `a` and `b` hold the same tasks in the same order
+bool sameTasks(const string& a, const string& b) {
+    BatchCommand exportAll;
+    exportAll.op = BatchOp::EXPORT;
+    ResultCollector results[2];
+    TaskClient connections[2];
+    if (!connections[0].connect(a) || !connections[0].call(&exportAll, 1, results[0]) ||
+        !connections[1].connect(b) || !connections[1].call(&exportAll, 1, results[1])) return false;
+    const vector<Task>& x = results[0].results[0].rows;
+    const vector<Task>& y = results[1].results[0].rows;
+    if (x.size() != y.size()) return false;
+    for (size_t i = 0; i < x.size(); i++) {
+        if (x[i].id != y[i].id || x[i].title != y[i].title || x[i].description != y[i].description ||
+            x[i].deadline != y[i].deadline || x[i].priority != y[i].priority || x[i].completed != y[i].completed) return false;
+    }
+    return true;
+}
+
+// A primary in a child process, once it accepts connections; -1 on failure
+pid_t startPrimary(const string& path) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        TaskManager manager;
+        TaskServer server(manager);
+        if (!server.listen(path)) _exit(1);
+        server.run();
+        _exit(0);
+    }
+    TaskClient probe;
+    for (int i = 0; i < 200 && !probe.connect(path); i++) this_thread::sleep_for(chrono::milliseconds(10));
+    if (probe.isConnected()) return pid;
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+    return -1;
+}
+
+void stopPrimary(pid_t pid, const string& path, int signal) {
+    kill(pid, signal);
+    waitpid(pid, nullptr, 0);
+    unlink(path.c_str());
+}
+
+// Starts `standby` following the primary and waits until a write to the
+// primary shows up on it
+bool attachFollower(TaskServer& standby, thread& runner, const string& primaryPath, const string& followerPath) {
+    if (!standby.listen(followerPath) || !standby.follow(primaryPath)) return false;
+    runner = thread([&standby] { standby.run(); });
+    TaskClient primary, follower;
+    BatchCommand add, count;
+    add.op = BatchOp::ADD;
+    add.number = 1;
+    add.deadline = makeDeadline(0);
+    add.text = "attach";
+    count.op = BatchOp::COUNT;
+    ResultCollector results;
+    if (!primary.connect(primaryPath) || !follower.connect(followerPath) || !primary.call(&add, 1, results)) return false;
+    for (int i = 0; i < 200; i++) {
+        results.results.clear();
+        if (!follower.call(&count, 1, results)) return false;
+        if (results.results[0].values[0] > 0) return true;
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    return false;
+}
+
+void benchReplication(const BenchOptions&) {
+    const double LOAD_SECONDS = 1.0;
+    const auto KILL_AFTER = chrono::milliseconds(300);
+    string base = "/tmp/todo_bench_" + to_string(getpid());
+    string primaryPath = base + "_primary.sock", followerPath = base + "_follower.sock";
+
+    auto runLoad = [](const string& path, vector<WriteLog>& logs, chrono::steady_clock::time_point end) {
+        vector<thread> threads;
+        for (size_t c = 0; c < logs.size(); c++) {
+            threads.emplace_back([&, c] { writeLoad(path, c, end, logs[c]); });
+        }
+        for (thread& t : threads) t.join();
+    };
+    auto ackedWrites = [](const vector<WriteLog>& logs) {
+        size_t total = 0;
+        for (const WriteLog& log : logs) total += log.added.size() + log.completed.size();
+        return total;
+    };
+
+    for (bool withFollower : {false, true}) {
+        for (size_t clients : {1, 8}) {
+            pid_t primary = startPrimary(primaryPath);
+            if (primary < 0) {
+                check(false, "replication primary on " + primaryPath);
+                return;
+            }
+            TaskManager standbyManager;
+            TaskServer standby(standbyManager);
+            thread standbyThread;
+            if (withFollower && !attachFollower(standby, standbyThread, primaryPath, followerPath)) {
+                check(false, "replication follower on " + followerPath);
+                stopPrimary(primary, primaryPath, SIGTERM);
+                if (standbyThread.joinable()) {
+                    standby.stop();
+                    standbyThread.join();
+                }
+                return;
+            }
+
+            vector<WriteLog> logs(clients);
+            double ms = timeMs([&] {
+                runLoad(primaryPath, logs, chrono::steady_clock::now() +
+                        chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(LOAD_SECONDS)));
+            });
+            vector<float> all;
+            bool connected = true;
+            for (const WriteLog& log : logs) {
+                all.insert(all.end(), log.latencies.begin(), log.latencies.end());
+                connected = connected && !log.lostConnection;
+            }
+            sort(all.begin(), all.end());
+            auto percentile = [&all](double p) { return all.empty() ? 0.0f : all[min(all.size() - 1, size_t(p * all.size()))]; };
+            check(connected, "replication clients stayed connected");
+
+            cout << "{\"bench\":\"replication\",\"variant\":\"" << (withFollower ? "with_follower" : "primary_only")
+                 << "\",\"clients\":" << clients << ",\"writes\":" << ackedWrites(logs)
+                 << ",\"writes_per_sec\":" << fixed << setprecision(0) << (ms > 0 ? ackedWrites(logs) / ms * 1000 : 0)
+                 << setprecision(1) << ",\"p50_us\":" << percentile(0.5) << ",\"p99_us\":" << percentile(0.99);
+            if (withFollower) {
+                size_t lost = lostWrites(followerPath, logs);
+                standby.stop();
+                standbyThread.join();
+                const TaskServer::Stats& stats = standby.getStats();
+                cout << ",\"lag_mean_us\":" << (stats.lagSamples ? double(stats.lagTotalUs) / stats.lagSamples : 0.0)
+                     << ",\"lag_max_us\":" << stats.lagMaxUs << ",\"lost_writes\":" << lost;
+                check(lost == 0, "replication follower has every acknowledged write");
+            }
+            cout << "}" << endl;
+            stopPrimary(primary, primaryPath, SIGTERM);
+        }
+    }
+
+    // Late follower
+    {
+        pid_t primary = startPrimary(primaryPath);
+        if (primary < 0) {
+            check(false, "replication primary on " + primaryPath);
+            return;
+        }
+        vector<WriteLog> logs(8);
+        runLoad(primaryPath, logs, chrono::steady_clock::now() + KILL_AFTER);
+        TaskManager standbyManager;
+        TaskServer standby(standbyManager);
+        thread standbyThread;
+        bool attached = false;
+        double attachMs = timeMs([&] { attached = attachFollower(standby, standbyThread, primaryPath, followerPath); });
+        size_t lost = attached ? lostWrites(followerPath, logs) : SIZE_MAX;
+
+        // Answered once the follower has the undos too
+        BatchCommand undos[3];
+        for (BatchCommand& undo : undos) undo.op = BatchOp::UNDO;
+        TaskClient client;
+        ResultCollector results;
+        bool same = attached && client.connect(primaryPath) && client.call(undos, 3, results) &&
+                    sameTasks(primaryPath, followerPath);
+        if (standbyThread.joinable()) {
+            standby.stop();
+            standbyThread.join();
+        }
+        stopPrimary(primary, primaryPath, SIGTERM);
+
+        cout << "{\"bench\":\"replication\",\"variant\":\"late_follower\",\"writes_before\":" << ackedWrites(logs)
+             << ",\"state_transfers\":" << standby.getStats().stateTransfers
+             << ",\"attach_ms\":" << fixed << setprecision(1) << attachMs << ",\"lost_writes\":" << lost << "}" << endl;
+        check(attached && standby.getStats().stateTransfers == 1, "replication late follower attached by state transfer");
+        check(lost == 0, "replication late follower has every earlier write");
+        check(same, "replication undo after a state transfer matches on the follower");
+    }
+
+    // Failover
+    pid_t primary = startPrimary(primaryPath);
+    TaskManager standbyManager;
+    TaskServer standby(standbyManager);
+    thread standbyThread;
+    if (primary < 0 || !attachFollower(standby, standbyThread, primaryPath, followerPath)) {
+        check(false, "replication failover setup");
+        if (primary >= 0) stopPrimary(primary, primaryPath, SIGTERM);
+        if (standbyThread.joinable()) {
+            standby.stop();
+            standbyThread.join();
+        }
+        return;
+    }
+    vector<WriteLog> logs(8);
+    thread load([&] { runLoad(primaryPath, logs, chrono::steady_clock::now() + chrono::seconds(10)); });
+    this_thread::sleep_for(KILL_AFTER);
+    stopPrimary(primary, primaryPath, SIGKILL);
+    auto killed = chrono::steady_clock::now();
+    load.join();
+
+    // Promoted once it takes a write
+    standby.promote();
+    TaskClient promoted;
+    BatchCommand add;
+    add.op = BatchOp::ADD;
+    add.number = 1;
+    add.deadline = makeDeadline(0);
+    add.text = "after failover";
+    bool writable = promoted.connect(followerPath);
+    for (int i = 0; writable && i < 2000; i++) {
+        ResultCollector results;
+        writable = promoted.call(&add, 1, results);
+        if (writable && !results.results[0].failed) break;
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    double promoteMs = chrono::duration<double, milli>(chrono::steady_clock::now() - killed).count();
+    size_t lost = lostWrites(followerPath, logs);
+    bool allCut = true;
+    for (const WriteLog& log : logs) allCut = allCut && log.lostConnection;
+    standby.stop();
+    standbyThread.join();
+
+    cout << "{\"bench\":\"replication\",\"variant\":\"failover\",\"clients\":" << logs.size()
+         << ",\"acked_writes\":" << ackedWrites(logs) << ",\"lost_writes\":" << lost
+         << ",\"records_replayed\":" << standby.getStats().recordsApplied
+         << ",\"promote_ms\":" << fixed << setprecision(1) << promoteMs << "}" << endl;
+    check(allCut, "replication primary killed mid-workload");
+    check(writable && !standby.isReadOnly(), "replication follower promoted");
+    check(lost == 0, "replication failover kept every acknowledged write");
+}
+#endif
+
+// ------------------ Batch Scripts ------------------
+// Commands per second through BatchRunner: --tasks adds, then as many
+// commands again mixing completes, priority changes, moves to tomorrow, gets
+// and counts. Output goes to a stream that discards it, so this is parsing
+// plus the engine; the script is built up front.
+struct DiscardBuffer : streambuf {
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+void benchBatch(const BenchOptions& options) {
+    size_t n = options.taskCount;
+    vector<string> lines;
+    lines.reserve(2 * n);
+    for (size_t i = 0; i < n; i++) {
+        int k = int(i * 2654435761u % 1000003);
+        lines.push_back("add " + to_string(1 + k % 10) + " " + makeDeadline(k) + " " + makeTitle(k) + " | " + makeDescription(k));
+    }
+    for (size_t i = 0; i < n; i++) {
+        int id = int(1 + i * 2654435761u % n);
+        switch (i % 5) {
+            case 0: lines.push_back("complete " + to_string(id)); break;
+            case 1: lines.push_back("prio " + to_string(id) + " " + to_string(1 + i % 10)); break;
+            case 2: lines.push_back("tomorrow " + to_string(id)); break;
+            case 3: lines.push_back("get " + to_string(id)); break;
+            default: lines.push_back("count"); break;
+        }
+    }
+
+    TaskManager manager;
+    DiscardBuffer discard;
+    ostream out(&discard);
+    BatchRunner runner(manager, out);
+    double addMs = timeMs([&] {
+        for (size_t i = 0; i < n; i++) runner.feed(lines[i], i + 1);
+        runner.finish();
+    });
+    double mixedMs = timeMs([&] {
+        for (size_t i = n; i < lines.size(); i++) runner.feed(lines[i], i + 1);
+        runner.finish();
+    });
+    report("batch_script", "add", n, addMs);
+    report("batch_script", "mixed", n, mixedMs);
+    cout << "{\"bench\":\"batch_script\",\"commands_per_sec\":" << fixed << setprecision(0)
+         << (addMs + mixedMs > 0 ? lines.size() / (addMs + mixedMs) * 1000 : 0) << "}" << endl;
+    check(runner.getStats().errors == 0 && manager.getTaskCount() == n, "batch script");
+}
+
+// ------------------ Archive ------------------
+// A completed list much larger than RAM would hold as TaskRecords: written to
+// a TaskArchive in batches, then read back the way a list view does, fifteen
+// rows at a time. A jump reads the viewport's pages on the spot; scrolling
+// with read-ahead should find them cached. Resident memory is sampled before
+// and after reading, and should grow by about the cache cap, not by the
+// archive size. The OS file cache is warm, since the file was just written.
+size_t residentBytes() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmRSS:") == 0) return strtoul(line.c_str() + 6, nullptr, 10) * 1024;
+    }
+    return 0;
+}
+
+void benchArchive(const BenchOptions& options) {
+    const string path = "task_manager_bench.archive";
+    const size_t viewportRows = 15;
+    const size_t cacheBytes = 32 << 20;
+    size_t n = options.archiveRows;
+
+    double writeMs = 0;
+    {
+        TaskArchive archive;
+        if (!archive.open(path, cacheBytes)) {
+            cerr << "cannot create " << path << endl;
+            failed = true;
+            return;
+        }
+        vector<ArchivedTask> batch;
+        for (size_t first = 0; first < n; first += 1000000) {
+            batch.clear();
+            for (size_t i = first; i < min(n, first + 1000000); i++) {
+                ArchivedTask task;
+                task.record.id = int(i + 1);
+                task.record.title = makeTitle(int(i));
+                task.record.deadlineDay = deadlineDayNumber(makeDeadline(int(i)));
+                task.record.priority = 1 + int(i % 10);
+                task.record.completed = true;
+                task.description = makeDescription(int(i));
+                batch.push_back(move(task));
+            }
+            writeMs += timeMs([&] { check(archive.append(batch), "archive append"); });
+        }
+    }
+    report("archive_write", "append", n, writeMs);
+
+    size_t rssBefore = residentBytes();      // after writing, whose batches the allocator keeps
+    TaskArchive archive;
+    double openMs = timeMs([&] { check(archive.open(path, cacheBytes), "archive reopen"); });
+    report("archive_open", "index", n, openMs);
+    check(archive.size() == n, "archive row count");
+
+    // The rows a view shows at `top`, holding their pages like a frame does
+    auto viewport = [&](size_t top) {
+        vector<shared_ptr<const ArchivePage>> pinned;
+        for (size_t row = top; row < min(n, top + viewportRows); row++) {
+            if (pinned.empty() || TaskArchive::slotOf(row) == 0) pinned.push_back(archive.pageOf(row));
+            const ArchivedTask& task = pinned.back()->rows[TaskArchive::slotOf(row)];
+            if (task.record.id != int(row + 1)) check(false, "archive row " + to_string(row));
+        }
+    };
+
+    mt19937_64 random(42);
+    vector<double> jumpMs;
+    for (int i = 0; i < 200; i++) {
+        size_t top = random() % n;
+        jumpMs.push_back(timeMs([&] { viewport(top); }));
+    }
+    report("archive_jump", "p50", n, percentile(jumpMs, 50));
+    report("archive_jump", "p99", n, percentile(jumpMs, 99));
+
+    // Two rows a frame, read-ahead of four pages each way after every frame
+    vector<double> scrollMs;
+    size_t top = random() % (n / 2);
+    for (int frame = 0; frame < 5000; frame++, top += 2) {
+        scrollMs.push_back(timeMs([&] { viewport(top); }));
+        archive.readAhead(top, top + viewportRows, 4);
+        this_thread::sleep_for(chrono::microseconds(200));      // the rest of the frame
+    }
+    report("archive_scroll", "p50", n, percentile(scrollMs, 50));
+    report("archive_scroll", "p99", n, percentile(scrollMs, 99));
+    report("archive_scroll", "max", n, percentile(scrollMs, 100));
+
+    size_t rssAfter = residentBytes();
+    cout << "{\"bench\":\"archive_memory\",\"task_count\":" << n
+         << ",\"cache_cap_bytes\":" << cacheBytes
+         << ",\"cached_bytes\":" << archive.cacheBytes()
+         << ",\"index_bytes\":" << archive.indexBytes()
+         << ",\"rss_growth_bytes\":" << (rssAfter > rssBefore ? rssAfter - rssBefore : 0)
+         << "}" << endl;
+    remove(path.c_str());
+    remove((path + ".idx").c_str());
+}
+
+// ------------------ Main ------------------
+int main(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--tasks") == 0 && i + 1 < argc) {
+            options.taskCount = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.maxThreads = strtoul(argv[++i], nullptr, 10);
+        }
+        else if (strcmp(argv[i], "--max-bytes-per-task") == 0 && i + 1 < argc) {
+            options.maxBytesPerTask = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--archive-rows") == 0 && i + 1 < argc) {
+            options.archiveRows = strtoul(argv[++i], nullptr, 10);
+        }
+        else {
+            options.section = argv[i];
+        }
+    }
+
+    auto wants = [&options](const string& name) {
+        return options.section.empty() || options.section == name;
+    };
+
+    if (wants("memory")) benchMemory(options);
+    if (wants("sort")) benchSort(options);
+    if (wants("parallel")) benchParallel(options);
+    if (wants("working_set")) benchWorkingSet(options);
+    if (wants("worker")) benchWorker(options);
+    if (wants("live_search")) benchLiveSearch(options);
+    if (wants("display_list")) benchDisplayList(options);
+    if (wants("calendar")) benchCalendar(options);
+    if (wants("title_index")) benchTitleIndex(options);
+    if (wants("batch")) benchBatch(options);
+#ifdef __linux__
+    if (wants("daemon")) benchDaemon(options);
+    if (wants("snapshot")) benchSnapshot(options);
+    if (wants("replication")) benchReplication(options);
+#endif
+    if (wants("archive")) benchArchive(options);
+
+    return failed ? 1 : 0;
+}
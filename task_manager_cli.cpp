@@ -1,595 +1,436 @@
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <string>
-#include <ctime>
-#include <iomanip>
-#include <sstream>
+#include <vector>
+#include "task_manager.hpp"
+#include "batch_script.hpp"
+#include "task_client.hpp"
+#ifdef TODO_DAEMON_CLIENT
+#include "task_snapshot.hpp"
+#endif
 using namespace std;
 
-const int MAX_SIZE = 100;
-
-// Forward declarations
-class Stack;  // Tell compiler that Stack class will be defined later
-
-// ------------------ Simple Date Class ------------------
-class Date {
-public:
-    int year;
-    int month;
-    int day;
-
-    // Constructor
-    Date(string dateString) {
-        // Convert "YYYY-MM-DD" to numbers
-        sscanf(dateString.c_str(), "%d-%d-%d", &year, &month, &day);
-    }
-
-    // Convert date to string (YYYY-MM-DD format)
-    string toString() {
-        char buffer[11];  // Space for YYYY-MM-DD + null terminator
-        sprintf(buffer, "%04d-%02d-%02d", year, month, day);
-        return string(buffer);
-    }
-
-    // Add days to date
-    void addDays(int days) {
-        day += days;
-
-        if (day > 30) {
-            month++;
-            day -= 30;
-        }
-
-        if (month > 12) {
-            year++;
-            month = 1;
-        }
-    }
-
-    // Compare dates
-    bool isLessThan(Date other) {
-        if (year != other.year) {
-            return year < other.year;        //Returns true if the current date is earlier than other
-        }
-
-        if (month != other.month) {
-            return month < other.month;
-        }
+// ------------------ Output ------------------
+// stdout is block-buffered (see main) and lines end in '\n' rather than endl,
+// so a listing goes out in large writes instead of one syscall per line.
+// Each command flushes once, when it is done; reading input flushes the
+// prompt, since cin stays tied to cout.
+static char outputBuffer[1 << 16];
+
+void printTask(const TaskManager& manager, const TaskRecord& task) {
+    cout << "ID: " << task.id << '\n'
+         << "Title: " << task.title << '\n'
+         << "Description: " << manager.getDescription(task) << '\n'
+         << "Priority: " << task.priority << '\n'
+         << "Deadline: " << task.deadline() << '\n'
+         << "Status: " << (task.completed ? "Completed" : "Pending") << '\n'
+         << "------------------------\n";
+}
 
-        return day < other.day;
+// ------------------ Views ------------------
+// Views stream the records straight from the engine; nothing is copied.
+void printAll(const TaskManager& manager) {
+    if (manager.getTaskCount() == 0) {
+        cout << "No tasks found.\n";
+        return;
     }
-};
 
-// ------------------ Task ------------------
-class Task {
-public:
-    int id;
-    string title;
-    string description;
-    int priority;
-    string deadline;
-    bool completed;
-
-    Task(int i = 0, string t = "", string d = "", int p = 5, string dl = "", bool c = false) {
-        id = i;
-        title = t;
-        description = d;
-        priority = p;
-        deadline = dl;
-        completed = c;
+    cout << "\n=== All Tasks ===\n";
+    for (const TaskRecord& task : manager) {
+        printTask(manager, task);
     }
+}
 
-    void display() {
-        cout << "ID: " << id << endl;
-        cout << "Title: " << title << endl;
-        cout << "Description: " << description << endl;
-        cout << "Priority: " << priority << endl;
-        cout << "Deadline: " << deadline << endl;
-        cout << "Status: " << (completed ? "Completed" : "Pending") << endl;
-        cout << "------------------------" << endl;
+void viewPendingTasks(const TaskManager& manager) {
+    cout << "\n=== Pending Tasks ===\n";
+    for (const TaskRecord& task : manager) {
+        if (!task.completed) printTask(manager, task);
     }
-};
+}
 
-// ------------------ Node ------------------
-class Node {
-public:
-    Task task;
-    Node* next;
-    Node* prev;
-
-    Node(Task t) {
-        task = t;
-        next = nullptr;
-        prev = nullptr;
+void viewCompletedTasks(const TaskManager& manager) {
+    cout << "\n=== Completed Tasks ===\n";
+    for (const TaskRecord& task : manager) {
+        if (task.completed) printTask(manager, task);
     }
-};
-
-// ------------------ UndoAction ------------------
-class UndoAction {
-public:
-    string type;
-    Task before;
-    Task after;
-};
+}
 
-// ------------------ Stack ------------------
-class Stack {
-private:
-    UndoAction stack[MAX_SIZE];
-    int top;
+// Title lookups go through the engine's title index. Several tasks can share
+// a title: searches show all of them, in display order, and commands that
+// take a title act on the first.
+const TaskRecord* findByTitle(const TaskManager& manager, const string& title) {
+    vector<int> ids = manager.findByTitle(title);
+    return ids.empty() ? nullptr : manager.getRecord(ids.front());
+}
 
-public:
-    Stack() {
-        top = -1;
+void searchByTitle(const TaskManager& manager, const string& title) {
+    vector<int> ids = manager.findByTitle(title);
+    if (ids.empty()) {
+        cout << "Task not found.\n";
+        return;
     }
-
-    int isFull() {
-        return top == MAX_SIZE - 1;
+    for (int id : ids) {
+        printTask(manager, *manager.getRecord(id));
     }
+}
 
-    int isEmpty() {
-        return top == -1;
-    }
+void searchByDeadline(const TaskManager& manager, const string& date) {
+    bool found = false;
 
-    void push(UndoAction value) {
-        if (isFull()) {
-            cout << "Stack overflow" << endl;
-        }
-        else {
-            top++;
-            stack[top] = value;
+    cout << "\n=== Tasks Due on " << date << " ===\n";
+    uint32_t day = deadlineDayNumber(date);
+    for (const TaskRecord& task : manager) {
+        if (day != NO_DEADLINE_KEY && task.deadlineDay == day) {
+            printTask(manager, task);
+            found = true;
         }
     }
 
-    UndoAction pop() {
-        if (isEmpty()) {
-            cout << "Stack underflow" << endl;
-            return UndoAction();
-        }
-        else {
-            return stack[top--];
-        }
+    if (!found) {
+        cout << "No tasks found for this date.\n";
     }
-};
-
-// ------------------ Global Variables ------------------
-Stack undoActions;
-Stack redoActions;
-
-// ------------------ MinHeap ------------------
-class MinHeap {
-private:
-    Task heap[MAX_SIZE];
-    int size;
+}
 
-    int parent(int i) {
-        return (i - 1) / 2;
-    }
+// Pending tasks by priority, ties in record order
+vector<int> pendingByPriority(const TaskManager& manager) {
+    return manager.selectIds([](const TaskRecord& task) { return !task.completed; }, true);
+}
 
-    int left(int i) {
-        return 2 * i + 1;
-    }
+void viewTopNPriorityTasks(const TaskManager& manager, int n) {
+    vector<int> ids = pendingByPriority(manager);
 
-    int right(int i) {
-        return 2 * i + 2;
+    cout << "\n=== Top " << n << " Priority Tasks ===\n";
+    for (size_t i = 0; i < ids.size() && int(i) < n; i++) {
+        printTask(manager, *manager.getRecord(ids[i]));
     }
+}
 
-    void shiftUp(int i) {        //new element inserted at the bottom
-        while (i > 0 && heap[parent(i)].priority > heap[i].priority) {
-            swap(heap[i], heap[parent(i)]);
-            i = parent(i);
-        }
+void showPriorityQueue(const TaskManager& manager) {
+    cout << "\n=== Priority Queue ===\n";
+    for (int id : pendingByPriority(manager)) {
+        const TaskRecord* task = manager.getRecord(id);
+        cout << "- " << task->title << " (Priority: " << task->priority << ")\n";
     }
+}
 
-    void shiftDown(int i) {        //After deleting the root
-        int smallest = i;
-        int l = left(i);
-        int r = right(i);
+void printMemoryReport(const TaskManager& manager) {
+    cout << "\n=== Memory Report ===\n";
+    manager.memoryReport().print(cout);
+}
 
-        if (l < size && heap[l].priority < heap[smallest].priority) {
-            smallest = l;
-        }
+// ------------------ Commands ------------------
+void addTask(TaskManager& manager) {
+    string title, description, deadline;
+    int priority;
 
-        if (r < size && heap[r].priority < heap[smallest].priority) {
-            smallest = r;
-        }
+    cin.ignore();
+    cout << "Enter task title: ";
+    getline(cin, title);
 
-        if (smallest != i) {
-            swap(heap[i], heap[smallest]);
-            shiftDown(smallest);
-        }
-    }
+    cout << "Enter task description: ";
+    getline(cin, description);
 
-public:
-    MinHeap() {
-        size = 0;
-    }
+    cout << "Enter deadline (YYYY-MM-DD): ";
+    getline(cin, deadline);
 
-    void insert(Task task) {
-        if (size >= MAX_SIZE) {
-            cout << "Heap is full!" << endl;
-            return;
-        }
-        heap[size] = task;
-        shiftUp(size);
-        size++;
-    }
-
-    Task extractMin() {
-        if (size == 0) {
-            cout << "Heap is empty!" << endl;
-            return Task();
-        }
+    cout << "Enter priority (1-10): ";
+    cin >> priority;
 
-        Task root = heap[0];
-        heap[0] = heap[size - 1];
-        size--;
-        shiftDown(0);
-        return root;
+    if (!Date::isValid(deadline)) {
+        cout << "Error: Deadline must be YYYY-MM-DD\n";
+        return;
     }
-
-    bool empty() {
-        return size == 0;
+    try {
+        manager.addTask(title, description, deadline, priority);
     }
-
-    void display() {
-        MinHeap tempHeap = *this;  //Create a copy of current heap
-        while (!tempHeap.empty()) {
-            Task task = tempHeap.extractMin();
-            cout << "- " << task.title << " (Priority: " << task.priority << ")" << endl;
-        }
+    catch (const invalid_argument& e) {
+        cout << "Error: " << e.what() << '\n';
     }
+}
 
-    void updatePriority(string title, int newPriority) {
-        int taskIndex = -1;
-        for (int i = 0; i < size; i++) {
-            if (heap[i].title == title) {
-                taskIndex = i;
-                break;
-            }
-        }
-
-        if (taskIndex != -1) {
-            int oldPriority = heap[taskIndex].priority;
-            heap[taskIndex].priority = newPriority;
-
-            // If new priority is less than old priority, shift up
-            if (newPriority < oldPriority) {                //Decrease priority (higher importance)
-                shiftUp(taskIndex);
-            }
-            // If new priority is more than old priority, shift down
-            else if (newPriority > oldPriority) {            //Increase priority (lower importance)
-                shiftDown(taskIndex);
-            }
-        }
+void markCompleted(TaskManager& manager, int id) {
+    if (manager.getRecord(id) == nullptr) {
+        cout << "Task not found!\n";
+        return;
     }
-};
+    manager.markTaskCompleted(id);
+    cout << "Task marked as completed!\n";
+}
 
-// ------------------ TaskList ------------------
-class TaskList {
-private:
-    Node* head;
-    Node* tail;
-    int nextId;
-
-public:
-    TaskList() {
-        head = nullptr;
-        tail = nullptr;
-        nextId = 1;
+void editTask(TaskManager& manager, int id, const string& newTitle, const string& newDeadline) {
+    if (manager.getRecord(id) == nullptr) {
+        cout << "Task not found.\n";
+        return;
     }
-
-    void addTask(MinHeap& heap) {
-        string title, description, deadline;
-        int priority;
-
-        cin.ignore();
-        cout << "Enter task title: ";
-        getline(cin, title);
-
-        cout << "Enter task description: ";
-        getline(cin, description);
-
-        cout << "Enter deadline (YYYY-MM-DD): ";
-        getline(cin, deadline);
-
-        cout << "Enter priority (1-10): ";
-        cin >> priority;
-
-        Task newTask(nextId, title, description, priority, deadline);
-        insert(newTask);
-        heap.insert(newTask);
-
-        UndoAction action;
-        action.type = "add";
-        action.after = newTask;        //Save the task that was just added so we can undo it later
-        undoActions.push(action);      //Push this action to the undo stack... most recent action on top
-
-        nextId++;
+    if (!Date::isValid(newDeadline)) {
+        cout << "Deadline must be YYYY-MM-DD.\n";
+        return;
     }
+    manager.editTask(id, newTitle, newDeadline);
+    cout << "Task updated successfully!\n";
+}
 
-    void insert(Task task) {
-        Node* newNode = new Node(task);
-
-        if (head == nullptr) {
-            head = newNode;
-            tail = newNode;
-        }
-        else {
-            tail->next = newNode;
-            newNode->prev = tail;
-            tail = newNode;
-        }
+void updatePriority(TaskManager& manager, const string& title, int newPriority) {
+    const TaskRecord* task = findByTitle(manager, title);
+    if (task == nullptr) {
+        cout << "Task not found.\n";
+        return;
     }
-
-    void removeById(int id) {
-        Node* current = head;
-
-        while (current != nullptr) {
-            if (current->task.id == id) {
-                if (current->prev != nullptr) {
-                    current->prev->next = current->next;
-                }
-                else {
-                    head = current->next;
-                }
-
-                if (current->next != nullptr) {
-                    current->next->prev = current->prev;
-                }
-                else {
-                    tail = current->prev;
-                }
-
-                delete current;
-                return;
-            }
-            current = current->next;
-        }
+    if (newPriority < 1 || newPriority > 10) {
+        cout << "Priority must be between 1 and 10.\n";
+        return;
     }
+    manager.updatePriority(task->id, newPriority);
+}
 
-    void markCompleted(int id) {
-        Node* current = head;
-
-        while (current != nullptr) {
-            if (current->task.id == id) {
-                current->task.completed = true;
-                cout << "Task marked as completed!" << endl;
-                return;
-            }
-            current = current->next;
-        }
-
-        cout << "Task not found!" << endl;
+void moveTaskToTomorrow(TaskManager& manager, const string& title) {
+    const TaskRecord* task = findByTitle(manager, title);
+    if (task == nullptr) {
+        cout << "Task not found.\n";
+        return;
     }
 
-    void viewCompletedTasks() {
-        Node* current = head;
-        cout << "\n=== Completed Tasks ===" << endl;
-
-        while (current != nullptr) {
-            if (current->task.completed) {
-                current->task.display();
-            }
-            current = current->next;
-        }
+    string deadline = task->deadline();
+    if (!Date::isValid(deadline)) {
+        cout << "Task has no valid deadline.\n";
+        return;
     }
-
-    void viewPendingTasks() {
-        Node* current = head;
-        cout << "\n=== Pending Tasks ===" << endl;
-
-        while (current != nullptr) {
-            if (!current->task.completed) {
-                current->task.display();
-            }
-            current = current->next;
-        }
+    Date date(deadline);
+    date.addDays(1);
+    if (!Date::isValid(date.toString())) {
+        cout << "Deadline out of range.\n";
+        return;
     }
+    manager.editTask(task->id, task->title, date.toString());
+    cout << "Task moved to tomorrow successfully!\n";
+}
 
-    void searchByTitle(string title) {
-        Node* current = head;
-
-        while (current != nullptr) {
-            if (current->task.title == title) {
-                current->task.display();
-                return;
-            }
-            current = current->next;
-        }
-
-        cout << "Task not found." << endl;
+void performUndo(TaskManager& manager) {
+    if (!manager.canUndo()) {
+        cout << "Nothing to undo.\n";
+        return;
     }
+    manager.undo();
+}
 
-    void editTask(int id, string newTitle, string newDeadline) {
-        Node* current = head;
-
-        while (current != nullptr) {
-            if (current->task.id == id) {
-                Task before = current->task;
-                current->task.title = newTitle;
-                current->task.deadline = newDeadline;
-                UndoAction action = {"edit", before, current->task};
-                undoActions.push(action);
-                cout << "Task updated successfully!" << endl;
-                return;
-            }
-            current = current->next;
-        }
-
-        cout << "Task not found." << endl;
+void performRedo(TaskManager& manager) {
+    if (!manager.canRedo()) {
+        cout << "Nothing to redo.\n";
+        return;
     }
+    manager.redo();
+}
 
-    void sortByDeadline() {
-        for (Node* i = head; i != nullptr; i = i->next) {
-            Node* minNode = i;
-
-            for (Node* j = i->next; j != nullptr; j = j->next) {
-                Date date1(j->task.deadline);
-                Date date2(minNode->task.deadline);
-
-                if (date1.isLessThan(date2)) {
-                    minNode = j;
-                }
-            }
-
-            if (minNode != i) {
-                swap(i->task, minNode->task);
-            }
-        }
-
-        cout << "Tasks sorted by deadline!" << endl;
-    }
+// ------------------ Batch Mode ------------------
+// `task_manager_cli --batch [FILE] [--stats]` runs a command script (see
+// batch_script.hpp) from FILE, or stdin when FILE is missing or "-", with no
+// prompts; results go to stdout, one line per command. --stats writes a JSON
+// summary line to stderr, so a large script doubles as a load test.
+bool openScript(const string& path, ifstream& file) {
+    if (path.empty() || path == "-") return true;
+    file.open(path);
+    if (!file) cerr << "Cannot open " << path << '\n';
+    return bool(file);
+}
 
-    void printAll() {
-        Node* current = head;
+void printBatchStats(const BatchStats& stats, double ms) {
+    cerr << "{\"commands\":" << stats.commands << ",\"errors\":" << stats.errors
+         << ",\"ms\":" << fixed << setprecision(2) << ms
+         << ",\"commands_per_sec\":" << setprecision(0) << (ms > 0 ? stats.commands / ms * 1000 : 0) << "}\n";
+}
 
-        if (current == nullptr) {
-            cout << "No tasks found." << endl;
-            return;
-        }
+int runBatch(const string& path, bool printStats) {
+    ifstream file;
+    if (!openScript(path, file)) return 2;
+    istream& in = file.is_open() ? file : cin;
+    cin.tie(nullptr);       // no prompts to flush before reads
+
+    TaskManager manager;
+    BatchRunner runner(manager, cout);
+    auto start = chrono::steady_clock::now();
+    runner.run(in);
+    cout.flush();
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    if (printStats) printBatchStats(runner.getStats(), ms);
+    return runner.getStats().errors == 0 ? 0 : 1;
+}
 
-        cout << "\n=== All Tasks ===" << endl;
+#ifdef TODO_DAEMON_CLIENT
+// ------------------ Client Mode ------------------
+// `task_manager_cli --connect [SOCKET] [--batch [FILE]] [--stats]` runs the
+// script against a running todod instead of a private engine, with the same
+// output as a local run. Commands go out in frames of FRAME_COMMANDS, up to
+// WINDOW frames ahead of the answers. Typed at a terminal, each line is sent
+// on its own and answered before the next prompt.
+struct ScriptSink : TextSink {
+    size_t errors = 0;
 
-        while (current != nullptr) {
-            current->task.display();
-            current = current->next;
-        }
-    }
+    using TextSink::TextSink;
 
-    Node* getHead() {
-        return head;
+    void fail(size_t line, const char* message) {
+        errors++;
+        TextSink::fail(line, message);
     }
 };
 
-// ------------------ Features ------------------
-void performUndo(TaskList& list, MinHeap& heap) {
-    if (undoActions.isEmpty()) {
-        cout << "Nothing to undo." << endl;
-        return;
-    }
-
-    UndoAction action = undoActions.pop();
+struct PendingFrame {
+    uint32_t tag;
+    vector<size_t> lines;                       // script line of each command
+    vector<pair<size_t, string>> errorsAfter;   // parse errors to print after its answers
+};
 
-    if (action.type == "add") {
-        list.removeById(action.after.id);
-        // Remove from heap
-        heap = MinHeap(); // Reset heap
-        Node* current = list.getHead();
-        while (current != nullptr) {
-            if (!current->task.completed) {        //Rebuild the heap by inserting all uncompleted tasks from the updated task list
-                heap.insert(current->task);
-            }
-            current = current->next;
+int runRemote(const string& socketPath, const string& path, bool printStats) {
+    const size_t FRAME_COMMANDS = 64, WINDOW = 16;
+
+    ifstream file;
+    if (!openScript(path, file)) return 2;
+    istream& in = file.is_open() ? file : cin;
+    bool interactive = !file.is_open() && isatty(STDIN_FILENO);
+    size_t frameCommands = interactive ? 1 : FRAME_COMMANDS;
+    size_t window = interactive ? 1 : WINDOW;
+    if (!interactive) cin.tie(nullptr);
+
+    TaskClient client;
+    if (!client.connect(socketPath)) {
+        cerr << "Cannot connect to " << socketPath << ": " << strerror(errno) << '\n';
+        return 2;
+    }
+
+    ScriptSink sink(cout);
+    BatchStats stats;
+    deque<PendingFrame> inFlight;
+    vector<BatchCommand> frame;
+    vector<size_t> frameLines;
+    bool broken = false;
+
+    auto receiveOne = [&] {
+        PendingFrame& pending = inFlight.front();
+        auto lineOf = [&pending](size_t index) { return index < pending.lines.size() ? pending.lines[index] : 0; };
+        if (client.receive(sink, lineOf) != pending.tag) {
+            broken = true;
+            return;
         }
-    }
-    else {
-        list.editTask(action.after.id, action.before.title, action.before.deadline);
-        // Update heap
-        heap = MinHeap(); // Reset heap
-        Node* current = list.getHead();
-        while (current != nullptr) {
-            if (!current->task.completed) {
-                heap.insert(current->task);
+        for (const auto& error : pending.errorsAfter) sink.fail(error.first, error.second.c_str());
+        inFlight.pop_front();
+    };
+    auto sendFrame = [&] {
+        if (frame.empty() || broken) return;
+        while (inFlight.size() >= window && !broken) receiveOne();
+        uint32_t tag = client.send(frame.data(), frame.size());
+        if (tag == 0) broken = true;
+        inFlight.push_back({tag, move(frameLines), {}});
+        frame.clear();
+        frameLines.clear();
+    };
+
+    auto start = chrono::steady_clock::now();
+    string line;
+    size_t lineNumber = 0;
+    if (interactive) cout << "> " << flush;
+    while (!broken && getline(in, line)) {
+        lineNumber++;
+        string_view body = batch_detail::trim(line);
+        if (!body.empty() && body.front() != '#') {
+            stats.commands++;
+            BatchCommand command;
+            string error;
+            if (parseBatchLine(body, command, error)) {
+                frame.push_back(move(command));
+                frameLines.push_back(lineNumber);
+                if (frame.size() >= frameCommands) sendFrame();
             }
-            current = current->next;
-        }
-    }
-
-    redoActions.push(action);
-}
-
-void performRedo(TaskList& list, MinHeap& heap) {
-    if (redoActions.isEmpty()) {
-        cout << "Nothing to redo." << endl;
-        return;
-    }
-
-    UndoAction action = redoActions.pop();
-
-    if (action.type == "add") {
-        list.insert(action.after);
-        if (!action.after.completed) {
-            heap.insert(action.after);
-        }
-    }
-    else {
-        list.editTask(action.before.id, action.after.title, action.after.deadline);
-        // Update heap
-        heap = MinHeap(); // Reset heap
-        Node* current = list.getHead();
-        while (current != nullptr) {
-            if (!current->task.completed) {
-                heap.insert(current->task);
+            else {
+                // Sent first, so the error prints after the answers before it
+                sendFrame();
+                if (inFlight.empty()) sink.fail(lineNumber, error.c_str());
+                else inFlight.back().errorsAfter.emplace_back(lineNumber, error);
             }
-            current = current->next;
         }
-    }
-
-    undoActions.push(action);
-}
-
-void viewTopNPriorityTasks(TaskList& list, int N) {
-    MinHeap temp;
-    Node* current = list.getHead();
-
-    while (current != nullptr) {
-        if (!current->task.completed) {
-            temp.insert(current->task);
+        if (interactive) {
+            while (!inFlight.empty() && !broken) receiveOne();
+            cout << "> " << flush;
         }
-        current = current->next;
-    }
-
-    cout << "\n=== Top " << N << " Priority Tasks ===" << endl;
-
-    for (int i = 0; i < N && !temp.empty(); i++) {
-        temp.extractMin().display();
     }
-}
+    sendFrame();
+    while (!inFlight.empty() && !broken) receiveOne();
+    cout.flush();
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
 
-void moveTaskToTomorrow(TaskList& list, string title) {
-    Node* current = list.getHead();
-
-    while (current != nullptr) {
-        if (current->task.title == title) {
-            Date date(current->task.deadline);
-            date.addDays(1);
-            current->task.deadline = date.toString();
-            cout << "Task moved to tomorrow successfully!" << endl;
-            return;
-        }
-        current = current->next;
+    if (broken) {
+        cerr << "Lost the connection to " << socketPath << '\n';
+        return 2;
     }
-
-    cout << "Task not found." << endl;
+    stats.errors = sink.errors;
+    if (printStats) printBatchStats(stats, ms);
+    return stats.errors == 0 ? 0 : 1;
 }
 
-void searchByDeadline(TaskList& list, string date) {
-    Node* current = list.getHead();
-    bool found = false;
-
-    cout << "\n=== Tasks Due on " << date << " ===" << endl;
-
-    while (current != nullptr) {
-        if (current->task.deadline == date) {
-            current->task.display();
-            found = true;
-        }
-        current = current->next;
-    }
-
-    if (!found) {
-        cout << "No tasks found for this date." << endl;
-    }
+// `task_manager_cli --status [NAME] [--rows N]` prints the counts from a
+// running todod's shared-memory snapshot, plus the first N tasks of its last
+// published table, without contacting the daemon. Meant for status bars and
+// other frequent pollers.
+int printStatus(const string& name, size_t rowCount) {
+    SnapshotReader reader;
+    if (!reader.open(name)) {
+        cerr << "Cannot open snapshot " << name << ": " << strerror(errno) << '\n';
+        return 2;
+    }
+    SnapshotCounts counts;
+    reader.readCounts(counts);
+    cout << counts.tasks << " tasks, " << counts.pending << " pending, " << counts.completed
+         << " completed (generation " << counts.generation << ")\n";
+
+    vector<TaskRecord> rows;
+    if (rowCount > 0 && reader.readTasks(0, rowCount, rows, &counts)) {
+        TextSink sink(cout);
+        sink.rows(rows.size(), false);
+        for (const TaskRecord& task : rows) sink.row(task, nullptr);
+    }
+    cout.flush();
+    return 0;
 }
+#endif
 
 // ------------------ Main ------------------
-int main() {
-    // Initialize the undo/redo stacks
-    undoActions = Stack();
-    redoActions = Stack();
-
-    TaskList list;
-    MinHeap heap;
+int main(int argc, char** argv) {
+    // Must happen before any I/O for the buffer to take effect
+    ios::sync_with_stdio(false);
+    cout.rdbuf()->pubsetbuf(outputBuffer, sizeof(outputBuffer));
+
+    bool batch = false, printStats = false, connect = false, status = false;
+    string scriptPath, socketPath, snapshotName;
+    size_t statusRows = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--batch") == 0) batch = true;
+        else if (strcmp(argv[i], "--stats") == 0) printStats = true;
+        else if (strcmp(argv[i], "--connect") == 0) {
+            connect = true;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) socketPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--status") == 0) {
+            status = true;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) snapshotName = argv[++i];
+        }
+        else if (strcmp(argv[i], "--rows") == 0 && i + 1 < argc) statusRows = strtoul(argv[++i], nullptr, 10);
+        else if (batch && scriptPath.empty()) scriptPath = argv[i];
+    }
+#ifdef TODO_DAEMON_CLIENT
+    if (status) return printStatus(snapshotName.empty() ? defaultSnapshotName() : snapshotName, statusRows);
+    if (connect) return runRemote(socketPath.empty() ? defaultSocketPath() : socketPath, scriptPath, printStats);
+#else
+    if (connect || status) {
+        cerr << "--connect and --status need a running todod, which this platform lacks\n";
+        return 2;
+    }
+#endif
+    if (batch) return runBatch(scriptPath, printStats);
+
+    TaskManager manager;
     int choice;
 
     // Declare all variables needed in switch cases here
@@ -597,67 +438,72 @@ int main() {
     string searchTitle, searchDate, newTitle, newDeadline, taskTitle, moveTitle;
 
     do {
-        cout << "\n====== TASK MANAGER ======" << endl;
-        cout << "1. Add Task" << endl;
-        cout << "2. View All Tasks" << endl;
-        cout << "3. View Pending Tasks" << endl;
-        cout << "4. View Completed Tasks" << endl;
-        cout << "5. Mark Task as Completed" << endl;
-        cout << "6. Search by Title" << endl;
-        cout << "7. Search by Deadline" << endl;
-        cout << "8. Sort by Deadline" << endl;
-        cout << "9. Edit Task" << endl;
-        cout << "10. Undo" << endl;
-        cout << "11. Redo" << endl;
-        cout << "12. View Top N Priority Tasks" << endl;
-        cout << "13. Update Priority" << endl;
-        cout << "14. Move Task to Tomorrow" << endl;
-        cout << "15. Show Priority Queue" << endl;
-        cout << "16. Exit" << endl;
-        cout << "Enter your choice: ";
-
-        cin >> choice;
+        cout << "\n====== TASK MANAGER ======\n"
+             << "1. Add Task\n"
+             << "2. View All Tasks\n"
+             << "3. View Pending Tasks\n"
+             << "4. View Completed Tasks\n"
+             << "5. Mark Task as Completed\n"
+             << "6. Search by Title\n"
+             << "7. Search by Deadline\n"
+             << "8. Sort by Deadline\n"
+             << "9. Edit Task\n"
+             << "10. Undo\n"
+             << "11. Redo\n"
+             << "12. View Top N Priority Tasks\n"
+             << "13. Update Priority\n"
+             << "14. Move Task to Tomorrow\n"
+             << "15. Show Priority Queue\n"
+             << "16. Memory Report\n"
+             << "17. Exit\n"
+             << "Enter your choice: ";
+
+        if (!(cin >> choice)) {
+            if (cin.eof()) break;
+            choice = 0;
+        }
 
         switch (choice) {
 
             case 1:
-                list.addTask(heap);
+                addTask(manager);
                 break;
 
             case 2:
-                list.printAll();
+                printAll(manager);
                 break;
 
             case 3:
-                list.viewPendingTasks();
+                viewPendingTasks(manager);
                 break;
 
             case 4:
-                list.viewCompletedTasks();
+                viewCompletedTasks(manager);
                 break;
 
             case 5:
                 cout << "Enter task ID to mark as completed: ";
                 cin >> id;
-                list.markCompleted(id);
+                markCompleted(manager, id);
                 break;
 
             case 6:
                 cout << "Enter title to search: ";
                 cin.ignore();
                 getline(cin, searchTitle);
-                list.searchByTitle(searchTitle);
+                searchByTitle(manager, searchTitle);
                 break;
 
             case 7:
                 cout << "Enter deadline (YYYY-MM-DD): ";
                 cin.ignore();
                 getline(cin, searchDate);
-                searchByDeadline(list, searchDate);
+                searchByDeadline(manager, searchDate);
                 break;
 
             case 8:
-                list.sortByDeadline();
+                manager.sortByDeadline();
+                cout << "Tasks sorted by deadline!\n";
                 break;
 
             case 9:
@@ -668,21 +514,21 @@ int main() {
                 getline(cin, newTitle);
                 cout << "Enter new deadline (YYYY-MM-DD): ";
                 getline(cin, newDeadline);
-                list.editTask(editId, newTitle, newDeadline);
+                editTask(manager, editId, newTitle, newDeadline);
                 break;
 
             case 10:
-                performUndo(list, heap);
+                performUndo(manager);
                 break;
 
             case 11:
-                performRedo(list, heap);
+                performRedo(manager);
                 break;
 
             case 12:
                 cout << "Enter number of tasks to view: ";
                 cin >> n;
-                viewTopNPriorityTasks(list, n);
+                viewTopNPriorityTasks(manager, n);
                 break;
 
             case 13:
@@ -691,52 +537,38 @@ int main() {
                 getline(cin, taskTitle);
                 cout << "Enter new priority (1-10): ";
                 cin >> newPriority;
-                // Update priority in both TaskList and MinHeap
-                {
-                    Node* current = list.getHead();
-                    while (current != nullptr) {
-                        if (current->task.title == taskTitle) {
-                            current->task.priority = newPriority;
-                            break;
-                        }
-                        current = current->next;
-                    }
-                    heap = MinHeap(); // Reset heap
-                    current = list.getHead();
-                    while (current != nullptr) {
-                        if (!current->task.completed) {
-                            heap.insert(current->task);
-                        }
-                        current = current->next;
-                    }
-                }
+                updatePriority(manager, taskTitle, newPriority);
                 break;
 
             case 14:
                 cout << "Enter task title to move: ";
                 cin.ignore();
                 getline(cin, moveTitle);
-                moveTaskToTomorrow(list, moveTitle);
+                moveTaskToTomorrow(manager, moveTitle);
                 break;
 
             case 15:
-                cout << "\n=== Priority Queue ===" << endl;
-                heap.display();
+                showPriorityQueue(manager);
+                break;
+
+            case 16:
+                printMemoryReport(manager);
                 break;
 
-			case 16:
-                cout << "Thank you for using Task Manager!" << endl;
+            case 17:
+                cout << "Thank you for using Task Manager!\n";
                 break;
 
             default:
                 cin.clear();  // Clear error state
-	            cin.ignore(1000, '\n');  // Discard invalid input
-	            cout << "Invalid choice! Please try again." << endl;
-	            continue;
+                cin.ignore(1000, '\n');  // Discard invalid input
+                cout << "Invalid choice! Please try again.\n";
+                break;
         }
 
-    } while (choice != 16);
+        cout.flush();       // the one flush per command
+    } while (choice != 17);
 
+    cout.flush();
     return 0;
 }
-
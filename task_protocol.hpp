@@ -0,0 +1,270 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "batch_script.hpp"
+
+// ------------------ Daemon Protocol ------------------
+// Binary request/response framing for todod, the daemon that hosts one
+// TaskManager behind a Unix socket. A request frame carries one or more batch
+// commands (batch_script.hpp); the daemon runs them in order with the same
+// batching as a script and answers with one response frame holding one
+// result per command. Frames may be pipelined: a client can send any number
+// before reading, and responses come back in request order, echoing the tag.
+//
+//   frame    = u32 size (of what follows) | u32 tag | varint count | items
+//   command  = u8 op | the op's fields, in order: id, number (zigzag
+//              varints), deadline, text, description (varint length + bytes)
+//   result   = u8 VALUES | varint n | n varints
+//            | u8 ROWS | u8 withDescriptions | varint n | n rows
+//            | u8 ERROR | varint index of the command in its frame | message
+//   row      = id, priority (zigzag) | u8 completed | varint deadline day
+//              (task_sort.hpp) | title [| description]
+//
+// Integers are little-endian. Both ends run on one machine, so there is no
+// version negotiation; op codes are the BatchOp values.
+
+namespace wire {
+
+const uint32_t MAX_FRAME_SIZE = 64u << 20;      // largest request
+const uint32_t MAX_RESPONSE_SIZE = 1u << 30;    // largest response a client buffers, an EXPORT of millions of tasks
+const size_t HEADER_SIZE = 8;
+
+enum ResultKind : uint8_t { VALUES = 0, ROWS = 1, ERROR = 2 };
+
+enum Field : uint8_t {
+    FIELD_ID = 1, FIELD_NUMBER = 2, FIELD_DEADLINE = 4, FIELD_TEXT = 8, FIELD_DESCRIPTION = 16
+};
+
+// Which BatchCommand fields an op carries on the wire
+inline uint8_t fieldsOf(BatchOp op) {
+    switch (op) {
+        case BatchOp::ADD: return FIELD_NUMBER | FIELD_DEADLINE | FIELD_TEXT | FIELD_DESCRIPTION;
+        case BatchOp::UPDATE: return FIELD_ID | FIELD_NUMBER | FIELD_DEADLINE | FIELD_TEXT | FIELD_DESCRIPTION;
+        case BatchOp::EDIT: return FIELD_ID | FIELD_DEADLINE | FIELD_TEXT;
+        case BatchOp::PRIO: return FIELD_ID | FIELD_NUMBER;
+        case BatchOp::COMPLETE:
+        case BatchOp::DELETE:
+        case BatchOp::TOMORROW:
+        case BatchOp::GET: return FIELD_ID;
+        case BatchOp::TOP: return FIELD_NUMBER;
+        case BatchOp::FIND:
+        case BatchOp::SEARCH:
+        case BatchOp::DUE:
+        case BatchOp::LIST: return FIELD_TEXT;
+        default: return 0;
+    }
+}
+
+// ------------------ Encoding ------------------
+typedef std::vector<char> Buffer;
+
+inline void putU32(Buffer& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out.push_back(char(value >> (8 * i)));
+}
+
+inline void patchU32(Buffer& out, size_t at, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[at + i] = char(value >> (8 * i));
+}
+
+inline uint32_t getU32(const char* p) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) value |= uint32_t(uint8_t(p[i])) << (8 * i);
+    return value;
+}
+
+inline void putVarint(Buffer& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(char(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(char(value));
+}
+
+inline void putSigned(Buffer& out, int64_t value) {
+    putVarint(out, (uint64_t(value) << 1) ^ uint64_t(value >> 63));
+}
+
+inline void putString(Buffer& out, std::string_view text) {
+    putVarint(out, text.size());
+    out.insert(out.end(), text.begin(), text.end());
+}
+
+// Reserves the header of a frame starting at out.size(); finishFrame() fills in the size
+inline size_t beginFrame(Buffer& out, uint32_t tag, size_t count) {
+    size_t start = out.size();
+    putU32(out, 0);
+    putU32(out, tag);
+    putVarint(out, count);
+    return start;
+}
+
+inline void finishFrame(Buffer& out, size_t start) {
+    patchU32(out, start, uint32_t(out.size() - start - 4));
+}
+
+inline void putCommand(Buffer& out, const BatchCommand& command) {
+    uint8_t fields = fieldsOf(command.op);
+    out.push_back(char(command.op));
+    if (fields & FIELD_ID) putSigned(out, command.id);
+    if (fields & FIELD_NUMBER) putSigned(out, command.number);
+    if (fields & FIELD_DEADLINE) putString(out, command.deadline);
+    if (fields & FIELD_TEXT) putString(out, command.text);
+    if (fields & FIELD_DESCRIPTION) putString(out, command.description);
+}
+
+// ------------------ Decoding ------------------
+// Reads from one complete frame body. A read past the end, or a malformed
+// value, clears `ok` and returns zeroes from then on.
+struct Reader {
+    const char* p;
+    const char* end;
+    bool ok = true;
+
+    Reader(const char* begin, const char* _end) : p(begin), end(_end) {}
+
+    uint8_t byte() {
+        if (p == end) {
+            ok = false;
+            return 0;
+        }
+        return uint8_t(*p++);
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = byte();
+            value |= uint64_t(b & 0x7f) << shift;
+            if (!(b & 0x80)) return ok ? value : 0;
+        }
+        ok = false;
+        return 0;
+    }
+
+    int64_t signedVarint() {
+        uint64_t value = varint();
+        return int64_t(value >> 1) ^ -int64_t(value & 1);
+    }
+
+    std::string_view string() {
+        uint64_t size = varint();
+        if (size > uint64_t(end - p)) {
+            ok = false;
+            return {};
+        }
+        std::string_view text(p, size);
+        p += size;
+        return text;
+    }
+
+    bool atEnd() const {
+        return p == end;
+    }
+};
+
+inline bool readCommand(Reader& in, BatchCommand& command) {
+    uint8_t op = in.byte();
+    if (op > uint8_t(BatchOp::INFO)) return false;
+    command.op = BatchOp(op);
+    uint8_t fields = fieldsOf(command.op);
+    if (fields & FIELD_ID) command.id = int(in.signedVarint());
+    if (fields & FIELD_NUMBER) command.number = int(in.signedVarint());
+    if (fields & FIELD_DEADLINE) command.deadline = std::string(in.string());
+    if (fields & FIELD_TEXT) command.text = std::string(in.string());
+    if (fields & FIELD_DESCRIPTION) command.description = std::string(in.string());
+    return in.ok;
+}
+
+// Size of the first complete frame in [data, data + size), including its
+// header; 0 if it has not fully arrived yet
+inline size_t completeFrame(const char* data, size_t size) {
+    if (size < 4) return 0;
+    size_t frame = 4 + size_t(getU32(data));
+    return size >= frame ? frame : 0;
+}
+
+// ------------------ Results ------------------
+// A CommandRunner sink that appends results to a response frame
+class FrameSink {
+private:
+    Buffer& out;
+
+public:
+    explicit FrameSink(Buffer& _out) : out(_out) {}
+
+    void values(const uint64_t* values, size_t count) {
+        out.push_back(char(VALUES));
+        putVarint(out, count);
+        for (size_t i = 0; i < count; i++) putVarint(out, values[i]);
+    }
+
+    void rows(size_t count, bool withDescriptions) {
+        out.push_back(char(ROWS));
+        out.push_back(char(withDescriptions));
+        putVarint(out, count);
+    }
+
+    void row(const TaskRecord& task, const std::string* description) {
+        putSigned(out, task.id);
+        putSigned(out, task.priority);
+        out.push_back(char(task.completed));
+        putVarint(out, task.deadlineDay);
+        putString(out, task.title);
+        if (description != nullptr) putString(out, *description);
+    }
+
+    void fail(size_t line, const char* message) {
+        out.push_back(char(ERROR));
+        putVarint(out, line);
+        putString(out, message);
+    }
+};
+
+// Replays one encoded result into a sink, the inverse of FrameSink. Error
+// lines are command indexes within the frame; lineOf maps them back.
+template <class Sink, class LineOf>
+bool readResult(Reader& in, Sink& sink, LineOf lineOf) {
+    switch (in.byte()) {
+        case VALUES: {
+            uint64_t values[4];
+            uint64_t count = in.varint();
+            if (count > 4) return false;
+            for (uint64_t i = 0; i < count; i++) values[i] = in.varint();
+            if (!in.ok) return false;
+            sink.values(values, count);
+            return true;
+        }
+        case ROWS: {
+            bool withDescriptions = in.byte() != 0;
+            uint64_t count = in.varint();
+            if (!in.ok || count > uint64_t(in.end - in.p)) return false;
+            sink.rows(count, withDescriptions);
+            TaskRecord task;
+            std::string description;
+            for (uint64_t i = 0; i < count; i++) {
+                task.id = int(in.signedVarint());
+                task.priority = int(in.signedVarint());
+                task.completed = in.byte() != 0;
+                task.deadlineDay = uint32_t(in.varint());
+                task.title.assign(in.string());
+                if (withDescriptions) description.assign(in.string());
+                if (!in.ok) return false;
+                sink.row(task, withDescriptions ? &description : nullptr);
+            }
+            return true;
+        }
+        case ERROR: {
+            uint64_t index = in.varint();
+            std::string message(in.string());
+            if (!in.ok) return false;
+            sink.fail(lineOf(index), message.c_str());
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+} // namespace wire
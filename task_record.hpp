@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "cold_store.hpp"
+#include "task_sort.hpp"
+
+// ------------------ TaskRecord ------------------
+// Hot part of a stored task: everything list views, sorting and the indexes
+// touch. The description lives in the TaskManager's ColdStore and is only
+// read when a full Task is requested (or a row actually shows it).
+struct TaskRecord {
+    std::string title;
+    uint32_t deadlineDay = NO_DEADLINE_KEY;     // deadlineDayNumber() of "YYYY-MM-DD"
+    int id = 0;
+    ColdRef descriptionRef = NO_COLD_REF;
+    uint32_t version = 0;               // changes whenever any field of this task changes
+    int priority = 1;
+    bool completed = false;
+
+    // "YYYY-MM-DD", or empty without a deadline
+    std::string deadline() const {
+        return dayNumberToString(deadlineDay);
+    }
+};
@@ -0,0 +1,200 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <vector>
+#include "task_protocol.hpp"
+
+// ------------------ Replication ------------------
+// Log shipping from a todod primary to hot-standby followers. While at least
+// one follower is attached, the primary appends every batch of mutations it
+// applies (see CommandRunner::Observer) to a replication log as one record;
+// with none, it only counts them. A follower connects to the primary's socket
+// like any client but sends a frame with tag 0, which TaskClient never uses,
+// saying how many records it already holds. From then on that connection
+// carries the log instead of requests:
+//
+//   follow, ack = u32 size | u32 tag 0 | varint records held
+//   log         = u32 size | u32 tag 0 | varint first record | varint count
+//                 | varint sent at (steady clock, ns) | count records
+//   record      = varint n | n commands, encoded as in a request frame
+//   state       = u32 size | u32 tag 1 | varint records it stands for
+//                 | varint generation | varint next id | varint n | n tasks
+//                 | varint n | n undo steps | varint n | n redo steps
+//   task        = id, priority (zigzag) | u8 completed | deadline | title
+//                 | description
+//   step        = type | task before | task after
+//
+// The engine is deterministic, so replaying the records in order through a
+// CommandRunner rebuilds the same tasks, ids, generations and undo history;
+// commands that failed on the primary fail again. A follower that holds
+// nothing, or fewer records than the log still keeps, first gets a state
+// frame: the primary's tasks, ids and undo history as of now, followed by the
+// records from there on. The log drops records once every attached follower
+// has acked them, so it holds about what the slowest follower lags behind.
+
+namespace replication {
+
+const uint32_t TAG = 0;
+const uint32_t STATE_TAG = 1;           // only ever sent to a follower
+const size_t SHIP_BYTES = 1u << 20;     // records per log frame, at least one
+
+// Steady clock in ns; the same clock in every process on the machine
+inline uint64_t nowNs() {
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// A follow or ack frame
+inline void putPosition(wire::Buffer& out, uint64_t records) {
+    size_t start = wire::beginFrame(out, TAG, records);
+    wire::finishFrame(out, start);
+}
+
+// ------------------ Log ------------------
+// Records are numbered from the start of the primary; the log holds those
+// from first() to size()
+class Log {
+private:
+    wire::Buffer bytes;                 // the records held, back to back
+    std::vector<size_t> offsets;        // where each starts in bytes
+    uint64_t base = 0;                  // number of the first one held
+
+public:
+    void append(const std::vector<BatchCommand>& batch) {
+        offsets.push_back(bytes.size());
+        wire::putVarint(bytes, batch.size());
+        for (const BatchCommand& command : batch) wire::putCommand(bytes, command);
+    }
+
+    // Drops every record held and numbers the next one `next`
+    void reset(uint64_t next) {
+        bytes.clear();
+        offsets.clear();
+        base = next;
+    }
+
+    // Drops the records before `position`
+    void trim(uint64_t position) {
+        if (position <= base) return;
+        size_t count = std::min(size_t(position - base), offsets.size());
+        size_t cut = count < offsets.size() ? offsets[count] : bytes.size();
+        bytes.erase(bytes.begin(), bytes.begin() + cut);
+        offsets.erase(offsets.begin(), offsets.begin() + count);
+        for (size_t& offset : offsets) offset -= cut;
+        base += count;
+        if (bytes.capacity() > SHIP_BYTES && bytes.size() < bytes.capacity() / 4) bytes.shrink_to_fit();
+        if (offsets.capacity() > 1024 && offsets.size() < offsets.capacity() / 4) offsets.shrink_to_fit();
+    }
+
+    uint64_t first() const {
+        return base;
+    }
+
+    // Records so far; also the position a follower holding all of them reports
+    uint64_t size() const {
+        return base + offsets.size();
+    }
+
+    size_t byteSize() const {
+        return bytes.capacity() + offsets.capacity() * sizeof(size_t);
+    }
+
+    // Appends a log frame holding the records from `from` on, which must be
+    // held, up to about SHIP_BYTES of them, and returns the position after the
+    // last one sent. With nothing to send the frame is empty, which a new
+    // follower takes as the answer to its follow frame.
+    uint64_t ship(wire::Buffer& out, uint64_t from) const {
+        size_t first = size_t(from - base), last = first;
+        if (first < offsets.size()) {
+            last = first + 1;
+            while (last < offsets.size() && offsets[last] - offsets[first] < SHIP_BYTES) last++;
+        }
+        size_t begin = first < offsets.size() ? offsets[first] : bytes.size();
+        size_t end = last < offsets.size() ? offsets[last] : bytes.size();
+
+        size_t start = wire::beginFrame(out, TAG, from);
+        wire::putVarint(out, last - first);
+        wire::putVarint(out, nowNs());
+        out.insert(out.end(), bytes.begin() + begin, bytes.begin() + end);
+        wire::finishFrame(out, start);
+        return from + (last - first);
+    }
+};
+
+// ------------------ State Transfer ------------------
+inline void putTask(wire::Buffer& out, const Task& task) {
+    wire::putSigned(out, task.id);
+    wire::putSigned(out, task.priority);
+    out.push_back(char(task.completed));
+    wire::putString(out, task.deadline);
+    wire::putString(out, task.title);
+    wire::putString(out, task.description);
+}
+
+inline bool readTask(wire::Reader& in, Task& task) {
+    task.id = int(in.signedVarint());
+    task.priority = int(in.signedVarint());
+    task.completed = in.byte() != 0;
+    task.deadline.assign(in.string());
+    task.title.assign(in.string());
+    task.description.assign(in.string());
+    return in.ok && task.id >= 0 && task.priority >= 1 && task.priority <= 10;
+}
+
+// Appends a state frame standing for the first `position` records
+inline void putState(wire::Buffer& out, uint64_t position, const TaskManager& manager) {
+    size_t start = wire::beginFrame(out, STATE_TAG, position);
+    wire::putVarint(out, manager.getGeneration());
+    wire::putVarint(out, uint64_t(manager.getNextId()));
+    wire::putVarint(out, manager.getTaskCount());
+    Task task;
+    for (const TaskRecord& record : manager) {
+        task = Task(record.id, record.title, manager.getDescription(record), record.deadline(), record.priority);
+        task.completed = record.completed;
+        putTask(out, task);
+    }
+    for (const std::vector<UndoAction>& steps : {manager.getUndoHistory(), manager.getRedoHistory()}) {
+        wire::putVarint(out, steps.size());
+        for (const UndoAction& step : steps) {
+            wire::putString(out, step.type);
+            putTask(out, step.before);
+            putTask(out, step.after);
+        }
+    }
+    wire::finishFrame(out, start);
+}
+
+// Loads the rest of a state frame, after its position, into an empty
+// manager; false, changing nothing, if it is malformed
+inline bool readState(wire::Reader& in, TaskManager& manager) {
+    uint64_t generation = in.varint(), next = in.varint(), count = in.varint();
+    if (!in.ok || next > uint64_t(INT_MAX) || count > uint64_t(in.end - in.p)) return false;
+    std::vector<Task> tasks(count);
+    for (Task& task : tasks) {
+        if (!readTask(in, task)) return false;
+    }
+    std::vector<UndoAction> history[2];
+    for (std::vector<UndoAction>& steps : history) {
+        count = in.varint();
+        if (!in.ok || count > uint64_t(in.end - in.p)) return false;
+        steps.resize(count);
+        for (UndoAction& step : steps) {
+            step.type.assign(in.string());
+            if (!readTask(in, step.before) || !readTask(in, step.after)) return false;
+        }
+    }
+    manager.restoreState(tasks, int(next), generation, history[0], history[1]);
+    return true;
+}
+
+// A CommandRunner sink for replayed records; the primary already answered them
+struct DiscardSink {
+    void values(const uint64_t*, size_t) {}
+    void rows(size_t, bool) {}
+    void row(const TaskRecord&, const std::string*) {}
+    void fail(size_t, const char*) {}
+};
+
+} // namespace replication
@@ -0,0 +1,626 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "task_protocol.hpp"
+#include "task_replication.hpp"
+#include "task_snapshot.hpp"
+
+// ------------------ TaskServer ------------------
+// Serves one TaskManager over a Unix socket (task_protocol.hpp) from a single
+// thread: an epoll loop over the listening socket, every client connection
+// and an eventfd that stop() signals. Each readable connection is drained,
+// every complete frame in it is run in order, and all the responses go out
+// in one write. The engine is only ever touched from run(), so it needs no
+// locking. A client that stops reading its responses stops being read once
+// MAX_PENDING_OUTPUT bytes are queued for it. With a snapshot attached, the
+// loop also republishes it (task_snapshot.hpp) once a round of requests has
+// changed the tasks: the counts at once, the table at most once per publish
+// interval, on a timer if nothing else wakes the loop.
+//
+// Followers tail a replication log (task_replication.hpp) over the same
+// socket; it holds the batches of changes not yet acked by all of them, and
+// nothing while none is attached. While at least one follower is attached,
+// an answer goes out only once a follower acks every change made before it
+// was computed: the frame's own, and any other client's that a query in it
+// could have read. So whatever a client saw, acknowledged or merely read,
+// survives the loss of this process. Answers queued behind a held one wait
+// with it. A server set to follow() another one is read-only until
+// promote(). Linux only.
+class TaskServer {
+public:
+    struct Stats {
+        uint64_t connections = 0;
+        uint64_t frames = 0;
+        uint64_t commands = 0;
+        uint64_t recordsApplied = 0;    // log records replayed from the primary
+        uint64_t stateTransfers = 0;    // state frames sent to followers, or loaded from the primary
+        uint64_t lagSamples = 0;        // log frames applied; lag runs from the primary sending one
+        uint64_t lagTotalUs = 0;        // to having applied it
+        uint64_t lagMaxUs = 0;
+    };
+
+    static const size_t MAX_PENDING_OUTPUT = 8u << 20;
+
+private:
+    static const int MAX_EVENTS = 64;
+    static const size_t READ_CHUNK = 64u << 10;
+
+    struct Connection {
+        enum Role { CLIENT, FOLLOWER, PRIMARY };   // PRIMARY: our link to the server we follow
+        int fd = -1;
+        Role role = CLIENT;
+        wire::Buffer in;            // received bytes not yet run
+        wire::Buffer out;           // responses; out[sent..ready) may be written
+        size_t sent = 0;
+        size_t ready = 0;           // the rest waits for a follower's ack
+        std::deque<std::pair<size_t, uint64_t>> held;   // (end of an answer in out, log records it needs acked)
+        uint64_t shipped = 0;       // FOLLOWER: log records sent to it
+        uint64_t acked = 0;         // FOLLOWER: log records it holds
+        uint32_t events = 0;        // what epoll watches for
+        bool peerClosed = false;    // no more requests; close once out drains
+    };
+
+    TaskManager& manager;
+    std::string socketPath;
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    std::vector<char> readBuffer;
+    std::vector<BatchCommand> commands;     // one frame's commands
+    Stats stats;
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> promoting{false};
+
+    replication::Log log;
+    std::vector<int> followers;             // connections tailing the log
+    uint64_t ackedRecords = 0;              // the most records any follower holds
+    int primaryFd = -1;                     // while following
+    bool readOnly = false;                  // from follow() until promote()
+
+    SnapshotWriter* snapshot = nullptr;
+    std::chrono::milliseconds publishInterval{0};
+    std::chrono::steady_clock::time_point nextTablePublish;
+    uint64_t countsGeneration = 0;          // what the snapshot's counts and table show
+    uint64_t tableGeneration = 0;
+
+    // Brings the snapshot up to date as far as the interval allows; returns
+    // the epoll timeout until the table is due, -1 if it is current
+    int publishSnapshot() {
+        if (snapshot == nullptr) return -1;
+        uint64_t generation = manager.getGeneration();
+        if (generation != countsGeneration) {
+            snapshot->publishCounts(manager);
+            countsGeneration = generation;
+        }
+        if (generation == tableGeneration) return -1;
+        auto now = std::chrono::steady_clock::now();
+        if (now < nextTablePublish) {
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(nextTablePublish - now);
+            return int(wait.count()) + 1;
+        }
+        snapshot->publishTasks(manager);
+        tableGeneration = generation;
+        nextTablePublish = now + publishInterval;
+        return -1;
+    }
+
+    // Appends each batch of changes a runner applies to the log, or only
+    // counts it while no follower could ask for it
+    CommandRunner<wire::FrameSink>::Observer logBatches() {
+        return [this](const std::vector<BatchCommand>& batch) {
+            if (followers.empty()) log.reset(log.size() + 1);
+            else log.append(batch);
+        };
+    }
+
+    // Drops the records every follower holds
+    void trimLog() {
+        uint64_t held = log.size();
+        for (int fd : followers) held = std::min(held, connections[fd]->acked);
+        log.trim(held);
+    }
+
+    static bool socketAddress(const std::string& path, sockaddr_un& address) {
+        address = {};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            errno = ENAMETOOLONG;
+            return false;
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        return true;
+    }
+
+    void wake() {
+        uint64_t one = 1;
+        ssize_t written = write(wakeFd, &one, sizeof(one));
+        (void)written;
+    }
+
+    bool watch(int fd, uint32_t events, int op) {
+        epoll_event event = {};
+        event.events = events;
+        event.data.fd = fd;
+        return epoll_ctl(epollFd, op, fd, &event) == 0;
+    }
+
+    void closeConnection(int fd) {
+        auto it = connections.find(fd);
+        if (it == connections.end()) return;
+        Connection::Role role = it->second->role;
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        connections.erase(it);
+        if (role == Connection::FOLLOWER) {
+            followers.erase(std::find(followers.begin(), followers.end(), fd));
+            if (followers.empty()) release(UINT64_MAX);     // nobody left to wait for
+            trimLog();
+        }
+        else if (role == Connection::PRIMARY) {
+            primaryFd = -1;
+        }
+    }
+
+    void acceptAll() {
+        while (true) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR) continue;
+                return;             // EAGAIN, or out of descriptors until one closes
+            }
+            auto connection = std::make_unique<Connection>();
+            connection->fd = fd;
+            connection->events = EPOLLIN;
+            if (!watch(fd, connection->events, EPOLL_CTL_ADD)) {
+                ::close(fd);
+                continue;
+            }
+            connections[fd] = std::move(connection);
+            stats.connections++;
+        }
+    }
+
+    // Decodes the whole frame before running any of it, so a malformed frame
+    // changes nothing; the caller then drops the connection
+    bool runFrame(Connection& connection, const char* frame, size_t size) {
+        wire::Reader in(frame + wire::HEADER_SIZE, frame + size);
+        uint32_t tag = wire::getU32(frame + 4);
+        uint64_t count = in.varint();
+        if (!in.ok || count > size) return false;
+        commands.resize(count);
+        for (uint64_t i = 0; i < count; i++) {
+            commands[i] = BatchCommand();
+            if (!wire::readCommand(in, commands[i])) return false;
+            commands[i].line = i;
+        }
+        if (!in.atEnd()) return false;
+
+        size_t start = wire::beginFrame(connection.out, tag, count);
+        wire::FrameSink sink(connection.out);
+        CommandRunner<wire::FrameSink> runner(manager, sink, logBatches());
+        for (BatchCommand& command : commands) {
+            if (readOnly && isMutation(command.op)) runner.reject(command.line, "read-only follower");
+            else runner.submit(std::move(command));
+        }
+        runner.finish();
+        wire::finishFrame(connection.out, start);
+        hold(connection);
+        stats.frames++;
+        stats.commands += count;
+        return true;
+    }
+
+    // The answer just queued waits for a follower to ack every record so far,
+    // unless that has happened already or there is no follower
+    void hold(Connection& connection) {
+        if (followers.empty() || (log.size() <= ackedRecords && connection.held.empty())) {
+            connection.ready = connection.out.size();
+            return;
+        }
+        connection.held.emplace_back(connection.out.size(), log.size());
+    }
+
+    // Lets out the answers held for records up to `acked`
+    void release(uint64_t acked) {
+        std::vector<int> done;
+        for (auto& entry : connections) {
+            Connection& connection = *entry.second;
+            if (connection.held.empty() || connection.held.front().second > acked) continue;
+            while (!connection.held.empty() && connection.held.front().second <= acked) {
+                connection.ready = connection.held.front().first;
+                connection.held.pop_front();
+            }
+            if (!flush(connection) || !updateEvents(connection) ||
+                (connection.peerClosed && connection.events == 0)) {
+                done.push_back(entry.first);
+            }
+        }
+        for (int fd : done) closeConnection(fd);
+    }
+
+    // A tag-0 frame: a client asking to follow, with the records it already
+    // holds, or a follower acking the records it has applied. A new follower
+    // that holds nothing, or less than the log reaches back to, gets the
+    // state first; it counts as holding anything only once it acks.
+    bool onReplicationFrame(Connection& connection, const char* frame, size_t size) {
+        wire::Reader in(frame + wire::HEADER_SIZE, frame + size);
+        uint64_t position = in.varint();
+        if (!in.ok || !in.atEnd() || position > log.size()) return false;
+        if (connection.role == Connection::CLIENT) {
+            if (!connection.held.empty()) return false;
+            connection.role = Connection::FOLLOWER;
+            if (position == 0 || position < log.first()) {
+                position = log.size();
+                replication::putState(connection.out, position, manager);
+                stats.stateTransfers++;
+            }
+            connection.shipped = log.ship(connection.out, position);
+            connection.acked = position;
+            connection.ready = connection.out.size();
+            followers.push_back(connection.fd);
+            return true;
+        }
+        if (position > connection.shipped) return false;
+        connection.acked = std::max(connection.acked, position);
+        trimLog();
+        if (position > ackedRecords) {
+            ackedRecords = position;
+            release(ackedRecords);
+        }
+        return true;
+    }
+
+    // Queues the records a follower lacks, as far as its output allows
+    void shipTo(Connection& connection) {
+        while (connection.shipped < log.size() && connection.out.size() - connection.sent < MAX_PENDING_OUTPUT) {
+            connection.shipped = log.ship(connection.out, connection.shipped);
+        }
+        connection.ready = connection.out.size();
+    }
+
+    void shipLog() {
+        std::vector<int> behind;
+        for (int fd : followers) {
+            if (connections[fd]->shipped < log.size()) behind.push_back(fd);
+        }
+        for (int fd : behind) onWritable(*connections[fd]);
+    }
+
+    // One log frame from the primary: replays its records in order, each as
+    // one batch, then acks them. The records go into this server's own log,
+    // so it can have followers too.
+    bool applyLog(Connection& connection, const char* frame, size_t size) {
+        wire::Reader in(frame + wire::HEADER_SIZE, frame + size);
+        uint64_t first = in.varint(), count = in.varint(), sentAt = in.varint();
+        if (!in.ok || wire::getU32(frame + 4) != replication::TAG || first != log.size()) return false;
+        replication::DiscardSink sink;
+        CommandRunner<replication::DiscardSink> runner(manager, sink, logBatches());
+        for (uint64_t r = 0; r < count; r++) {
+            uint64_t n = in.varint();
+            if (!in.ok || n == 0 || n > size) return false;
+            commands.resize(n);
+            for (BatchCommand& command : commands) {
+                command = BatchCommand();
+                if (!wire::readCommand(in, command) || !isMutation(command.op)) return false;
+            }
+            for (BatchCommand& command : commands) runner.submit(std::move(command));
+            runner.flushMutations();
+            stats.recordsApplied++;
+        }
+        if (!in.atEnd()) return false;
+        if (count > 0) {
+            uint64_t now = replication::nowNs();
+            uint64_t lagUs = now > sentAt ? (now - sentAt) / 1000 : 0;
+            stats.lagSamples++;
+            stats.lagTotalUs += lagUs;
+            stats.lagMaxUs = std::max(stats.lagMaxUs, lagUs);
+        }
+        replication::putPosition(connection.out, log.size());
+        connection.ready = connection.out.size();
+        return true;
+    }
+
+    // The primary's state, sent before any record to a new follower: loads it
+    // into the still empty manager and goes on from the records it stands for
+    bool applyState(const char* frame, size_t size) {
+        wire::Reader in(frame + wire::HEADER_SIZE, frame + size);
+        uint64_t position = in.varint();
+        if (!in.ok || log.size() != 0 || manager.getGeneration() != 0) return false;
+        if (!replication::readState(in, manager) || !in.atEnd()) return false;
+        log.reset(position);
+        stats.stateTransfers++;
+        return true;
+    }
+
+    void becomePrimary() {
+        if (primaryFd >= 0) closeConnection(primaryFd);
+        readOnly = false;
+    }
+
+    // Runs every complete frame in `in`; false if one is malformed or too big
+    bool runFrames(Connection& connection) {
+        size_t offset = 0;
+        bool ok = true;
+        while (connection.in.size() - offset >= 4) {
+            const char* data = connection.in.data() + offset;
+            uint32_t body = wire::getU32(data);
+            if ((body > wire::MAX_FRAME_SIZE && connection.role != Connection::PRIMARY) ||
+                body + 4 < wire::HEADER_SIZE) {
+                ok = false;
+                break;
+            }
+            size_t size = wire::completeFrame(data, connection.in.size() - offset);
+            if (size == 0) break;
+            bool ran;
+            if (connection.role == Connection::PRIMARY) {
+                ran = wire::getU32(data + 4) == replication::STATE_TAG ? applyState(data, size)
+                                                                       : applyLog(connection, data, size);
+            }
+            else if (wire::getU32(data + 4) == replication::TAG) ran = onReplicationFrame(connection, data, size);
+            else ran = connection.role == Connection::CLIENT && runFrame(connection, data, size);
+            if (!ran) {
+                ok = false;
+                break;
+            }
+            offset += size;
+        }
+        connection.in.erase(connection.in.begin(), connection.in.begin() + offset);
+        return ok;
+    }
+
+    // Writes what it can of what is ready; false if the connection is broken
+    bool flush(Connection& connection) {
+        while (connection.sent < connection.ready) {
+            ssize_t n = ::send(connection.fd, connection.out.data() + connection.sent,
+                               connection.ready - connection.sent, MSG_NOSIGNAL);
+            if (n > 0) {
+                connection.sent += size_t(n);
+            }
+            else if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            else {
+                return false;
+            }
+        }
+        if (connection.sent == connection.out.size()) {
+            connection.sent = connection.ready = 0;
+            if (connection.out.capacity() > MAX_PENDING_OUTPUT) wire::Buffer().swap(connection.out);
+            else connection.out.clear();
+        }
+        return true;
+    }
+
+    // Watches for writability while output is ready, and for requests while
+    // not too much of it is queued, held or not
+    bool updateEvents(Connection& connection) {
+        size_t pending = connection.out.size() - connection.sent;
+        uint32_t events = 0;
+        if (!connection.peerClosed && pending < MAX_PENDING_OUTPUT) events |= EPOLLIN;
+        if (connection.ready > connection.sent) events |= EPOLLOUT;
+        if (events == connection.events) return true;
+        connection.events = events;
+        return watch(connection.fd, events, EPOLL_CTL_MOD);
+    }
+
+    void onReadable(Connection& connection) {
+        while (true) {
+            ssize_t n = ::read(connection.fd, readBuffer.data(), readBuffer.size());
+            if (n > 0) {
+                connection.in.insert(connection.in.end(), readBuffer.data(), readBuffer.data() + n);
+                if (size_t(n) < readBuffer.size()) break;
+                if (connection.in.size() > wire::MAX_FRAME_SIZE + MAX_PENDING_OUTPUT) break;
+            }
+            else if (n == 0) {
+                connection.peerClosed = true;
+                break;
+            }
+            else if (errno == EINTR) {
+                continue;
+            }
+            else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            else {
+                return closeConnection(connection.fd);
+            }
+        }
+        onWritable(connection, runFrames(connection));
+    }
+
+    void onWritable(Connection& connection, bool ok = true) {
+        if (ok && connection.role == Connection::FOLLOWER) shipTo(connection);
+        if (!ok || !flush(connection) || !updateEvents(connection) ||
+            (connection.peerClosed && connection.events == 0)) {
+            closeConnection(connection.fd);
+        }
+    }
+
+public:
+    explicit TaskServer(TaskManager& _manager) : manager(_manager), readBuffer(READ_CHUNK) {}
+
+    TaskServer(const TaskServer&) = delete;
+    TaskServer& operator=(const TaskServer&) = delete;
+
+    ~TaskServer() {
+        for (auto& entry : connections) ::close(entry.first);
+        if (listenFd >= 0) {
+            ::close(listenFd);
+            unlink(socketPath.c_str());
+        }
+        if (epollFd >= 0) ::close(epollFd);
+        if (wakeFd >= 0) ::close(wakeFd);
+    }
+
+    // Binds `path`, replacing a stale socket file but not a live daemon.
+    // Returns false with errno set on failure (EADDRINUSE if one is running).
+    bool listen(const std::string& path) {
+        sockaddr_un address;
+        if (!socketAddress(path, address)) return false;
+
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool live = probe >= 0 && connect(probe, (const sockaddr*)&address, sizeof(address)) == 0;
+        if (probe >= 0) ::close(probe);
+        if (live) {
+            errno = EADDRINUSE;
+            return false;
+        }
+        unlink(path.c_str());
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (listenFd < 0 || epollFd < 0 || wakeFd < 0) return false;
+        if (bind(listenFd, (const sockaddr*)&address, sizeof(address)) != 0) {
+            int error = errno;
+            ::close(listenFd);
+            listenFd = -1;
+            errno = error;
+            return false;
+        }
+        socketPath = path;
+        return ::listen(listenFd, SOMAXCONN) == 0 &&
+               watch(listenFd, EPOLLIN, EPOLL_CTL_ADD) && watch(wakeFd, EPOLLIN, EPOLL_CTL_ADD);
+    }
+
+    // Publishes the tasks to `writer` from run(), the table at most once per
+    // `interval`. Call before run(); the first publish happens at once.
+    void setSnapshot(SnapshotWriter* writer, std::chrono::milliseconds interval) {
+        snapshot = writer;
+        publishInterval = interval;
+        if (snapshot == nullptr) return;
+        snapshot->publishCounts(manager);
+        snapshot->publishTasks(manager);
+        countsGeneration = tableGeneration = manager.getGeneration();
+        nextTablePublish = std::chrono::steady_clock::now() + publishInterval;
+    }
+
+    // Makes this server a read-only follower of the daemon at `path`: it
+    // loads that daemon's state into the manager, which must still be empty,
+    // then replays its log and acks each record once applied. Queries are served as usual. Call
+    // after listen() and before run(). Returns false with errno set if the
+    // primary can't be reached.
+    bool follow(const std::string& path) {
+        if (log.size() == 0 && manager.getGeneration() != 0) {
+            errno = EINVAL;
+            return false;
+        }
+        sockaddr_un address;
+        if (!socketAddress(path, address)) return false;
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return false;
+        if (connect(fd, (const sockaddr*)&address, sizeof(address)) != 0 ||
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0) {
+            int error = errno;
+            ::close(fd);
+            errno = error;
+            return false;
+        }
+        auto connection = std::make_unique<Connection>();
+        connection->fd = fd;
+        connection->role = Connection::PRIMARY;
+        connection->events = EPOLLIN;
+        replication::putPosition(connection->out, log.size());
+        connection->ready = connection->out.size();
+        if (!watch(fd, connection->events, EPOLL_CTL_ADD) || !flush(*connection)) {
+            int error = errno;
+            ::close(fd);
+            errno = error;
+            return false;
+        }
+        connections[fd] = std::move(connection);
+        primaryFd = fd;
+        readOnly = true;
+        return true;
+    }
+
+    // Stops following and starts accepting changes, from the last record
+    // applied; a lost primary does not do this by itself. Safe from another
+    // thread or a signal handler.
+    void promote() {
+        promoting = true;
+        wake();
+    }
+
+    // Serves until stop(); call after a successful listen()
+    void run() {
+        epoll_event events[MAX_EVENTS];
+        int timeout = -1;
+        while (true) {
+            int count = epoll_wait(epollFd, events, MAX_EVENTS, timeout);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            for (int i = 0; i < count; i++) {
+                int fd = events[i].data.fd;
+                if (fd == wakeFd) {
+                    uint64_t count;
+                    ssize_t got = read(wakeFd, &count, sizeof(count));
+                    (void)got;
+                    if (stopping) return;
+                    if (promoting.exchange(false)) becomePrimary();
+                    continue;
+                }
+                if (fd == listenFd) {
+                    acceptAll();
+                    continue;
+                }
+                auto it = connections.find(fd);
+                if (it == connections.end()) continue;      // closed earlier in this round
+                Connection& connection = *it->second;
+                if (events[i].events & EPOLLERR) closeConnection(fd);
+                else if (events[i].events & (EPOLLIN | EPOLLHUP)) onReadable(connection);
+                else if (events[i].events & EPOLLOUT) onWritable(connection);
+            }
+            shipLog();
+            timeout = publishSnapshot();
+        }
+    }
+
+    // Makes run() return; safe from another thread or a signal handler
+    void stop() {
+        stopping = true;
+        wake();
+    }
+
+    const Stats& getStats() const {
+        return stats;
+    }
+
+    size_t connectionCount() const {
+        return connections.size();
+    }
+
+    // Records in the replication log so far, including those dropped
+    uint64_t logSize() const {
+        return log.size();
+    }
+
+    // Memory held by the records not yet acked by every follower
+    size_t logBytes() const {
+        return log.byteSize();
+    }
+
+    bool isReadOnly() const {
+        return readOnly;
+    }
+};
@@ -0,0 +1,385 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "task_manager.hpp"
+
+// ------------------ Task Snapshot ------------------
+// A read-only copy of the daemon's tasks in POSIX shared memory, for readers
+// such as dashboards and status-bar widgets that should not make a round
+// trip per look. todod writes it; readers map it read-only and never contact
+// the daemon or take a lock.
+//
+// The segment holds two parts, each behind a sequence counter that is odd
+// while the writer is inside it (a seqlock): the live counts, rewritten after
+// every change, and the task table (hot fields, display order, no
+// descriptions), rewritten at most every publish interval. The table has two
+// slots; the writer fills the one readers are not pointed at and then flips
+// `active`, so a reader only retries if two publishes land while it copies.
+// Readers copy first and check the counter afterwards, so every offset read
+// from the segment is clamped before use: a torn copy is thrown away, but it
+// must not send the copy out of bounds.
+
+struct SnapshotCounts {
+    uint64_t generation = 0;
+    uint64_t tasks = 0;
+    uint64_t pending = 0;
+    uint64_t completed = 0;
+    uint64_t nextId = 0;
+};
+
+namespace snapshot_detail {
+
+const uint64_t MAGIC = 0x32504e5344444f54ull;    // "TODDSNP2"
+
+// Counts behind their own sequence counter; the fields are atomics so the
+// racing reads of a seqlock stay well-defined
+struct SeqCounts {
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> generation, tasks, pending, completed, nextId;
+
+    void store(const SnapshotCounts& counts) {
+        uint64_t start = sequence.load(std::memory_order_relaxed);
+        sequence.store(start + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        generation.store(counts.generation, std::memory_order_relaxed);
+        tasks.store(counts.tasks, std::memory_order_relaxed);
+        pending.store(counts.pending, std::memory_order_relaxed);
+        completed.store(counts.completed, std::memory_order_relaxed);
+        nextId.store(counts.nextId, std::memory_order_relaxed);
+        sequence.store(start + 2, std::memory_order_release);
+    }
+
+    // One attempt; false if it raced a store
+    bool load(SnapshotCounts& counts) const {
+        uint64_t start = sequence.load(std::memory_order_acquire);
+        if (start & 1) return false;
+        counts.generation = generation.load(std::memory_order_relaxed);
+        counts.tasks = tasks.load(std::memory_order_relaxed);
+        counts.pending = pending.load(std::memory_order_relaxed);
+        counts.completed = completed.load(std::memory_order_relaxed);
+        counts.nextId = nextId.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return sequence.load(std::memory_order_relaxed) == start;
+    }
+};
+
+struct Header {
+    std::atomic<uint64_t> magic;        // set last, once the segment is ready
+    uint64_t slotBytes;                 // size of each table slot, header included
+    std::atomic<uint32_t> active;       // the slot readers should use
+    std::atomic<uint32_t> published;    // 0 until the first table is written
+    SeqCounts live;
+};
+
+// Row i of a slot; its title sits at textOffset
+struct Entry {
+    int32_t id;
+    int32_t priority;
+    uint32_t textOffset;                // from the start of the slot
+    uint32_t titleLength;
+    uint32_t deadlineDay;               // see deadlineDayNumber()
+    uint8_t completed;
+    uint8_t unused[3];
+};
+
+// Entries grow up from the slot header, text grows down from the slot end
+struct Slot {
+    SeqCounts table;                    // counts of the tasks in this table
+    uint64_t rows;
+    uint64_t truncated;                 // 1 if the tasks did not all fit
+};
+
+inline size_t headerBytes() {
+    return (sizeof(Header) + 63) / 64 * 64;
+}
+
+inline std::string defaultName() {
+    return "/todod-" + std::to_string(getuid());
+}
+
+// Bytes copied out of a slot, clamped to it
+inline void copyText(const char* slot, uint64_t slotBytes, uint64_t offset, uint64_t length, std::string& out) {
+    if (offset > slotBytes) offset = slotBytes;
+    if (length > slotBytes - offset) length = slotBytes - offset;
+    out.assign(slot + offset, length);
+}
+
+} // namespace snapshot_detail
+
+inline std::string defaultSnapshotName() {
+    return snapshot_detail::defaultName();
+}
+
+// ------------------ SnapshotWriter ------------------
+// Owns the segment; only one process writes it. The segment is sized up
+// front, but tmpfs only backs the pages the tables actually touch.
+class SnapshotWriter {
+private:
+    std::string name;
+    char* base = nullptr;
+    size_t size = 0;
+
+    snapshot_detail::Header& header() const {
+        return *reinterpret_cast<snapshot_detail::Header*>(base);
+    }
+
+    char* slotAt(uint32_t index) const {
+        return base + snapshot_detail::headerBytes() + index * header().slotBytes;
+    }
+
+    static SnapshotCounts countsOf(const TaskManager& manager) {
+        SnapshotCounts counts;
+        counts.generation = manager.getGeneration();
+        counts.tasks = manager.getTaskCount();
+        counts.pending = manager.getPendingCount();
+        counts.completed = manager.getCompletedCount();
+        counts.nextId = uint64_t(manager.getNextId());
+        return counts;
+    }
+
+public:
+    SnapshotWriter() = default;
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    ~SnapshotWriter() {
+        if (base != nullptr) {
+            munmap(base, size);
+            shm_unlink(name.c_str());
+        }
+    }
+
+    // Creates (or replaces) segment `name` with two table slots of slotBytes
+    // each. Returns false with errno set on failure.
+    bool create(const std::string& _name, size_t slotBytes) {
+        using namespace snapshot_detail;
+        slotBytes = std::min<size_t>(std::max(slotBytes, sizeof(Slot) + 64), UINT32_MAX) / 64 * 64;     // text offsets are 32-bit
+        shm_unlink(_name.c_str());
+        int fd = shm_open(_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) return false;
+        size_t bytes = headerBytes() + 2 * slotBytes;
+        void* mapped = MAP_FAILED;
+        if (ftruncate(fd, off_t(bytes)) == 0) {
+            mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        int error = errno;
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            shm_unlink(_name.c_str());
+            errno = error;
+            return false;
+        }
+
+        name = _name;
+        base = static_cast<char*>(mapped);
+        size = bytes;
+        new (base) Header();            // zeroed by ftruncate; this just starts the atomics' lifetimes
+        header().slotBytes = slotBytes;
+        for (uint32_t i = 0; i < 2; i++) new (slotAt(i)) Slot();
+        header().magic.store(MAGIC, std::memory_order_release);
+        return true;
+    }
+
+    const std::string& getName() const {
+        return name;
+    }
+
+    // O(1); call after every change
+    void publishCounts(const TaskManager& manager) {
+        header().live.store(countsOf(manager));
+    }
+
+    // O(tasks): writes the table into the idle slot, then points readers at it
+    void publishTasks(const TaskManager& manager) {
+        using namespace snapshot_detail;
+        TRACE_SCOPE("engine", "SnapshotWriter::publishTasks");
+        Header& head = header();
+        uint32_t index = head.published.load(std::memory_order_relaxed) ? 1 - head.active.load(std::memory_order_relaxed) : 0;
+        char* slotBase = slotAt(index);
+        Slot& slot = *reinterpret_cast<Slot*>(slotBase);
+
+        // The slot's own counter brackets the whole rewrite
+        uint64_t start = slot.table.sequence.load(std::memory_order_relaxed);
+        slot.table.sequence.store(start + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        Entry* entries = reinterpret_cast<Entry*>(slotBase + sizeof(Slot));
+        uint64_t rows = 0, textStart = head.slotBytes;
+        uint64_t completed = 0;
+        bool truncated = false;
+        for (const TaskRecord& task : manager) {
+            uint64_t length = task.title.size();
+            uint64_t entriesEnd = sizeof(Slot) + (rows + 1) * sizeof(Entry);
+            if (entriesEnd + length > textStart) {
+                truncated = true;
+                break;
+            }
+            textStart -= length;
+            std::memcpy(slotBase + textStart, task.title.data(), task.title.size());
+            Entry& entry = entries[rows++];
+            entry.id = task.id;
+            entry.priority = task.priority;
+            entry.textOffset = uint32_t(textStart);
+            entry.titleLength = uint32_t(task.title.size());
+            entry.deadlineDay = task.deadlineDay;
+            entry.completed = task.completed;
+            std::memset(entry.unused, 0, sizeof(entry.unused));
+            if (task.completed) completed++;
+        }
+
+        // The table's counts describe the rows it holds, even when truncated
+        SnapshotCounts counts = countsOf(manager);
+        if (truncated) {
+            counts.tasks = rows;
+            counts.completed = completed;
+            counts.pending = rows - completed;
+        }
+        slot.table.generation.store(counts.generation, std::memory_order_relaxed);
+        slot.table.tasks.store(counts.tasks, std::memory_order_relaxed);
+        slot.table.pending.store(counts.pending, std::memory_order_relaxed);
+        slot.table.completed.store(counts.completed, std::memory_order_relaxed);
+        slot.table.nextId.store(counts.nextId, std::memory_order_relaxed);
+        slot.rows = rows;
+        slot.truncated = truncated;
+        slot.table.sequence.store(start + 2, std::memory_order_release);
+
+        head.active.store(index, std::memory_order_release);
+        head.published.store(1, std::memory_order_release);
+    }
+};
+
+// ------------------ SnapshotReader ------------------
+// Maps a segment read-only. Reads retry until they get a copy no publish
+// overlapped; they never block the writer or each other.
+class SnapshotReader {
+private:
+    const char* base = nullptr;
+    size_t size = 0;
+    mutable std::vector<snapshot_detail::Entry> entries;       // scratch for readTasks
+    mutable uint64_t retries = 0;
+
+    const snapshot_detail::Header& header() const {
+        return *reinterpret_cast<const snapshot_detail::Header*>(base);
+    }
+
+public:
+    SnapshotReader() = default;
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    ~SnapshotReader() {
+        close();
+    }
+
+    // False with errno set if there is no segment `name` (no daemon running)
+    bool open(const std::string& name) {
+        using namespace snapshot_detail;
+        close();
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0) return false;
+        struct stat info;
+        void* mapped = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && size_t(info.st_size) >= headerBytes()) {
+            mapped = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        }
+        else {
+            errno = EINVAL;
+        }
+        int error = errno;
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            errno = error;
+            return false;
+        }
+        base = static_cast<const char*>(mapped);
+        size = size_t(info.st_size);
+        const Header& head = header();
+        if (head.magic.load(std::memory_order_acquire) != MAGIC ||
+            headerBytes() + 2 * head.slotBytes > size) {
+            close();
+            errno = EINVAL;
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (base != nullptr) munmap(const_cast<char*>(base), size);
+        base = nullptr;
+        size = 0;
+    }
+
+    bool isOpen() const {
+        return base != nullptr;
+    }
+
+    // The counts as of the daemon's last change
+    bool readCounts(SnapshotCounts& counts) const {
+        if (base == nullptr) return false;
+        while (!header().live.load(counts)) retries++;
+        return true;
+    }
+
+    // Rows [first, first + count) of the last published table, in display
+    // order and without descriptions, plus that table's counts. False if no
+    // table has been published yet.
+    bool readTasks(size_t first, size_t count, std::vector<TaskRecord>& rows, SnapshotCounts* counts = nullptr) const {
+        using namespace snapshot_detail;
+        if (base == nullptr || !header().published.load(std::memory_order_acquire)) return false;
+        const uint64_t slotBytes = header().slotBytes;
+        const uint64_t maxRows = (slotBytes - sizeof(Slot)) / sizeof(Entry);
+        while (true) {
+            uint32_t index = header().active.load(std::memory_order_acquire) & 1;
+            const char* slotBase = base + headerBytes() + index * slotBytes;
+            const Slot& slot = *reinterpret_cast<const Slot*>(slotBase);
+            uint64_t start = slot.table.sequence.load(std::memory_order_acquire);
+            if (start & 1) {
+                retries++;
+                continue;
+            }
+
+            SnapshotCounts tableCounts;
+            tableCounts.generation = slot.table.generation.load(std::memory_order_relaxed);
+            tableCounts.tasks = slot.table.tasks.load(std::memory_order_relaxed);
+            tableCounts.pending = slot.table.pending.load(std::memory_order_relaxed);
+            tableCounts.completed = slot.table.completed.load(std::memory_order_relaxed);
+            tableCounts.nextId = slot.table.nextId.load(std::memory_order_relaxed);
+            uint64_t total = std::min<uint64_t>(slot.rows, maxRows);
+            uint64_t from = std::min<uint64_t>(first, total);
+            uint64_t n = std::min<uint64_t>(count, total - from);
+            entries.resize(n);
+            std::memcpy(entries.data(), slotBase + sizeof(Slot) + from * sizeof(Entry), n * sizeof(Entry));
+            rows.resize(n);
+            for (uint64_t i = 0; i < n; i++) {
+                const Entry& entry = entries[i];
+                TaskRecord& row = rows[i];
+                row.id = entry.id;
+                row.priority = entry.priority;
+                row.completed = entry.completed != 0;
+                row.deadlineDay = entry.deadlineDay;
+                copyText(slotBase, slotBytes, entry.textOffset, entry.titleLength, row.title);
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.table.sequence.load(std::memory_order_relaxed) == start) {
+                if (counts != nullptr) *counts = tableCounts;
+                return true;
+            }
+            retries++;
+        }
+    }
+
+    // Attempts thrown away because a publish overlapped them
+    uint64_t getRetries() const {
+        return retries;
+    }
+};
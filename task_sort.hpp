@@ -0,0 +1,143 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// ------------------ Key Sorting ------------------
+// Non-comparison sorts over compact (key, handle) pairs. Only the 8-16 byte
+// entries move; the tasks themselves are gathered once in the final order.
+// Both sorts are stable, so equal keys keep their original relative order.
+
+template <class Handle>
+struct SortEntry {
+    uint32_t key;
+    Handle handle;
+};
+
+const uint32_t PRIORITY_BUCKETS = 16;   // priorities 1-10 fit in 4 bits
+const uint32_t NO_DEADLINE_KEY = 0xFFFFFFFFu;
+
+// Day number of a calendar date: 31 slots per month, so numbers are
+// monotonic but not contiguous. Month and day must already be in range.
+inline uint32_t dayNumberOf(int year, int month, int day) {
+    return uint32_t(year) * 12 * 31 + uint32_t(month - 1) * 31 + uint32_t(day - 1);
+}
+
+// "YYYY-MM-DD" -> monotonic day number. Ordering matches Date::isLessThan
+// (year, then month, then day). Unparsable deadlines, and those with a month
+// or day out of range, sort last.
+inline uint32_t deadlineDayNumber(std::string_view deadline) {
+    int parts[3] = {0, 0, 0};
+    int part = 0;
+    bool digits = false;
+    for (char c : deadline) {
+        if (c >= '0' && c <= '9') {
+            parts[part] = parts[part] * 10 + (c - '0');
+            digits = true;
+            if (parts[part] > 99999) return NO_DEADLINE_KEY;
+        }
+        else if (c == '-' && digits && part < 2) {
+            part++;
+            digits = false;
+        }
+        else {
+            break;
+        }
+    }
+    if (part != 2 || !digits) return NO_DEADLINE_KEY;
+
+    if (parts[1] < 1 || parts[1] > 12 || parts[2] < 1 || parts[2] > 31) return NO_DEADLINE_KEY;
+    return dayNumberOf(parts[0], parts[1], parts[2]);
+}
+
+// The inverse for dates in range: "YYYY-MM-DD", or empty for NO_DEADLINE_KEY
+inline std::string dayNumberToString(uint32_t day) {
+    if (day == NO_DEADLINE_KEY) return std::string();
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "%04u-%02u-%02u", day / (12 * 31), day / 31 % 12 + 1, day % 31 + 1);
+    return buffer;
+}
+
+// Deadline first, priority as tie-break; still fits in 32 bits
+inline uint32_t deadlinePriorityKey(const std::string& deadline, int priority) {
+    uint32_t day = deadlineDayNumber(deadline);
+    if (day == NO_DEADLINE_KEY) day = (NO_DEADLINE_KEY >> 4);
+    return (day << 4) | (uint32_t(priority) & 0xF);
+}
+
+// Stable counting sort for keys in [0, buckets)
+template <class Handle>
+void countingSortByKey(std::vector<SortEntry<Handle>>& entries, uint32_t buckets) {
+    std::vector<size_t> offsets(buckets + 1, 0);
+    for (const auto& entry : entries) {
+        offsets[entry.key + 1]++;
+    }
+    for (uint32_t b = 0; b < buckets; b++) {
+        offsets[b + 1] += offsets[b];
+    }
+
+    std::vector<SortEntry<Handle>> sorted(entries.size());
+    for (const auto& entry : entries) {
+        sorted[offsets[entry.key]++] = entry;
+    }
+    entries.swap(sorted);
+}
+
+// LSD radix sort on the full 32-bit key, one byte per pass. Passes where
+// every key has the same byte are skipped, so day numbers (which share
+// their top byte) usually take three passes instead of four.
+template <class Handle>
+void radixSortByKey(std::vector<SortEntry<Handle>>& entries) {
+    if (entries.size() < 2) return;
+
+    size_t counts[4][256] = {};
+    for (const auto& entry : entries) {
+        counts[0][entry.key & 0xFF]++;
+        counts[1][(entry.key >> 8) & 0xFF]++;
+        counts[2][(entry.key >> 16) & 0xFF]++;
+        counts[3][entry.key >> 24]++;
+    }
+
+    std::vector<SortEntry<Handle>> buffer(entries.size());
+    for (int pass = 0; pass < 4; pass++) {
+        int shift = pass * 8;
+        size_t* count = counts[pass];
+        if (count[(entries[0].key >> shift) & 0xFF] == entries.size()) continue;
+
+        size_t offset = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+        for (const auto& entry : entries) {
+            buffer[count[(entry.key >> shift) & 0xFF]++] = entry;
+        }
+        entries.swap(buffer);
+    }
+}
+
+// Builds (key, index) entries for a random-access container
+template <class Container, class KeyFn>
+std::vector<SortEntry<uint32_t>> makeSortEntries(const Container& items, KeyFn keyOf) {
+    std::vector<SortEntry<uint32_t>> entries;
+    entries.reserve(items.size());
+    for (size_t i = 0; i < items.size(); i++) {
+        entries.push_back({keyOf(items[i]), uint32_t(i)});
+    }
+    return entries;
+}
+
+// Reorders items to match sorted entries, moving each element exactly once
+template <class T>
+void applySortOrder(std::vector<T>& items, const std::vector<SortEntry<uint32_t>>& entries) {
+    std::vector<T> ordered;
+    ordered.reserve(items.size());
+    for (const auto& entry : entries) {
+        ordered.push_back(std::move(items[entry.handle]));
+    }
+    items.swap(ordered);
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include "memory_stats.hpp"
+
+// ------------------ TitleIndex ------------------
+// Exact-title lookup: a multimap from the hash of a title to the ids carrying
+// it. Only the hash is kept, not the string, so an entry costs one small node;
+// callers confirm candidates against the record's title, which also weeds out
+// hash collisions. Lookups are O(1) expected plus the number of candidates.
+class TitleIndex {
+private:
+    std::unordered_multimap<uint64_t, int> ids;
+
+    static uint64_t hashOf(const std::string& title) {
+        return std::hash<std::string>()(title);
+    }
+
+public:
+    void add(const std::string& title, int id) {
+        ids.emplace(hashOf(title), id);
+    }
+
+    void remove(const std::string& title, int id) {
+        auto range = ids.equal_range(hashOf(title));
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == id) {
+                ids.erase(it);
+                return;
+            }
+        }
+    }
+
+    void reserve(size_t count) {
+        ids.reserve(count);
+    }
+
+    void clear() {
+        ids.clear();
+    }
+
+    // Calls visit(id) for every id whose title may equal `title`
+    template <class Visit>
+    void forEachCandidate(const std::string& title, Visit visit) const {
+        auto range = ids.equal_range(hashOf(title));
+        for (auto it = range.first; it != range.second; ++it) visit(it->second);
+    }
+
+    // Nodes (next pointer, key, id) plus the bucket array
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        const size_t nodeBytes = sizeof(void*) + sizeof(std::pair<const uint64_t, int>);
+        usage.structBytes = sizeof(ids) + ids.size() * nodeBytes + ids.bucket_count() * sizeof(void*);
+        usage.allocations = ids.size() + 1;
+        usage.overheadBytes = ids.size() * allocationOverhead(nodeBytes) + allocationOverhead(ids.bucket_count() * sizeof(void*));
+        return usage;
+    }
+};
@@ -0,0 +1,117 @@
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "task_manager.hpp"
+#include "task_server.hpp"
+#include "task_client.hpp"
+using namespace std;
+
+// ------------------ todod ------------------
+// Hosts one TaskManager for any number of CLI, GUI and script clients on a
+// Unix socket (task_protocol.hpp), so they share one task set and skip the
+// cold start. It also keeps a read-only snapshot of the tasks in shared
+// memory (task_snapshot.hpp) that readers use without asking the daemon.
+// The tasks live in memory until the daemon exits.
+//
+// With --follow it is a hot standby instead: it tails the log of the daemon
+// at PRIMARY (task_replication.hpp), serves read-only queries on its own
+// socket, and takes changes once SIGUSR1 promotes it.
+//
+// Usage: todod [--socket PATH] [--threads N] [--follow PRIMARY]
+//              [--snapshot NAME | --no-snapshot] [--snapshot-mb N] [--publish-ms N]
+// SIGINT or SIGTERM shuts it down and removes the socket and the snapshot.
+
+static TaskServer* runningServer = nullptr;
+
+extern "C" void onStopSignal(int) {
+    if (runningServer != nullptr) runningServer->stop();
+}
+
+extern "C" void onPromoteSignal(int) {
+    if (runningServer != nullptr) runningServer->promote();
+}
+
+int main(int argc, char** argv) {
+    string socketPath = defaultSocketPath();
+    string snapshotName = defaultSnapshotName();
+    string primaryPath;
+    bool snapshotChosen = false;
+    unsigned threads = 1;
+    size_t snapshotMb = 256;            // per table slot; tmpfs only backs what is written
+    int publishMs = 100;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socketPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--follow") == 0 && i + 1 < argc) {
+            primaryPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            snapshotName = argv[++i];
+            snapshotChosen = true;
+        }
+        else if (strcmp(argv[i], "--no-snapshot") == 0) {
+            snapshotName.clear();
+            snapshotChosen = true;
+        }
+        else if (strcmp(argv[i], "--snapshot-mb") == 0 && i + 1 < argc) {
+            snapshotMb = max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--publish-ms") == 0 && i + 1 < argc) {
+            publishMs = max(0, atoi(argv[++i]));
+        }
+        else {
+            cerr << "Usage: todod [--socket PATH] [--threads N] [--follow PRIMARY]\n"
+                 << "             [--snapshot NAME | --no-snapshot] [--snapshot-mb N] [--publish-ms N]\n";
+            return 2;
+        }
+    }
+
+    // The default snapshot name belongs to the primary
+    if (!primaryPath.empty() && !snapshotChosen) snapshotName.clear();
+
+    // Requests run on the event loop; the pool only splits large queries
+    TaskManager manager;
+    manager.setThreadCount(threads);
+    TaskServer server(manager);
+    if (!server.listen(socketPath)) {
+        cerr << "todod: cannot listen on " << socketPath << ": " << strerror(errno) << '\n';
+        return 1;
+    }
+    if (!primaryPath.empty() && !server.follow(primaryPath)) {
+        cerr << "todod: cannot follow " << primaryPath << ": " << strerror(errno) << '\n';
+        return 1;
+    }
+    SnapshotWriter snapshot;
+    if (!snapshotName.empty()) {
+        if (!snapshot.create(snapshotName, snapshotMb << 20)) {
+            cerr << "todod: cannot create snapshot " << snapshotName << ": " << strerror(errno) << '\n';
+            return 1;
+        }
+        server.setSnapshot(&snapshot, chrono::milliseconds(publishMs));
+    }
+
+    runningServer = &server;
+    signal(SIGINT, onStopSignal);
+    signal(SIGTERM, onStopSignal);
+    signal(SIGUSR1, onPromoteSignal);
+    signal(SIGPIPE, SIG_IGN);
+    cerr << "todod: listening on " << socketPath;
+    if (!primaryPath.empty()) cerr << ", following " << primaryPath << " (read-only until SIGUSR1)";
+    if (!snapshotName.empty()) cerr << ", snapshot " << snapshotName;
+    cerr << endl;
+
+    server.run();
+
+    runningServer = nullptr;
+    const TaskServer::Stats& stats = server.getStats();
+    cerr << "todod: stopped after " << stats.connections << " connections, " << stats.frames
+         << " frames, " << stats.commands << " commands";
+    if (stats.recordsApplied > 0) cerr << ", " << stats.recordsApplied << " log records replayed";
+    cerr << endl;
+    return 0;
+}
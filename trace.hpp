@@ -0,0 +1,157 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// ------------------ Trace Spans ------------------
+// Scoped spans recorded into a fixed-size lock-free ring buffer and dumped
+// as Chrome/Perfetto trace-event JSON (open in chrome://tracing or ui.perfetto.dev).
+// Build with TODO_ENABLE_TRACE defined to compile the TRACE_SCOPE macros in.
+
+struct TraceEvent {
+    const char* name;           // must point at a string literal, never copied
+    const char* category;
+    uint64_t startUs;
+    uint64_t durationUs;        // counter value for counter events
+    uint32_t threadId;
+    char phase;                 // 'X' complete span, 'C' counter sample
+};
+
+class TraceBuffer {
+private:
+    static const uint64_t CAPACITY = 1 << 16;   // power of two so the index wraps with a mask
+
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};      // claim index + 1 once the slot is fully written
+        TraceEvent event;
+    };
+
+    Slot slots[CAPACITY];
+    std::atomic<uint64_t> writeIndex{0};
+    std::atomic<bool> enabled{true};
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    TraceBuffer() {}
+
+public:
+    static TraceBuffer& instance() {
+        static TraceBuffer buffer;
+        return buffer;
+    }
+
+    uint64_t nowUs() const {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    static uint32_t currentThreadId() {
+        static std::atomic<uint32_t> nextId{1};
+        thread_local uint32_t id = nextId++;
+        return id;
+    }
+
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+
+    // Writers never block each other: each claims its own slot with fetch_add.
+    // When the ring wraps the oldest spans are overwritten.
+    void record(const char* name, const char* category, uint64_t startUs, uint64_t endUs) {
+        uint64_t index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = slots[index & (CAPACITY - 1)];
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.event = TraceEvent{name, category, startUs, endUs - startUs, currentThreadId(), 'X'};
+        slot.sequence.store(index + 1, std::memory_order_release);
+    }
+
+    // A counter sample shows up as its own graph track in the trace viewer
+    void recordCounter(const char* name, const char* category, uint64_t value) {
+        if (!isEnabled()) return;
+        uint64_t index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = slots[index & (CAPACITY - 1)];
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.event = TraceEvent{name, category, nowUs(), value, currentThreadId(), 'C'};
+        slot.sequence.store(index + 1, std::memory_order_release);
+    }
+
+    void clear() {
+        for (auto& slot : slots) slot.sequence.store(0, std::memory_order_relaxed);
+        writeIndex.store(0, std::memory_order_relaxed);
+    }
+
+    // Writes whatever is currently in the ring. Slots still being written
+    // (or already overwritten by a newer span) are skipped.
+    bool dumpChromeJson(const std::string& path) const {
+        FILE* out = fopen(path.c_str(), "w");
+        if (!out) return false;
+
+        uint64_t end = writeIndex.load(std::memory_order_acquire);
+        uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+
+        fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", out);
+        bool first = true;
+        for (uint64_t i = begin; i < end; i++) {
+            const Slot& slot = slots[i & (CAPACITY - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != i + 1) continue;
+            TraceEvent event = slot.event;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) != i + 1) continue;
+
+            if (event.phase == 'C') {
+                fprintf(out, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"C\",\"ts\":%llu,\"pid\":1,\"tid\":%u,\"args\":{\"value\":%llu}}",
+                        first ? "" : ",\n", event.name, event.category,
+                        (unsigned long long)event.startUs, event.threadId,
+                        (unsigned long long)event.durationUs);
+            }
+            else {
+                fprintf(out, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":1,\"tid\":%u}",
+                        first ? "" : ",\n", event.name, event.category,
+                        (unsigned long long)event.startUs, (unsigned long long)event.durationUs,
+                        event.threadId);
+            }
+            first = false;
+        }
+        fputs("\n]}\n", out);
+        return fclose(out) == 0;
+    }
+};
+
+class ScopedTrace {
+private:
+    const char* name;
+    const char* category;
+    uint64_t startUs;
+
+public:
+    ScopedTrace(const char* _name, const char* _category)
+        : name(_name), category(_category), startUs(0) {
+        if (TraceBuffer::instance().isEnabled())
+            startUs = TraceBuffer::instance().nowUs();
+        else
+            name = nullptr;
+    }
+
+    ~ScopedTrace() {
+        if (name) {
+            TraceBuffer& buffer = TraceBuffer::instance();
+            buffer.record(name, category, startUs, buffer.nowUs());
+        }
+    }
+
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef TODO_ENABLE_TRACE
+#define TRACE_SCOPE(category, name) ScopedTrace TRACE_CONCAT(traceScope_, __LINE__)(name, category)
+#define TRACE_COUNTER(category, name, value) TraceBuffer::instance().recordCounter(name, category, value)
+#else
+#define TRACE_SCOPE(category, name) ((void)0)
+#define TRACE_COUNTER(category, name, value) ((void)0)
+#endif
@@ -0,0 +1,165 @@
+#pragma once
+#include "batch_renderer.hpp"
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// ------------------ Widget ------------------
+// A clickable button. Widgets are created once and kept; showing, hiding and
+// greying one out flips a flag instead of rebuilding it.
+struct Widget {
+    sf::FloatRect area;
+    GlyphRun caption;
+    sf::Vector2f captionPosition;
+    std::function<void()> onClick;
+    sf::Color color;
+    bool visible = true;
+    bool enabled = true;
+
+    Widget(const std::string& label, const sf::Vector2f& size, const sf::Vector2f& position,
+           const sf::Font& font, const sf::Color& _color)
+        : area(position, size), color(_color) {
+        layoutGlyphRun(caption, font, label, 14, sf::Color::White);
+        captionPosition = sf::Vector2f(         // centred in the button
+            position.x + (size.x - caption.bounds.width) / 2,
+            position.y + (size.y - caption.bounds.height) / 2
+        );
+    }
+
+    bool clickable() const { return visible && enabled && onClick; }
+
+    void draw(BatchRenderer& batch) const {
+        if (!visible) return;
+        batch.rect(area.left, area.top, area.width, area.height, enabled ? color : sf::Color(150, 150, 150));
+        batch.glyphs(caption, captionPosition.x, captionPosition.y);
+    }
+};
+
+// ------------------ HitGrid ------------------
+// Uniform grid over the window; each cell lists the widgets overlapping it,
+// packed into one array (cellStart[c] .. cellStart[c + 1]). A click tests only
+// the widgets of its own cell, so its cost does not grow with the widget
+// count, and a lookup never allocates. Rebuilt only when a layout changes.
+class HitGrid {
+private:
+    static const int CELL_SIZE = 32;
+
+    int columns = 0;
+    int rows = 0;
+    std::vector<uint32_t> cellStart;
+    std::vector<uint32_t> entries;
+
+    int column(float x) const { return std::clamp(int(x) / CELL_SIZE, 0, columns - 1); }
+    int row(float y) const { return std::clamp(int(y) / CELL_SIZE, 0, rows - 1); }
+
+    template <typename Visit>
+    void forEachCell(const sf::FloatRect& area, Visit visit) const {
+        int right = column(area.left + area.width - 1), bottom = row(area.top + area.height - 1);
+        for (int r = row(area.top); r <= bottom; r++) {
+            for (int c = column(area.left); c <= right; c++) visit(r * columns + c);
+        }
+    }
+
+public:
+    HitGrid(unsigned int width, unsigned int height)
+        : columns(int(width + CELL_SIZE - 1) / CELL_SIZE),
+          rows(int(height + CELL_SIZE - 1) / CELL_SIZE),
+          cellStart(size_t(columns) * rows + 1, 0) {}
+
+    // Two passes (count, then fill) so each cell's entries end up contiguous
+    void rebuild(const std::vector<Widget>& widgets) {
+        std::fill(cellStart.begin(), cellStart.end(), 0);
+        for (const Widget& widget : widgets) {
+            forEachCell(widget.area, [&](int cell) { cellStart[cell + 1]++; });
+        }
+        for (size_t i = 1; i < cellStart.size(); i++) cellStart[i] += cellStart[i - 1];
+
+        entries.assign(cellStart.back(), 0);
+        std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+        for (uint32_t i = 0; i < widgets.size(); i++) {
+            forEachCell(widgets[i].area, [&](int cell) { entries[fill[cell]++] = i; });
+        }
+    }
+
+    // Index of the clickable widget under (x, y), or -1
+    int hit(const std::vector<Widget>& widgets, int x, int y) const {
+        if (x < 0 || y < 0 || x >= columns * CELL_SIZE || y >= rows * CELL_SIZE) return -1;
+        int cell = row(float(y)) * columns + column(float(x));
+        for (uint32_t k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+            const Widget& widget = widgets[entries[k]];
+            if (widget.clickable() && widget.area.contains(float(x), float(y))) return int(entries[k]);
+        }
+        return -1;
+    }
+};
+
+// ------------------ WidgetTree ------------------
+// Two layers of retained widgets: the stable layer (sidebar, undo/redo) is
+// built once at startup, the contextual layer (actions on the selected task)
+// is dropped and rebuilt on each selection. The contextual layer is drawn
+// later, so it wins clicks where the two overlap.
+//
+// Handlers run by reference, not copied. A handler may clear the contextual
+// layer it belongs to: the cleared widgets are parked in `retired` (a vector
+// swap, so the running handler does not move) until the handler returns.
+class WidgetTree {
+private:
+    std::vector<Widget> stable;
+    std::vector<Widget> contextual;
+    std::vector<Widget> retired;
+    HitGrid stableGrid;
+    HitGrid contextualGrid;
+    bool dispatching = false;
+
+public:
+    WidgetTree(unsigned int width, unsigned int height)
+        : stableGrid(width, height), contextualGrid(width, height) {}
+
+    // Index of the new widget in the stable layer
+    size_t addStable(Widget widget) {
+        stable.push_back(std::move(widget));
+        stableGrid.rebuild(stable);
+        return stable.size() - 1;
+    }
+
+    // Add a set of contextual widgets, then publish them with commitContext()
+    void addContextual(Widget widget) { contextual.push_back(std::move(widget)); }
+    void commitContext() { contextualGrid.rebuild(contextual); }
+
+    void clearContext() {
+        if (dispatching && !retired.empty()) {
+            contextual.clear();             // the running handler is already parked or stable
+        }
+        else {
+            retired.clear();
+            contextual.swap(retired);
+            if (!dispatching) retired.clear();
+        }
+        contextualGrid.rebuild(contextual);
+    }
+
+    Widget& stableAt(size_t i) { return stable[i]; }
+    size_t stableCount() const { return stable.size(); }
+    const std::vector<Widget>& stableWidgets() const { return stable; }
+    const std::vector<Widget>& contextualWidgets() const { return contextual; }
+
+    // Runs the handler of the widget under (x, y). Returns false if there was none.
+    bool click(int x, int y) {
+        const std::vector<Widget>* layer = &contextual;
+        int index = contextualGrid.hit(contextual, x, y);
+        if (index < 0) {
+            layer = &stable;
+            index = stableGrid.hit(stable, x, y);
+        }
+        if (index < 0) return false;
+
+        dispatching = true;
+        (*layer)[index].onClick();
+        dispatching = false;
+        retired.clear();
+        return true;
+    }
+};